@@ -82,6 +82,10 @@ ABSL_FLAG(bool, place_leaves_close, false,
           "Setting this option will place the child vertices very near the "
           "parent vertex if all of its children have none themselves.");
 
+ABSL_FLAG(uint64_t, seed, 1,
+          "Seed for the random placement and noise. The same seed and "
+          "thread count give the same layout.");
+
 ABSL_FLAG(int, log_threshold, 1,
           "Minimum threshold for logging. The numbers of severity levels INFO, "
           "WARNING, ERROR, and FATAL are 0, 1, 2, and 3, respectively. "
@@ -117,6 +121,7 @@ int main(int argc, char *argv[]) {
       .outer_radius = absl::GetFlag(FLAGS_outer_radius),
       .write_interval = absl::GetFlag(FLAGS_write_interval),
       .root_node = absl::GetFlag(FLAGS_root_node),
+      .seed = absl::GetFlag(FLAGS_seed),
   };
 
   lgl::lib_v2::LayoutRunner layout_runner(config);
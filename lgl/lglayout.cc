@@ -20,6 +20,7 @@
 //
 
 #include <assert.h>
+#include <getopt.h>
 #include <pthread.h>
 #include <unistd.h>
 
@@ -28,13 +29,15 @@
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <string>
 
 #include "lgl/lib/calc_funcs.h"
 #include "lgl/lib/configs.h"
+#include "lgl/lib/csr_graph.h"
 #include "lgl/lib/cube.h"
 #include "lgl/lib/grid.h"
 #include "lgl/lib/io.h"
-#include "lgl/lib/particle.h"
+#include "lgl/lib/particle_container.h"
 #include "lgl/lib/particle_interaction_handler.h"
 #include "lgl/lib/voxel.h"
 #include "lgl/lib/voxel_interaction_handler.h"
@@ -82,13 +85,26 @@ int main(int argc, char **argv) try {
   bool placeLeafsClose = false;
   bool isSilent = false;  // Show progress
   bool disregardDisconnectedNodes = false;
+  prec_t farFieldStrength = 0;  // Off
+  prec_t openingAngle = .8;
+  bool multilevel = false;
+  bool sparseGrid = false;
+  int reorderInterval = 0;  // Off
+  Integrator integrator = Integrator::kFirstOrder;
+  unsigned long seed = 1;
+  ConvergenceMonitor convergence;
 
   timer.max(MAXITER);
   timer.time_step(PART_TIME_STEP);
 
-  while ((optch = getopt(argc, argv,
-                         "x:a:t:m:M:i:s:r:k:T:R:S:W:z:o:leOyu:v:Iq:E:L:D")) !=
-         -1) {
+  // The only long one
+  enum { kSeedOption = 256 };
+  const struct option longOptions[] = {
+      {"seed", required_argument, 0, kSeedOption}, {0, 0, 0, 0}};
+  while ((optch = getopt_long(
+              argc, argv,
+              "x:a:t:m:M:i:s:r:k:T:R:S:W:z:o:leOyu:v:Iq:E:L:Db:B:CHZ:g:c:w:n:",
+              longOptions, 0)) != -1) {
     switch (optch) {
       case 'x':
         initPosFile = strdup(optarg);
@@ -168,15 +184,59 @@ int main(int argc, char **argv) try {
       case 'D':
         disregardDisconnectedNodes = true;
         break;
+      case 'b':
+        farFieldStrength = atof(optarg);
+        break;
+      case 'B':
+        openingAngle = atof(optarg);
+        break;
+      case 'C':
+        multilevel = true;
+        break;
+      case 'H':
+        sparseGrid = true;
+        break;
+      case 'Z':
+        reorderInterval = atoi(optarg);
+        break;
+      case 'g':
+        integrator = parseIntegrator(optarg);
+        break;
+      case 'c': {
+        // criterion, or criterion:tolerance
+        const std::string criterion = optarg;
+        const std::string::size_type colon = criterion.find(':');
+        convergence.criterion(parseStopCriterion(criterion.substr(0, colon)));
+        if (colon != std::string::npos) {
+          convergence.tolerance(atof(criterion.c_str() + colon + 1));
+        }
+        break;
+      }
+      case 'w':
+        convergence.window(atoi(optarg));
+        break;
+      case 'n': {
+        // base, or base+perNode
+        char* perNode = 0;
+        const long base = strtol(optarg, &perNode, 10);
+        convergence.budget(base, *perNode == '+' ? atof(perNode + 1) : 0);
+        break;
+      }
+      case kSeedOption:
+        seed = strtoul(optarg, 0, 10);
+        break;
       default:
         std::cerr << "Bad option -\t" << (char)optch << '\n';
         exit(EXIT_FAILURE);
     }
   }
 
+  // For the placement; the noise has a generator of its own
+  std::srand(seed);
+
   std::cout << "Reading in Graph from " << argv[optind] << "..." << std::flush;
-  Graph<FloatType> G;
-  readLGL(G, argv[optind]);
+  CsrGraph<FloatType> G;
+  readGraph(G, argv[optind]);
   std::cout << "\nVertex Count: " << G.vertexCount() << '\n'
             << "Edge Count: " << G.edgeCount() << std::endl;
 
@@ -193,7 +253,6 @@ int main(int argc, char **argv) try {
   // Initialize the ids of the nodes
   for (NodeContainer::size_type ii = 0; ii < nodes.size(); ++ii) {
     nodes.ids[ii] = G.idFromIndex(ii);
-    nodes[ii].id(G.idFromIndex(ii));
   }
 
   // This determines the space necessary to place all the nodes.
@@ -231,13 +290,13 @@ int main(int argc, char **argv) try {
   if (initPosFile) {
     // without this call the_internet's results become unacceptably stretched
     // and ugly
-    interpolateUninitializedPositions(chaperone, G.boostGraph(),
-                                      disregardDisconnectedNodes);
+    interpolateUninitializedPositions(chaperone, G, disregardDisconnectedNodes);
   }
   std::cout << "Done." << std::endl;
 
   std::cout << "Initializing grid and placing particles..." << std::flush;
   Grid_t grid;
+  grid.sparse(sparseGrid);
   prec_t voxelLength = nbhdRadius;
   gridPrepAndInit(nodes, grid, voxelLength);
   std::cout << "Done." << std::endl;
@@ -248,57 +307,75 @@ int main(int argc, char **argv) try {
   NodeInteractionHandler nh;
   nh.timeStep(timer.time_step());
   nh.noiseAmplitude(1.0);
+  nh.integrator(integrator);
+  nh.noiseSeed(seed);
   GridSchedule_t schedule(grid);
   bool acceptable = schedule.threads(processorCount);
   long threadCount = schedule.threads();
   while (!acceptable) {
     acceptable = schedule.threads(--threadCount);
   }
-  schedule.generateVoxelList_MT();
+  grid.threads(threadCount);
   std::cout << "Done." << std::endl;
 
   // First generate the tree to guide the layout
   unsigned int totalLevels = 1;
   LevelMap levels(nodes.size(), 1);
   ParentMap parents(nodes.size(), 0);
-  Graph<FloatType> lG;  // The graph that is currently being treated
-  lG.vertexIdMap(G.vertexIdMap());
-  Graph<FloatType> mst;  // The tree generated to guide the layout
-  mst.vertexIdMap(G.vertexIdMap());
-  mst.weights(G.weights());
-  Graph<FloatType>::vertex_descriptor root = 0;
+  // The part of the graph that is currently being treated
+  CsrGraphView<FloatType> lG;
+  CsrGraph<FloatType> coarseG;  // The coarse graph lG views, if any
+  CsrGraph<FloatType> mst;  // The tree generated to guide the layout
+  CsrGraph<FloatType>::vertex_descriptor root = 0;
+  GraphCoarsening coarsening;
+  if (multilevel && layoutTreeOnly) {
+    std::cerr << "-C and -y can't be used together. Exiting.\n";
+    exit(EXIT_FAILURE);
+  }
   if (!initPosFile) {
-    std::cout
-        << "Generating Tree and checking for root.\nChecking for root node ... "
-        << std::flush;
-    if (rootNode) {
-      // Use the provided root node
-      std::string r(rootNode);
-      root = G.indexFromId(r);
-      std::tie(root, totalLevels) = generateLevelsFromGraph(
-          G, levels, parents, &root, mst, useOriginalWeights);
+    if (multilevel) {
+      std::cout << "Coarsening the graph ... " << std::flush;
+      coarsening.build(G, 2);
+      totalLevels = setCoarseLevels(coarsening, levels, parents);
+      // Any vertex of the coarsest graph will do as the root
+      while (levels[root] != 1) ++root;
+      std::cout << "Done.\nThe coarsest graph has "
+                << coarsening.vertexCount(totalLevels - 1) << " vertices."
+                << std::endl;
     } else {
-      // Try to find the root node
-      std::tie(root, totalLevels) = generateLevelsFromGraph(
-          G, levels, parents, (Graph<FloatType>::vertex_descriptor *)0, mst,
-          useOriginalWeights);
+      std::cout << "Generating Tree and checking for root.\nChecking for root "
+                   "node ... "
+                << std::flush;
+      if (rootNode) {
+        // Use the provided root node
+        std::string r(rootNode);
+        root = G.indexFromId(r);
+        std::tie(root, totalLevels) = generateLevelsFromGraph(
+            G, levels, parents, &root, mst, useOriginalWeights, threadCount);
+      } else {
+        // Try to find the root node
+        std::tie(root, totalLevels) = generateLevelsFromGraph(
+            G, levels, parents, (CsrGraph<FloatType>::vertex_descriptor *)0,
+            mst, useOriginalWeights, threadCount);
+      }
     }
     std::cout << "Root Node: " << G.idFromIndex(root) << "\n"
               << "There are " << totalLevels << " levels." << std::endl;
     // Place root in graph
-    shift_particle(nodes[root], grid);
+    shift_particle(nodes, root, grid);
     for (NodeContainer::size_type ii = 0; ii < nodes.size(); ++ii) {
       if (root != ii) {
-        if (nodes[ii].isAnchor())
-          shift_particle(nodes[ii], grid);  // Place anchor in graph
+        if (nodes.isAnchor(ii))
+          shift_particle(nodes, ii, grid);  // Place anchor in graph
         else
-          nodes[ii].X(1e6);  // Put everything else in some crazy place (pretty
+          nodes.X(ii, 1e6);  // Put everything else in some crazy place (pretty
                              // helpful for finding bugs)
       }
     }
   } else {
     std::cout << "Coords provided, skipping Tree Generation.\n";
-    lG = G;  // Give the full graph, counting all interactions
+    // Give the full graph, counting all interactions
+    lG = CsrGraphView<FloatType>(G);
   }
 
   // Do we want to overwrite the given graph with the layout tree
@@ -307,8 +384,11 @@ int main(int argc, char **argv) try {
     G = mst;
     // placeLeafsClose = true;
     std::tie(root, totalLevels) = generateLevelsFromGraph(
-        G, levels, parents, &root, mst, useOriginalWeights);
+        G, levels, parents, &root, mst, useOriginalWeights, threadCount);
   }
+  // The vertices by level, to take them on one level at a time
+  LevelIndex levelIndex;
+  if (!initPosFile) levelIndex = LevelIndex(G, levels, parents);
 
   // This levelmap outputs which 'level' each edge is on. The
   // level is determined as the hop number from the root node.
@@ -345,19 +425,22 @@ int main(int argc, char **argv) try {
   threads.defaultThread.scope(PTHREAD_SCOPE_SYSTEM);
   threads.applyAttributes();
   ThreadArgs *threadArgs = new ThreadArgs[threadCount];
+  LayoutEdges_t layoutEdges;
+  BarnesHutTree_t farField;
+  farField.strength(farFieldStrength);
+  farField.theta(openingAngle);
+  farField.cutoff(nbhdRadius);
   for (long threadCtr = 0; threadCtr < threadCount; ++threadCtr) {
     ThreadArgs &current = threadArgs[threadCtr];
     current.nodes = &nodes;
     current.eqDistance = eqDistance;
     current.ellipseFactors = ellipseFactors;
     current.grid = &grid;
+    current.schedule = &schedule;
+    current.escapes = 0;
     current.nbhdRadius = nbhdRadius;
     current.threadCount = threadCount;
-    current.voxelList = new FixedVec_l[grid.size() / threadCount + 1];
-    current.voxelListSize = schedule.getVoxelList(threadCtr, current.voxelList);
     current.whichThread = threadCtr;
-    current.gridIterator = new GridIterator(grid);
-    current.gridIterator->id(threadCtr);
     current.stats = new ParticleStats_t();
     current.casualSpringConstant = casualSpringConstant;
     current.specialSpringConstant = specialSpringConstant;
@@ -366,15 +449,25 @@ int main(int argc, char **argv) try {
     current.nodeHandler->id(threadCtr);
     current.nodeHandler->forceLimit(.1 * voxelLength /
                                     static_cast<prec_t>(timer.time_step()));
-    current.nodeHandler->eqDistance(eqDistance);
     current.nodeHandler->ellipseFactors(ellipseFactors);
+    current.edgeHandler = new NodeInteractionHandler(*(current.nodeHandler));
+    current.edgeHandler->springConstant(specialSpringConstant);
+    current.edgeHandler->eqDistance(eqDistance);
+    current.nodeHandler->springConstant(casualSpringConstant);
+    current.nodeHandler->eqDistance(nbhdRadius);
     current.voxelHandler = new VoxelHandler(vh);
     current.voxelHandler->id(threadCtr);
     current.voxelHandler->interactionHandler(*(current.nodeHandler));
+    current.voxelHandler->particleContainer(nodes);
     current.full_graph = &G;
     current.layout_graph = &lG;
+    current.coarse_graph = &coarseG;
+    current.layoutEdges = &layoutEdges;
+    current.farField = farFieldStrength > 0 ? &farField : 0;
+    current.coarsening = multilevel && !initPosFile ? &coarsening : 0;
     current.levels = &levels;
     current.parents = &parents;
+    current.levelIndex = initPosFile ? 0 : &levelIndex;
   }
   std::cout << "Done." << std::endl;
 
@@ -382,19 +475,19 @@ int main(int argc, char **argv) try {
   if (initPosFile != 0) {
     givenCoords = true;
     for (NodeContainer::size_type ii = 0; ii < nodes.size(); ++ii) {
-      shift_particle(nodes[ii], grid);
+      shift_particle(nodes, ii, grid);
     }
   }
 
   beginSimulation(threads, cutOffPrecision, timer, threadArgs, chaperone,
                   totalLevels, givenCoords, placementDistance, placementRadius,
-                  placeLeafsClose, isSilent);
+                  placeLeafsClose, isSilent, reorderInterval, convergence);
   // Final settle
   cutOffPrecision *= .1;
   std::cerr << "\nFinal Settle\n";
   beginSimulation(threads, cutOffPrecision, timer, threadArgs, chaperone,
                   totalLevels, true, placementDistance, placementRadius,
-                  placeLeafsClose, isSilent);
+                  placeLeafsClose, isSilent, reorderInterval, convergence);
 
   chaperone.posOutFile(outfile);
   chaperone.writeOutFiles();
@@ -465,7 +558,12 @@ void displayUsage(char **argv) {
       << "\n\t[-s] [-r nbhdRadius] [-T timeStep] [-S nodeSizeRadius]\n"
       << "\t[-k casualSpringConstant] [-s specialSpringConstant]\n"
       << "\t[-e] [-l] [-y] [-q EQ Distance] [-u placementDistance]\n"
-      << "\t[-E ellipseFactors] [-v placementRadius] [-L] nodeFile.lgl\n\n";
+      << "\t[-E ellipseFactors] [-v placementRadius] [-L]\n"
+      << "\t[-b farFieldStrength] [-B openingAngle] [-C] [-H]\n"
+      << "\t[-Z reorderInterval] [-g integrator] [--seed seed]\n"
+      << "\t[-c criterion[:tolerance]] [-w window] [-n base[+perNode]]\n"
+      << "\tnodeFile.lgl\n\n"
+      << "\tnodeFile may also be a binary graph from lglfileconvert.\n";
   std::cerr << "\n\t-[mx]\t A file that has the node id followed by\n"
             << "\t\tthe initial values.\n";
   std::cerr << "\n\t-t\tThe number of threads to spawn.\n"
@@ -498,6 +596,31 @@ void displayUsage(char **argv) {
       << "\t\tgraphs. Setting this option will place the child vertices very\n"
       << "\t\tnear the parent vertex if all of its children have none "
          "themselves.\n";
+  std::cerr
+      << "\n\t-b\tStrength of a long-range repulsion between all nodes,\n"
+      << "\t\tbeyond the neighborhood radius. 0 (off) by default.\n";
+  std::cerr << "\n\t-B\tOpening angle of the long-range repulsion. Smaller\n"
+            << "\t\tis more accurate but slower. 0.8 by default.\n";
+  std::cerr << "\n\t-C\tMultilevel layout. Lays out ever finer coarsenings\n"
+            << "\t\tof the graph instead of the levels of a tree.\n";
+  std::cerr << "\n\t-H\tSparse grid. Only keeps the occupied voxels, in a\n"
+            << "\t\thash table, for layouts that are mostly empty space.\n";
+  std::cerr << "\n\t-Z\tRenumber the nodes along a space filling curve every\n"
+            << "\t\tso many iterations, for cache locality. 0 (off) by\n"
+            << "\t\tdefault.\n";
+  std::cerr << "\n\t-g\tIntegrator: first (first order, the default), verlet\n"
+            << "\t\t(with damped momentum) or fire (adaptive steps).\n";
+  std::cerr << "\n\t-c\tWhat tells that a level has settled: edge (the mean\n"
+            << "\t\tedge length, the default), move (the longest move)\n"
+            << "\t\tor force (the mean squared force), optionally with\n"
+            << "\t\ta tolerance as in move:0.01.\n";
+  std::cerr << "\n\t-w\tHow many iterations the criterion is averaged over.\n"
+            << "\t\t2 by default.\n";
+  std::cerr << "\n\t-n\tIteration budget of a level, as base or base+perNode\n"
+            << "\t\tfor a budget that grows with the nodes the level\n"
+            << "\t\tadds. 150 by default.\n";
+  std::cerr << "\n\t--seed\tSeed for the random placement and noise. The same\n"
+            << "\t\tseed and thread count give the same layout. 1 by default.\n";
   std::cerr << "\n";
   exit(EXIT_FAILURE);
 }
@@ -110,7 +110,7 @@ int main(int argc, char** argv) {
 
   std::cerr << "Loading " << infile << "..." << std::flush;
   Graph<FloatType> G;
-  readLGL(G, infile, cut);
+  readGraph(G, infile, cut);
   std::cerr << "Done." << std::endl;
 
   int vertexCount = G.vertexCount();
@@ -1,7 +1,9 @@
 /////////////////////////////////////////////////////////////////////////
 
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <string>
 
 #include "lgl/lib/graph.h"
 #include "lgl/lib/io.h"
@@ -14,6 +16,32 @@ void usage(char** a);
 
 /////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+enum FileType { kUnknown, kLGL, kNCOL, kBinary };
+
+const char* const kSuffixes[] = {"", ".lgl", ".ncol", ".lglb"};
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+FileType fileType(const std::string& file) {
+  if (endsWith(file, ".lglb")) return kBinary;
+  if (endsWith(file, ".lgl")) return kLGL;
+  if (endsWith(file, ".ncol")) return kNCOL;
+  // Anywhere in the name, as in graph.lgl.old
+  if (file.find(".lglb") != std::string::npos) return kBinary;
+  if (file.find(".lgl") != std::string::npos) return kLGL;
+  if (file.find(".ncol") != std::string::npos) return kNCOL;
+  return kUnknown;
+}
+
+}  // namespace
+
+/////////////////////////////////////////////////////////////////////////
+
 int main(int argc, char** argv) {
   // There is just one input arg,
   // a file name with all the connections.
@@ -22,31 +50,37 @@ int main(int argc, char** argv) {
   std::string infile = argv[1];
   std::string outfile = argv[2];
 
+  // A text file of unknown type is the other text type
+  FileType in = fileType(infile);
+  FileType out = fileType(outfile);
+  if (in == kUnknown && out != kBinary) in = out == kLGL ? kNCOL : kLGL;
+  if (out == kUnknown && in != kBinary) out = in == kLGL ? kNCOL : kLGL;
+  if (in == kUnknown || out == kUnknown || in == out) {
+    std::cerr << "Could not determine file types.\n";
+    return EXIT_SUCCESS;
+  }
+
   Graph<float> g;
 
-  if ((infile.find(".ncol") != std::string::npos &&
-       infile.find(".lgl") == std::string::npos) ||
-      (outfile.find(".lgl") != std::string::npos &&
-       outfile.find(".ncol") == std::string::npos)) {
-    std::cerr << "Converting .ncol file ---> .lgl file\n";
-    std::cerr << "Loading " << infile << "..." << std::flush;
+  std::cerr << "Converting " << kSuffixes[in] << " file ---> "
+            << kSuffixes[out] << " file\n";
+  std::cerr << "Loading " << infile << "..." << std::flush;
+  if (in == kNCOL) {
     readNCOL(g, infile.c_str());
-    std::cerr << " Done.\nWriting " << outfile << "..." << std::flush;
-    writeLGL(g, outfile.c_str());
-    std::cerr << " Done.\n";
-  } else if ((infile.find(".lgl") != std::string::npos &&
-              infile.find(".ncol") == std::string::npos) ||
-             (outfile.find(".ncol") != std::string::npos &&
-              outfile.find(".lgl") == std::string::npos)) {
-    std::cerr << "Converting .lgl file ---> .ncol file\n";
-    std::cerr << "Loading " << infile << "..." << std::flush;
+  } else if (in == kLGL) {
     readLGL(g, infile.c_str());
-    std::cerr << " Done.\nWriting " << outfile << "..." << std::flush;
+  } else {
+    readBinaryGraph(g, infile.c_str());
+  }
+  std::cerr << " Done.\nWriting " << outfile << "..." << std::flush;
+  if (out == kNCOL) {
     writeNCOL(g, outfile.c_str());
-    std::cerr << " Done.\n";
+  } else if (out == kLGL) {
+    writeLGL(g, outfile.c_str());
   } else {
-    std::cerr << "Could not determine file types.\n";
+    writeBinaryGraph(g, outfile.c_str());
   }
+  std::cerr << " Done.\n";
 
   return EXIT_SUCCESS;
 }
@@ -54,6 +88,9 @@ int main(int argc, char** argv) {
 void usage(char** argv) {
   std::cerr << "\n Usage:\n\t" << argv[0]
             << " infile.ncol outfile.lgl\n\n\tOR\n\n\t";
-  std::cerr << argv[0] << " infile.lgl outfile.ncol\n\n";
+  std::cerr << argv[0] << " infile.lgl outfile.ncol\n\n\tOR\n\n\t";
+  std::cerr << argv[0] << " infile.[lgl|ncol] outfile.lglb\n\n";
+  std::cerr << "\t.lglb is a binary graph that lglayout and lglbreakup\n"
+            << "\tread without parsing. It converts back as well.\n\n";
   exit(EXIT_FAILURE);
 }
@@ -32,7 +32,6 @@
 #include "lgl/lib/ed_lookup_table.h"
 #include "lgl/lib/grid.h"
 #include "lgl/lib/molecule.h"
-#include "lgl/lib/particle.h"
 #include "lgl/lib/sphere.h"
 #include "lgl/lib/voxel.h"
 #include "lgl/lib/voxel_interaction_handler.h"
@@ -0,0 +1,388 @@
+#include "barnes_hut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "parallel_chunks.h"
+
+namespace lgl {
+namespace lib {
+
+template <Dimension D>
+void BarnesHutTree<D>::build(const ParticleContainer<D>& pc) {
+  cells_.clear();
+  index_.clear();
+  for (size_type i = 0; i < pc.size(); ++i) {
+    if (pc.container(i) >= 0) index_.push_back(i);
+  }
+  scratch_.resize(index_.size());
+  if (index_.empty()) return;
+
+  Cell root;
+  FloatType half = 0;
+  for (unsigned int d = 0; d < D; ++d) {
+    FloatType lo = pc.x(index_[0], d), hi = lo;
+    for (size_type i : index_) {
+      lo = std::min(lo, pc.x(i, d));
+      hi = std::max(hi, pc.x(i, d));
+    }
+    root.center[d] = (lo + hi) * FloatType(.5);
+    half = std::max(half, (hi - lo) * FloatType(.5));
+  }
+  // A little slack, so nothing sits right on the far boundary
+  root.half = half * FloatType(1.001) + FloatType(1e-6);
+  root.begin = 0;
+  root.end = index_.size();
+  root.firstChild = -1;
+  cells_.push_back(root);
+  root = split(pc, cells_, root, 0);
+  cells_[0] = root;
+
+  mass_.resize(index_.size());
+  for (unsigned int d = 0; d < D; ++d) x_[d].resize(index_.size());
+  for (size_type k = 0; k < index_.size(); ++k) {
+    mass_[k] = pc.mass(index_[k]);
+    for (unsigned int d = 0; d < D; ++d) x_[d][k] = pc.x(index_[k], d);
+  }
+}
+
+template <Dimension D>
+void BarnesHutTree<D>::build(const ParticleContainer<D>& pc,
+                             unsigned int whichThread,
+                             unsigned int threadCount, spin_barrier& barrier) {
+  const bool leader = whichThread == 0;
+  if (threadCount == 1 || pc.size() < kSerialSize) {
+    if (leader) build(pc);
+    barrier.wait();
+    return;
+  }
+  if (leader) {
+    shares_.resize(threadCount);
+    bucket_.resize(pc.size());
+  }
+  barrier.wait();
+
+  // The box around the particles of each thread
+  Share& share = shares_[whichThread];
+  const size_type first = chunkStart(pc.size(), threadCount, whichThread);
+  const size_type last = chunkStart(pc.size(), threadCount, whichThread + 1);
+  share.count = 0;
+  for (unsigned int d = 0; d < D; ++d) {
+    share.lo[d] = std::numeric_limits<FloatType>::max();
+    share.hi[d] = std::numeric_limits<FloatType>::lowest();
+  }
+  for (size_type i = first; i < last; ++i) {
+    if (pc.container(i) < 0) continue;
+    ++share.count;
+    for (unsigned int d = 0; d < D; ++d) {
+      share.lo[d] = std::min(share.lo[d], pc.x(i, d));
+      share.hi[d] = std::max(share.hi[d], pc.x(i, d));
+    }
+  }
+  barrier.wait();
+
+  // Every thread works out the same root, as build does
+  size_type count = 0;
+  Cell root;
+  FloatType half = 0;
+  for (unsigned int t = 0; t < threadCount; ++t) count += shares_[t].count;
+  for (unsigned int d = 0; d < D; ++d) {
+    FloatType lo = shares_[0].lo[d], hi = shares_[0].hi[d];
+    for (unsigned int t = 1; t < threadCount; ++t) {
+      lo = std::min(lo, shares_[t].lo[d]);
+      hi = std::max(hi, shares_[t].hi[d]);
+    }
+    root.center[d] = (lo + hi) * FloatType(.5);
+    half = std::max(half, (hi - lo) * FloatType(.5));
+  }
+  root.half = half * FloatType(1.001) + FloatType(1e-6);
+  root.begin = 0;
+  root.end = count;
+  root.firstChild = -1;
+  if (count == 0) {
+    if (leader) {
+      cells_.clear();
+      index_.clear();
+    }
+    barrier.wait();
+    return;
+  }
+
+  // The buckets are the cells bucketDepth_ levels down
+  unsigned int bucketDepth = 1;
+  std::size_t bucketCount = kChildren;
+  while (bucketCount < kBucketsPerThread * threadCount) {
+    ++bucketDepth;
+    bucketCount *= kChildren;
+  }
+  share.buckets.assign(bucketCount, 0);
+  for (size_type i = first; i < last; ++i) {
+    if (pc.container(i) < 0) continue;
+    Cell c = root;
+    std::size_t b = 0;
+    for (unsigned int l = 0; l < bucketDepth; ++l) {
+      const unsigned int o = child(pc, c, i);
+      b = b * kChildren + o;
+      c = childCell(c, o);
+    }
+    bucket_[i] = b;
+    ++share.buckets[b];
+  }
+  barrier.wait();
+
+  if (leader) {
+    // The particles of each bucket go thread by thread, so they stay in
+    // order, as the stable sorts of split leave them
+    bucketDepth_ = bucketDepth;
+    bucketStarts_.resize(bucketCount + 1);
+    size_type offset = 0;
+    for (std::size_t b = 0; b < bucketCount; ++b) {
+      bucketStarts_[b] = offset;
+      for (unsigned int t = 0; t < threadCount; ++t) {
+        const size_type n = shares_[t].buckets[b];
+        shares_[t].buckets[b] = offset;
+        offset += n;
+      }
+    }
+    bucketStarts_[bucketCount] = offset;
+    index_.resize(count);
+    scratch_.resize(count);
+    cells_.assign(1, root);
+    tasks_.clear();
+    growTop(0, 0, 0);
+
+    taskStarts_.assign(threadCount + 1, tasks_.size());
+    taskStarts_[0] = 0;
+    size_type seen = 0;
+    unsigned int t = 1;
+    for (std::size_t ii = 0; ii < tasks_.size(); ++ii) {
+      while (t < threadCount && seen >= count * t / threadCount) {
+        taskStarts_[t++] = ii;
+      }
+      const Cell& c = cells_[tasks_[ii].first];
+      seen += c.end - c.begin;
+    }
+  }
+  barrier.wait();
+
+  for (size_type i = first; i < last; ++i) {
+    if (pc.container(i) >= 0) index_[share.buckets[bucket_[i]]++] = i;
+  }
+  barrier.wait();
+
+  share.cells.clear();
+  for (std::size_t ii = taskStarts_[whichThread];
+       ii < taskStarts_[whichThread + 1]; ++ii) {
+    const std::size_t cell = tasks_[ii].first;
+    const unsigned int depth = tasks_[ii].second;
+    const Cell c = cells_[cell];
+    // A leaf above the buckets has its occupants by bucket
+    if (depth < bucketDepth_) {
+      std::sort(index_.begin() + c.begin, index_.begin() + c.end);
+    }
+    const Cell r = split(pc, share.cells, c, depth);
+    cells_[cell] = r;
+  }
+  barrier.wait();
+
+  if (leader) {
+    std::size_t base = cells_.size();
+    for (unsigned int t = 0; t < threadCount; ++t) {
+      shares_[t].base = base;
+      base += shares_[t].cells.size();
+      for (std::size_t ii = taskStarts_[t]; ii < taskStarts_[t + 1]; ++ii) {
+        Cell& c = cells_[tasks_[ii].first];
+        if (c.firstChild >= 0) c.firstChild += shares_[t].base;
+      }
+    }
+    cells_.resize(base);
+    mass_.resize(count);
+    for (unsigned int d = 0; d < D; ++d) x_[d].resize(count);
+  }
+  barrier.wait();
+
+  for (std::size_t k = 0; k < share.cells.size(); ++k) {
+    Cell c = share.cells[k];
+    if (c.firstChild >= 0) c.firstChild += share.base;
+    cells_[share.base + k] = c;
+  }
+  const size_type firstK = chunkStart(count, threadCount, whichThread);
+  const size_type lastK = chunkStart(count, threadCount, whichThread + 1);
+  for (size_type k = firstK; k < lastK; ++k) {
+    mass_[k] = pc.mass(index_[k]);
+    for (unsigned int d = 0; d < D; ++d) x_[d][k] = pc.x(index_[k], d);
+  }
+  barrier.wait();
+
+  if (leader) settleTop(0, 0);
+  barrier.wait();
+}
+
+template <Dimension D>
+typename BarnesHutTree<D>::Cell BarnesHutTree<D>::split(
+    const ParticleContainer<D>& pc, std::vector<Cell>& cells, Cell c,
+    unsigned int depth) {
+  FloatType mass = 0;
+  FloatType com[D] = {};
+
+  if (c.end - c.begin <= kLeafSize || depth == kMaxDepth) {
+    for (size_type k = c.begin; k < c.end; ++k) {
+      const size_type i = index_[k];
+      mass += pc.mass(i);
+      for (unsigned int d = 0; d < D; ++d) com[d] += pc.mass(i) * pc.x(i, d);
+    }
+  } else {
+    // Sort the occupants by child, bit d of which is set if they are on the
+    // upper side of the center in dimension d
+    size_type count[kChildren] = {};
+    for (size_type k = c.begin; k < c.end; ++k) {
+      ++count[child(pc, c, index_[k])];
+    }
+    size_type offset[kChildren];
+    offset[0] = c.begin;
+    for (unsigned int o = 1; o < kChildren; ++o) {
+      offset[o] = offset[o - 1] + count[o - 1];
+    }
+    size_type cursor[kChildren];
+    std::copy(offset, offset + kChildren, cursor);
+    for (size_type k = c.begin; k < c.end; ++k) {
+      scratch_[cursor[child(pc, c, index_[k])]++] = index_[k];
+    }
+    std::copy(scratch_.begin() + c.begin, scratch_.begin() + c.end,
+              index_.begin() + c.begin);
+
+    const long firstChild = cells.size();
+    c.firstChild = firstChild;
+    for (unsigned int o = 0; o < kChildren; ++o) {
+      Cell ch = childCell(c, o);
+      ch.begin = offset[o];
+      ch.end = offset[o] + count[o];
+      cells.push_back(ch);
+    }
+    for (unsigned int o = 0; o < kChildren; ++o) {
+      if (count[o] == 0) continue;
+      const Cell ch = split(pc, cells, cells[firstChild + o], depth + 1);
+      cells[firstChild + o] = ch;
+      mass += ch.mass;
+      for (unsigned int d = 0; d < D; ++d) com[d] += ch.mass * ch.com[d];
+    }
+  }
+
+  c.mass = mass;
+  for (unsigned int d = 0; d < D; ++d) {
+    c.com[d] = mass > 0 ? com[d] / mass : c.center[d];
+  }
+  return c;
+}
+
+template <Dimension D>
+void BarnesHutTree<D>::growTop(std::size_t cell, unsigned int depth,
+                               std::size_t bucket) {
+  const Cell c = cells_[cell];
+  if (c.end - c.begin <= kLeafSize || depth == bucketDepth_) {
+    tasks_.push_back(std::make_pair(cell, depth));
+    return;
+  }
+  // The buckets under each child
+  std::size_t span = 1;
+  for (unsigned int l = depth + 1; l < bucketDepth_; ++l) span *= kChildren;
+  const long firstChild = cells_.size();
+  cells_[cell].firstChild = firstChild;
+  for (unsigned int o = 0; o < kChildren; ++o) {
+    const std::size_t b = bucket * kChildren + o;
+    Cell ch = childCell(c, o);
+    ch.begin = bucketStarts_[b * span];
+    ch.end = bucketStarts_[(b + 1) * span];
+    cells_.push_back(ch);
+  }
+  for (unsigned int o = 0; o < kChildren; ++o) {
+    const Cell& ch = cells_[firstChild + o];
+    if (ch.begin == ch.end) continue;
+    growTop(firstChild + o, depth + 1, bucket * kChildren + o);
+  }
+}
+
+template <Dimension D>
+void BarnesHutTree<D>::settleTop(std::size_t cell, unsigned int depth) {
+  const Cell c = cells_[cell];
+  if (c.firstChild < 0 || depth == bucketDepth_) return;
+  FloatType mass = 0;
+  FloatType com[D] = {};
+  for (unsigned int o = 0; o < kChildren; ++o) {
+    if (cells_[c.firstChild + o].begin == cells_[c.firstChild + o].end) {
+      continue;
+    }
+    settleTop(c.firstChild + o, depth + 1);
+    const Cell& ch = cells_[c.firstChild + o];
+    mass += ch.mass;
+    for (unsigned int d = 0; d < D; ++d) com[d] += ch.mass * ch.com[d];
+  }
+  Cell& out = cells_[cell];
+  out.mass = mass;
+  for (unsigned int d = 0; d < D; ++d) {
+    out.com[d] = mass > 0 ? com[d] / mass : c.center[d];
+  }
+}
+
+template <Dimension D>
+void BarnesHutTree<D>::interactions(ParticleContainer<D>& pc, size_type first,
+                                    size_type last) const {
+  if (cells_.empty() || strength_ == 0) return;
+  const FloatType cutoff2 = cutoff_ * cutoff_;
+  const FloatType diagonal = std::sqrt(FloatType(D));
+
+  for (size_type i = first; i < last; ++i) {
+    if (pc.isAnchor(i) || pc.container(i) < 0) continue;
+    FloatType xi[D], fi[D];
+    for (unsigned int d = 0; d < D; ++d) {
+      xi[d] = pc.x(i, d);
+      fi[d] = 0;
+    }
+
+    // Depth first, and at most kChildren - 1 cells are left behind per level
+    long stack[kMaxDepth * kChildren + 1];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+      const Cell& c = cells_[stack[--top]];
+      if (c.begin == c.end) continue;
+
+      FloatType dx[D], r2 = 0;
+      for (unsigned int d = 0; d < D; ++d) {
+        dx[d] = xi[d] - c.com[d];
+        r2 += dx[d] * dx[d];
+      }
+      const FloatType r = std::sqrt(r2);
+      if (2 * c.half < theta_ * r && r > cutoff_ + c.half * diagonal) {
+        // Far enough to be taken as a whole
+        const FloatType s = strength_ * c.mass / r2;
+        for (unsigned int d = 0; d < D; ++d) fi[d] += dx[d] * s;
+      } else if (c.firstChild < 0) {
+        for (size_type k = c.begin; k < c.end; ++k) {
+          FloatType dk[D], rk2 = 0;
+          for (unsigned int d = 0; d < D; ++d) {
+            dk[d] = xi[d] - x_[d][k];
+            rk2 += dk[d] * dk[d];
+          }
+          // Also skips i itself
+          if (rk2 <= cutoff2 || rk2 == 0) continue;
+          const FloatType s = strength_ * mass_[k] / rk2;
+          for (unsigned int d = 0; d < D; ++d) fi[d] += dk[d] * s;
+        }
+      } else {
+        for (unsigned int o = 0; o < kChildren; ++o) {
+          stack[top++] = c.firstChild + o;
+        }
+      }
+    }
+
+    for (unsigned int d = 0; d < D; ++d) pc.f(i, d, pc.f(i, d) + fi[d]);
+  }
+}
+
+template class BarnesHutTree<k2Dimensions>;
+template class BarnesHutTree<k3Dimensions>;
+
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,150 @@
+#ifndef LGL_LIB_BARNES_HUT_H_
+#define LGL_LIB_BARNES_HUT_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "particle_container.h"
+#include "spin_barrier.h"
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+// A quadtree (2D) or octree (3D) over the particles that are in the grid, for
+// a long-range repulsion on top of the short-range voxel interactions. Cells
+// that look small enough from a particle, as set by the opening angle theta,
+// act on it through their center of mass. Pairs that are closer than the
+// cutoff are left to the voxel interactions.
+//
+// The force a particle gets from a mass m at distance r is strength * m / r,
+// pointing away from it. Anchors don't get any.
+template <Dimension D>
+class BarnesHutTree {
+ public:
+  typedef typename ParticleContainer<D>::size_type size_type;
+
+  FloatType theta() const { return theta_; }
+  void theta(FloatType t) { theta_ = t; }
+
+  FloatType strength() const { return strength_; }
+  void strength(FloatType s) { strength_ = s; }
+
+  FloatType cutoff() const { return cutoff_; }
+  void cutoff(FloatType r) { cutoff_ = r; }
+
+  // Rebuilds the tree from the current positions. Has to be done whenever
+  // the particles have moved, and before any call to interactions.
+  void build(const ParticleContainer<D>& pc);
+
+  // The same build, split between threadCount threads that all call it with
+  // their own whichThread and the barrier they share. The particles get
+  // sorted into the cells a few levels down in parallel, each thread grows
+  // the subtrees of a share of those cells, and thread 0 joins them up. The
+  // tree is done when they return.
+  void build(const ParticleContainer<D>& pc, unsigned int whichThread,
+             unsigned int threadCount, spin_barrier& barrier);
+
+  // Adds the long-range repulsion to the forces of the particles
+  // [first, last). Only writes to those, so threads can share the tree.
+  void interactions(ParticleContainer<D>& pc, size_type first,
+                    size_type last) const;
+
+ private:
+  static const unsigned int kChildren = 1u << D;
+  static const size_type kLeafSize = 8;
+  static const unsigned int kMaxDepth = 32;
+  // Below this many particles a build isn't worth splitting
+  static const size_type kSerialSize = 1 << 14;
+  // The cells the particles get sorted into in a parallel build, per thread
+  static const std::size_t kBucketsPerThread = 16;
+
+  struct Cell {
+    FloatType center[D];
+    FloatType half;  // Half the edge length
+    FloatType com[D];
+    FloatType mass;
+    // The occupants are index_[begin, end)
+    size_type begin;
+    size_type end;
+    // The kChildren children are consecutive, or -1 for a leaf
+    long firstChild;
+  };
+
+  // What each thread has of a parallel build
+  struct Share {
+    // The box around its particles in the grid, and their count
+    FloatType lo[D];
+    FloatType hi[D];
+    size_type count;
+    // How many of its particles there are in each bucket, and then where
+    // the next one goes in index_
+    std::vector<size_type> buckets;
+    // The cells under the ones it split, going to cells_ from base
+    std::vector<Cell> cells;
+    std::size_t base;
+  };
+
+  // Subdivides c, at depth, until its occupants fit in the leaves, adding
+  // the cells under it to cells. Returns it with its children and center of
+  // mass set.
+  Cell split(const ParticleContainer<D>& pc, std::vector<Cell>& cells, Cell c,
+             unsigned int depth);
+
+  // Makes the cells above the buckets of a parallel build, under cell at
+  // depth, the prefix of the buckets under it being bucket. Leaves the cells
+  // that the threads have to split in tasks_.
+  void growTop(std::size_t cell, unsigned int depth, std::size_t bucket);
+
+  // Sets the centers of mass of the cells growTop split.
+  void settleTop(std::size_t cell, unsigned int depth);
+
+  static Cell childCell(const Cell& c, unsigned int o) {
+    Cell ch;
+    ch.half = c.half * FloatType(.5);
+    for (unsigned int d = 0; d < D; ++d) {
+      ch.center[d] = c.center[d] + (((o >> d) & 1) ? ch.half : -ch.half);
+    }
+    ch.mass = 0;
+    ch.firstChild = -1;
+    return ch;
+  }
+
+  // Which of the children of c the particle i falls into.
+  static unsigned int child(const ParticleContainer<D>& pc, const Cell& c,
+                            size_type i) {
+    unsigned int o = 0;
+    for (unsigned int d = 0; d < D; ++d) {
+      if (pc.x(i, d) >= c.center[d]) o |= 1u << d;
+    }
+    return o;
+  }
+
+  FloatType theta_ = 0.8;
+  FloatType strength_ = 0;
+  FloatType cutoff_ = 0;
+  std::vector<Cell> cells_;
+  std::vector<size_type> index_;
+  std::vector<size_type> scratch_;
+  // Positions and masses of the occupants, in the order of index_
+  std::vector<FloatType> x_[D];
+  std::vector<FloatType> mass_;
+
+  // For a parallel build
+  std::vector<Share> shares_;
+  unsigned int bucketDepth_ = 0;
+  // The bucket of each particle in the grid, and where each bucket starts
+  // in index_
+  std::vector<std::size_t> bucket_;
+  std::vector<size_type> bucketStarts_;
+  // The cells, and their depths, the threads split, in runs of about the
+  // same particle count, the run of thread t starting at taskStarts_[t]
+  std::vector<std::pair<std::size_t, unsigned int> > tasks_;
+  std::vector<std::size_t> taskStarts_;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_BARNES_HUT_H_
@@ -0,0 +1,173 @@
+#include "binary_graph.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace lgl {
+namespace lib {
+
+namespace {
+
+const char kMagic[8] = {'L', 'G', 'L', 'B', 'I', 'N', '\0', '\0'};
+const std::uint32_t kVersion = 1;
+const std::uint32_t kHasWeights = 1;
+
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t vertexCount;
+  std::uint64_t edgeCount;
+  std::uint64_t arcCount;
+  std::uint64_t idBytes;
+};
+
+std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t(7); }
+
+// Writes n bytes and pads them up to the next section
+void writeSection(std::FILE* out, const void* data, std::uint64_t n) {
+  static const char zeros[8] = {0};
+  if (std::fwrite(data, 1, n, out) != n ||
+      std::fwrite(zeros, 1, align8(n) - n, out) != align8(n) - n) {
+    throw std::runtime_error("BinaryGraph: write failed");
+  }
+}
+
+}  // namespace
+
+void BinaryGraph::open(const char* file) {
+  close();
+  const int fd = ::open(file, O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(std::string("BinaryGraph: open of ") + file +
+                             " failed");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error(std::string(file) + " is not a binary graph");
+  }
+  mapSize_ = st.st_size;
+  map_ = mmap(0, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED) {
+    map_ = 0;
+    throw std::runtime_error(std::string("BinaryGraph: mmap of ") + file +
+                             " failed");
+  }
+
+  const char* base = static_cast<const char*>(map_);
+  const Header& h = *reinterpret_cast<const Header*>(base);
+  const bool weights = h.flags & kHasWeights;
+  // Where the sections start, and the end of the last one
+  const std::uint64_t offsets = align8(sizeof(Header));
+  const std::uint64_t targets = offsets + 8 * (h.vertexCount + 1);
+  const std::uint64_t weightsAt =
+      targets + align8(sizeof(vertex_type) * h.arcCount);
+  const std::uint64_t idOffsets =
+      weightsAt + (weights ? align8(sizeof(float) * h.arcCount) : 0);
+  const std::uint64_t ids = idOffsets + 8 * (h.vertexCount + 1);
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 ||
+      h.version != kVersion || h.vertexCount >= mapSize_ ||
+      h.arcCount >= mapSize_ || ids + h.idBytes > mapSize_) {
+    close();
+    throw std::runtime_error(std::string(file) + " is not a binary graph");
+  }
+  vertexCount_ = h.vertexCount;
+  edgeCount_ = h.edgeCount;
+  arcCount_ = h.arcCount;
+  offsets_ = reinterpret_cast<const size_type*>(base + offsets);
+  targets_ = reinterpret_cast<const vertex_type*>(base + targets);
+  weights_ = weights ? reinterpret_cast<const float*>(base + weightsAt) : 0;
+  idOffsets_ = reinterpret_cast<const size_type*>(base + idOffsets);
+  ids_ = base + ids;
+  if (offsets_[vertexCount_] != arcCount_ ||
+      idOffsets_[vertexCount_] != h.idBytes) {
+    close();
+    throw std::runtime_error(std::string(file) + " is not a binary graph");
+  }
+  // Read through once, from the front
+  madvise(map_, mapSize_, MADV_SEQUENTIAL);
+}
+
+void BinaryGraph::close() {
+  if (map_ != 0) munmap(map_, mapSize_);
+  map_ = 0;
+  mapSize_ = 0;
+  vertexCount_ = edgeCount_ = arcCount_ = 0;
+  offsets_ = 0;
+  targets_ = 0;
+  weights_ = 0;
+  idOffsets_ = 0;
+  ids_ = 0;
+}
+
+bool BinaryGraph::isBinaryGraph(const char* file) {
+  std::FILE* in = std::fopen(file, "rb");
+  if (in == 0) return false;
+  char magic[sizeof(kMagic)];
+  const bool is = std::fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+                  std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+  std::fclose(in);
+  return is;
+}
+
+void BinaryGraph::write(const char* file,
+                        const std::vector<size_type>& offsets,
+                        const std::vector<vertex_type>& targets,
+                        const std::vector<float>& weights,
+                        const std::vector<std::string>& ids) {
+  Header h;
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.flags = weights.empty() ? 0 : kHasWeights;
+  h.vertexCount = ids.size();
+  h.arcCount = targets.size();
+  h.edgeCount = 0;
+  for (size_type v = 0; v < h.vertexCount; ++v) {
+    for (size_type a = offsets[v]; a < offsets[v + 1]; ++a) {
+      if (targets[a] >= v) ++h.edgeCount;
+    }
+  }
+  std::vector<size_type> idOffsets(1, 0);
+  idOffsets.reserve(ids.size() + 1);
+  for (const std::string& id : ids) {
+    idOffsets.push_back(idOffsets.back() + id.size() + 1);
+  }
+  h.idBytes = idOffsets.back();
+
+  std::FILE* out = std::fopen(file, "wb");
+  if (out == 0) {
+    throw std::runtime_error(std::string("BinaryGraph: open of ") + file +
+                             " failed");
+  }
+  try {
+    writeSection(out, &h, sizeof(h));
+    writeSection(out, offsets.data(), 8 * offsets.size());
+    writeSection(out, targets.data(), sizeof(vertex_type) * targets.size());
+    if (!weights.empty()) {
+      writeSection(out, weights.data(), sizeof(float) * weights.size());
+    }
+    writeSection(out, idOffsets.data(), 8 * idOffsets.size());
+    for (const std::string& id : ids) {
+      if (std::fwrite(id.c_str(), 1, id.size() + 1, out) != id.size() + 1) {
+        throw std::runtime_error("BinaryGraph: write failed");
+      }
+    }
+  } catch (...) {
+    std::fclose(out);
+    throw;
+  }
+  if (std::fclose(out) != 0) {
+    throw std::runtime_error("BinaryGraph: write failed");
+  }
+}
+
+}  // namespace lib
+}  // namespace lgl
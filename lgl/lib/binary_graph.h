@@ -0,0 +1,88 @@
+#ifndef LGL_LIB_BINARY_GRAPH_H_
+#define LGL_LIB_BINARY_GRAPH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lgl {
+namespace lib {
+
+// A graph in a compact binary file, read by mapping the file into memory
+// instead of parsing it. The file is, in the byte order of the machine that
+// wrote it, a header followed by these sections, each starting on an 8 byte
+// boundary:
+//  offsets: vertexCount + 1 uint64, where the neighbours of vertex v are
+//    targets[offsets[v]] up to targets[offsets[v + 1]].
+//  targets: arcCount uint32. Every edge is there in both directions, but a
+//    self loop only once.
+//  weights: arcCount float, the weight of each arc, if the graph has them.
+//  idOffsets: vertexCount + 1 uint64, where the id of vertex v is
+//    ids[idOffsets[v]] up to ids[idOffsets[v + 1]] - 1.
+//  ids: idBytes chars, the ids of the vertices, each followed by a 0.
+// lglfileconvert writes them from .lgl and .ncol files; they end in .lglb.
+class BinaryGraph {
+ public:
+  typedef std::uint64_t size_type;
+  typedef std::uint32_t vertex_type;
+
+  BinaryGraph() {}
+  BinaryGraph(const BinaryGraph&) = delete;
+  BinaryGraph& operator=(const BinaryGraph&) = delete;
+  ~BinaryGraph() { close(); }
+
+  // Maps the file. Throws std::runtime_error if it can't be read or isn't
+  // a binary graph.
+  void open(const char* file);
+  void close();
+
+  // Whether the file starts like a binary graph.
+  static bool isBinaryGraph(const char* file);
+
+  // Writes a graph in the format above. weights is either empty or has a
+  // weight for every target. Throws std::runtime_error if the file can't be
+  // written.
+  static void write(const char* file, const std::vector<size_type>& offsets,
+                    const std::vector<vertex_type>& targets,
+                    const std::vector<float>& weights,
+                    const std::vector<std::string>& ids);
+
+  size_type vertexCount() const { return vertexCount_; }
+  size_type edgeCount() const { return edgeCount_; }
+  size_type arcCount() const { return arcCount_; }
+  bool hasWeights() const { return weights_ != 0; }
+
+  const vertex_type* neighboursBegin(size_type v) const {
+    return targets_ + offsets_[v];
+  }
+  const vertex_type* neighboursEnd(size_type v) const {
+    return targets_ + offsets_[v + 1];
+  }
+  // The weights of the neighbours, in the same order
+  const float* weightsBegin(size_type v) const {
+    return weights_ + offsets_[v];
+  }
+
+  const char* id(size_type v) const { return ids_ + idOffsets_[v]; }
+  std::size_t idLength(size_type v) const {
+    return idOffsets_[v + 1] - idOffsets_[v] - 1;
+  }
+
+ private:
+  void* map_ = 0;
+  std::size_t mapSize_ = 0;
+  size_type vertexCount_ = 0;
+  size_type edgeCount_ = 0;
+  size_type arcCount_ = 0;
+  const size_type* offsets_ = 0;
+  const vertex_type* targets_ = 0;
+  const float* weights_ = 0;
+  const size_type* idOffsets_ = 0;
+  const char* ids_ = 0;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_BINARY_GRAPH_H_
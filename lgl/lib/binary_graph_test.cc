@@ -0,0 +1,144 @@
+#include "lgl/lib/binary_graph.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lgl {
+namespace lib {
+namespace {
+
+typedef BinaryGraph::size_type size_type;
+typedef BinaryGraph::vertex_type vertex_type;
+
+// Where the header keeps the vertex count, and where the offsets start
+const std::size_t kVertexCountAt = 16;
+const std::size_t kOffsetsAt = 48;
+
+std::string TempFile(const std::string& name) {
+  return ::testing::TempDir() + "/" + name;
+}
+
+std::string ReadBytes(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+void WriteBytes(const std::string& file, const std::string& bytes) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), bytes.size());
+}
+
+// a - b weighing 1.5, b - c weighing 2.5, and a loop on c weighing 3
+void WriteWeighted(const std::string& file) {
+  BinaryGraph::write(file.c_str(), {0, 1, 3, 5}, {1, 0, 2, 1, 2},
+                     {1.5, 1.5, 2.5, 2.5, 3}, {"a", "bb", "c"});
+}
+
+void ExpectRejected(const std::string& file) {
+  BinaryGraph graph;
+  EXPECT_THROW(graph.open(file.c_str()), std::runtime_error);
+  EXPECT_EQ(graph.vertexCount(), 0u);
+}
+
+std::vector<vertex_type> Neighbours(const BinaryGraph& graph, size_type v) {
+  return std::vector<vertex_type>(graph.neighboursBegin(v),
+                                  graph.neighboursEnd(v));
+}
+
+TEST(BinaryGraphTest, RoundTrip) {
+  const std::string file = TempFile("round_trip.lglb");
+  WriteWeighted(file);
+  EXPECT_TRUE(BinaryGraph::isBinaryGraph(file.c_str()));
+
+  BinaryGraph graph;
+  graph.open(file.c_str());
+  ASSERT_EQ(graph.vertexCount(), 3u);
+  EXPECT_EQ(graph.arcCount(), 5u);
+  // The loop is one edge, from its one arc
+  EXPECT_EQ(graph.edgeCount(), 3u);
+  ASSERT_TRUE(graph.hasWeights());
+  EXPECT_EQ(Neighbours(graph, 0), std::vector<vertex_type>({1}));
+  EXPECT_EQ(Neighbours(graph, 1), std::vector<vertex_type>({0, 2}));
+  EXPECT_EQ(Neighbours(graph, 2), std::vector<vertex_type>({1, 2}));
+  EXPECT_EQ(graph.weightsBegin(1)[1], 2.5f);
+  EXPECT_EQ(graph.weightsBegin(2)[1], 3.f);
+  EXPECT_EQ(std::string(graph.id(1), graph.idLength(1)), "bb");
+  EXPECT_STREQ(graph.id(2), "c");
+}
+
+TEST(BinaryGraphTest, RoundTripWithoutWeights) {
+  const std::string file = TempFile("no_weights.lglb");
+  BinaryGraph::write(file.c_str(), {0, 0, 1, 2}, {2, 1}, {},
+                     {"lonely", "b", "c"});
+  BinaryGraph graph;
+  graph.open(file.c_str());
+  ASSERT_EQ(graph.vertexCount(), 3u);
+  EXPECT_FALSE(graph.hasWeights());
+  EXPECT_EQ(graph.edgeCount(), 1u);
+  EXPECT_TRUE(Neighbours(graph, 0).empty());
+  EXPECT_EQ(std::string(graph.id(0), graph.idLength(0)), "lonely");
+}
+
+TEST(BinaryGraphTest, RejectsACorruptedHeader) {
+  const std::string file = TempFile("corrupted_header.lglb");
+  WriteWeighted(file);
+  const std::string good = ReadBytes(file);
+
+  std::string bytes = good;
+  bytes[0] = 'X';
+  WriteBytes(file, bytes);
+  EXPECT_FALSE(BinaryGraph::isBinaryGraph(file.c_str()));
+  ExpectRejected(file);
+
+  // The version
+  bytes = good;
+  ++bytes[8];
+  WriteBytes(file, bytes);
+  ExpectRejected(file);
+
+  // More vertices than the file has room for
+  bytes = good;
+  const std::uint64_t vertexCount = 1000;
+  std::memcpy(&bytes[kVertexCountAt], &vertexCount, sizeof(vertexCount));
+  WriteBytes(file, bytes);
+  ExpectRejected(file);
+
+  // Cut short, in the header and in the ids
+  WriteBytes(file, good.substr(0, 20));
+  ExpectRejected(file);
+  WriteBytes(file, good.substr(0, good.size() - 2));
+  ExpectRejected(file);
+}
+
+TEST(BinaryGraphTest, RejectsOffsetsThatDontEndAtTheArcCount) {
+  const std::string file = TempFile("bad_offsets.lglb");
+  WriteWeighted(file);
+  std::string bytes = ReadBytes(file);
+  // offsets[vertexCount], the end of the last row
+  const std::size_t last = kOffsetsAt + 3 * sizeof(size_type);
+  size_type end;
+  std::memcpy(&end, &bytes[last], sizeof(end));
+  ASSERT_EQ(end, 5u);
+  end = 4;
+  std::memcpy(&bytes[last], &end, sizeof(end));
+  WriteBytes(file, bytes);
+  ExpectRejected(file);
+}
+
+TEST(BinaryGraphTest, RejectsAMissingFile) {
+  const std::string file = TempFile("no_such_graph.lglb");
+  ExpectRejected(file);
+  EXPECT_FALSE(BinaryGraph::isBinaryGraph(file.c_str()));
+}
+
+}  // namespace
+}  // namespace lib
+}  // namespace lgl
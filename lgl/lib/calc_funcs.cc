@@ -20,17 +20,25 @@
 
 #include "calc_funcs.h"
 
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
 #include "boost/algorithm/string/classification.hpp"
 #include "boost/algorithm/string/split.hpp"
 #include "boost/foreach.hpp"
 #include "configs.h"
 #include "grid.h"
-#include "particle.h"
+#include "parallel_chunks.h"
+#include "particle_container.h"
 #include "particle_interaction_handler.h"
+#include "spin_barrier.h"
 #include "thread_pool.h"
 #include "types.h"
 #include "voxel.h"
 #include "voxel_interaction_handler.h"
+#include "work_queue.h"
 
 using std::tie;
 
@@ -39,26 +47,54 @@ namespace lib {
 
 //---------------------------------------------------------------
 
+void* countCellOccupants(void* arg_) {
+  ThreadArgs& args = *(static_cast<ThreadArgs*>(arg_));
+  args.grid->countOccupants(*(args.nodes), args.whichThread, args.threadCount);
+  return arg_;
+}
+
+//---------------------------------------------------------------
+
+void* scatterCellOccupants(void* arg_) {
+  ThreadArgs& args = *(static_cast<ThreadArgs*>(arg_));
+  args.grid->scatterOccupants(*(args.nodes), args.whichThread,
+                              args.threadCount);
+  return arg_;
+}
+
+//---------------------------------------------------------------
+
+void* sortCellOccupants(void* arg_) {
+  ThreadArgs& args = *(static_cast<ThreadArgs*>(arg_));
+  args.grid->sortOccupants(args.whichThread, args.threadCount);
+  return arg_;
+}
+
+//---------------------------------------------------------------
+
 void* calcInteractions(void* arg_) {
   // cout << "VoxelInteractions" << endl;
   ThreadArgs* args = static_cast<ThreadArgs*>(arg_);
-  GridIterator& grid_i = *(args->gridIterator);
   VoxelHandler& vh = *(args->voxelHandler);
-  args->nodeHandler->springConstant(args->casualSpringConstant);
   // const Graph<FloatType>& layout_graph = *(args->layout_graph);
   // layout_graph.print();
-  for (long ii = 0; ii < args->voxelListSize; ++ii) {
-    grid_i.current(args->voxelList[ii]);
-    Voxel_t& vox1 = grid_i.currentVox();
-    if (!vox1.empty()) {
-      // Iterate through the neighbors of each voxel
-      // The first nbhr is actually the same voxel
-      while (grid_i.incNbhr()) {
-        Voxel_t& vox2 = grid_i.nhbrVox();
-        if (!vox2.empty()) {
-          vh.twoVoxelInteractions(vox1, vox2);
-        }
-      }
+  Grid_t& grid = *(args->grid);
+  // The occupied voxels of this color come in chunks, as balanced by
+  // GridSchedule_MTS::balanceColors, and threads that run out early take
+  // over chunks of the others
+  WorkQueue& queue = args->schedule->colorQueue(args->currentColor);
+  const WorkQueue::size_type* first;
+  const WorkQueue::size_type* last;
+  // Only the occupied voxels, and their occupied neighbours in the half
+  // shell, the first of which is the voxel itself
+  const std::vector<Grid_t::size_type>& cells =
+      grid.occupiedCells(args->currentColor);
+  Voxel_t* nbhrs[14];
+  while (queue.next(args->whichThread, first, last)) {
+    for (; first != last; ++first) {
+      const Grid_t::size_type c = cells[*first];
+      const int nbhrCount = grid.occupiedNeighbours(c, nbhrs);
+      vh.nbhdInteractions(grid.cell(c), nbhrs, nbhrCount);
     }
   }
   return args;
@@ -67,7 +103,7 @@ void* calcInteractions(void* arg_) {
 //---------------------------------------------------------------
 
 void* integrateParticles(void* arg_) {
-  typedef Graph<FloatType>::vertex_iterator Vi;
+  typedef NodeContainer::size_type size_type;
   // cout << "integrateParticles" << endl;
   ThreadArgs& args = *(static_cast<ThreadArgs*>(arg_));
   long whichThread = args.whichThread;
@@ -75,310 +111,573 @@ void* integrateParticles(void* arg_) {
   NodeContainer& nodes = *(args.nodes);
   Grid_t& grid = *(args.grid);
   NodeInteractionHandler& nih = *(args.nodeHandler);
-  const Graph<FloatType>& layout_graph = *(args.layout_graph);
+  const LayoutEdges_t& edges = *(args.layoutEdges);
   const LevelMap& levels = *(args.levels);
+  const std::vector<size_type>& active = *(args.active);
   unsigned int currentLevel = args.currentLevel;
-  Vi v, vend;
-  int vertexCount = num_vertices(layout_graph.boostGraph());
-  tie(v, vend) = vertices(layout_graph.boostGraph());
-  if (whichThread != 0) {
-    std::advance(v, whichThread);
-  }
-  for (int vctr = whichThread; vctr < vertexCount; vctr += threadCount) {
-    if (vctr != whichThread) {
-      std::advance(v, threadCount);
-    }
-    // cout << *v << " " << levels.size() << endl;
-    if (levels[*v] > currentLevel) {
+  args.maxMove = 0;
+  args.force2 = 0;
+  args.moved = 0;
+  // By particle rather than through the layout graph, as the particles may
+  // be in another order than its vertices (see reorderParticles). Anchors
+  // of later levels are active too, as they are in the grid, but they don't
+  // move yet.
+  for (size_type k = whichThread; k < active.size(); k += threadCount) {
+    const size_type v = active[k];
+    if (!edges.hasVertex(v) || levels[v] > currentLevel) {
       continue;
     }
-    // cout << *v << " -" << endl;
-    Node& n = nodes[*v];
-    nih.enforceFLimit(n);
-    nih.integrate(n);
+    const FixedVec_p f = nodes.F(v);
+    const FixedVec_p before = nodes.X(v);
+    nih.enforceFLimit(nodes, v);
+    nih.integrate(nodes, v);
     // This is an edge of the grid check.
-    if (grid.checkInclusion(n.X())) {
-      shift_particle(n, grid);
+    const FixedVec_p x = nodes.X(v);
+    FixedVec_p dx = x;
+    dx -= before;
+    for (unsigned int d = 0; d < x.size(); ++d) {
+      args.moment[d] += nodes.mass(v) * (double(x[d]) - before[d]);
+    }
+    args.maxMove = std::max(args.maxMove, dx.dotProduct(dx));
+    args.force2 += f.dotProduct(f);
+    ++args.moved;
+    if (grid.checkInclusion(x)) {
+      shift_particle(nodes, v, grid);
+    } else if (args.escapes++ == 0) {
+      // Particle is outside the grid. It gets regrown before the next
+      // iteration.
+      args.escapeMin = x;
+      args.escapeMax = x;
     } else {
-      // Particle is outside the grid.
+      for (unsigned int d = 0; d < x.size(); ++d) {
+        args.escapeMin[d] = std::min(args.escapeMin[d], x[d]);
+        args.escapeMax[d] = std::max(args.escapeMax[d], x[d]);
+      }
     }
     // Reset the forces to zero for next
     // iteration
-    n.F(0);
+    nodes.F(v, 0);
   }
   return arg_;
 }
 
 //---------------------------------------------------------------
 
-void* collectEdgeStats(void* arg_) {
-  // cout << "collectingStats" << endl;
-  typedef Graph<FloatType>::edge_iterator Ei;
-  typedef Graph<FloatType>::vertex_descriptor vertex_descriptor;
+// Each thread owns a contiguous block of the rows of the layout edges and
+// pulls the spring forces of all their edges, so every edge is computed from
+// both ends but the forces only ever get written by the owner. The edge
+// lengths that the progress stats are made of get collected on the way;
+// counting every edge twice doesn't change their average.
+void* onlyEdgeInteractions(void* arg_) {
+  // cout << "onlyEdgeInteractions" << endl;
   ThreadArgs& args = *(static_cast<ThreadArgs*>(arg_));
-  const unsigned int currentLevel = args.currentLevel;
-  const LevelMap& levels = *(args.levels);
-  NodeContainer& nodes = *(args.nodes);
-  long whichThread = args.whichThread;
-  long threadCount = args.threadCount;
-  const Graph<FloatType>& layout_graph = *(args.layout_graph);
-  int edgeCount = num_edges(layout_graph.boostGraph());
-  int ctr = 0;
-  FloatType dx = 0;
-  Ei ei, eend;
-  tie(ei, eend) = edges(layout_graph.boostGraph());
-  if (whichThread != 0) {
-    std::advance(ei, whichThread);
-  }
-  for (int ectr = whichThread; ectr < edgeCount; ectr += threadCount) {
-    if (ectr != whichThread) {
-      std::advance(ei, threadCount);
-    }
-    vertex_descriptor v1 = source(*ei, layout_graph.boostGraph());
-    vertex_descriptor v2 = target(*ei, layout_graph.boostGraph());
-    if (levels[v1] == currentLevel || levels[v2] == currentLevel) {
-      const Node& n1 = nodes[v1];
-      const Node& n2 = nodes[v2];
-      dx += n1.X().distance(n2.X());
-      ++ctr;
-    }
-  }
+  const LayoutEdges_t& edges = *(args.layoutEdges);
+  LayoutEdges_t::size_type ctr = 0;
+  double dx = 0;
+  edges.springInteractions(*(args.edgeHandler), *(args.nodes),
+                           edges.firstVertex(args.whichThread),
+                           edges.lastVertex(args.whichThread), dx, ctr);
   args.stats->add2Stats_dx(dx);
   args.stats->count(ctr);
   return arg_;
 }
 
-//---------------------------------------------------------------
+//--------------------------------------------------------------
 
-void* onlyEdgeInteractions(void* arg_) {
-  // cout << "onlyEdgeInteractions" << endl;
-  typedef Graph<FloatType>::edge_iterator Ei;
+// Adds the long-range repulsion to the same rows the thread owns in
+// onlyEdgeInteractions, so the two can share a phase.
+void* farFieldInteractions(void* arg_) {
   ThreadArgs& args = *(static_cast<ThreadArgs*>(arg_));
-  NodeContainer& nodes = *(args.nodes);
-  long whichThread = args.whichThread;
-  long threadCount = args.threadCount;
-  NodeInteractionHandler& nih = *(args.nodeHandler);
-  nih.springConstant(args.specialSpringConstant);
-  const Graph<FloatType>& layout_graph = *(args.layout_graph);
-  int edgeCount = num_edges(layout_graph.boostGraph());
-  Ei ei, eend;
-  tie(ei, eend) = edges(layout_graph.boostGraph());
-  if (whichThread != 0) {
-    std::advance(ei, whichThread);
-  }
-  for (int ectr = whichThread; ectr < edgeCount; ectr += threadCount) {
-    if (ectr != whichThread) {
-      std::advance(ei, threadCount);
-    }
-    Node& n1 = nodes[source(*ei, layout_graph.boostGraph())];
-    Node& n2 = nodes[target(*ei, layout_graph.boostGraph())];
-    FloatType d =
-        euclideanDistance(n1.X().begin(), n1.X().end(), n2.X().begin());
-    if (d > nih.eqDistance()) {
-      nih.springRepulsiveInteraction(n1, n2);
-    }
-  }
+  if (args.farField == 0) return arg_;
+  const LayoutEdges_t& edges = *(args.layoutEdges);
+  args.farField->interactions(*(args.nodes),
+                              edges.firstVertex(args.whichThread),
+                              edges.lastVertex(args.whichThread));
   return arg_;
 }
 
 //--------------------------------------------------------------
 
-void beginSimulation(ThreadContainer& threads, FloatType cutOffPrecision,
-                     TimeKeeper& timer, ThreadArgs* threadArgs,
-                     PCChaperone& chaperone, unsigned int totalLevels,
-                     bool givenCoords, FloatType placementDistance,
-                     FloatType placementRadius, bool placeLeafsClose,
-                     bool silentOutput) {
-  Graph<FloatType>& current_layout = *(threadArgs->layout_graph);
-  Graph<FloatType>& full_graph = *(threadArgs->full_graph);
-  LevelMap& levels = *(threadArgs->levels);
-  ParentMap& parents = *(threadArgs->parents);
-  NodeContainer& nodes = *(threadArgs->nodes);
-  Grid_t& grid = *(threadArgs->grid);
-  long threadCount = threads.size();
-  unsigned int currentLevel = 1;
+namespace {
+
+// What the simulation threads share besides the particles. Only thread 0
+// writes to it, while the others are busy with something that doesn't read
+// it or are waiting at the barrier, and they only read it after the next one.
+struct SimulationControl {
+  spin_barrier* barrier;
+  ThreadArgs* threadArgs;
+  PCChaperone* chaperone;
+  TimeKeeper* timer;
+  unsigned int totalLevels;
+  bool givenCoords;
+  FloatType placementDistance;
+  FloatType placementRadius;
+  bool placeLeafsClose;
+  bool silentOutput;
+  // Iterations between reorderParticles, or 0 for never
+  int reorderInterval;
+
+  unsigned int currentLevel = 0;
+  bool simulationDone = false;
+  bool levelDone = false;
+  bool writeCoords = false;
+  // Convergence of the current level
+  ConvergenceMonitor convergence;
+  // The motion of the particles in the last integration step, gathered
+  // from the threads (see ThreadArgs::maxMove)
+  FloatType maxMove = 0;
+  FloatType meanForce2 = 0;
+  // The index each particle has in the graphs, while they are reordered
+  std::vector<NodeContainer::size_type> original;
+  // See ThreadArgs::active
+  std::vector<NodeContainer::size_type> active;
+  // Where the vertices of the current tree level go, for the threads to
+  // place them
+  LayerPlacement placement;
+  // The mass of the vertices of the tree levels so far, and the
+  // mass-weighted sum of the positions of those that no thread placed: the
+  // root and the anchors. With the moments of the threads, that gives their
+  // center of mass without going through them.
+  double placedMass = 0;
+  FixedVec<double, n_dimensions> placedMoment = 0;
+};
+
+// Thread 0: adds the particles that the current level brings in to the
+// ones that take part, so the iterations don't have to go through all of
+// them. The first level starts from the particles in the grid: the root and
+// the anchors, or all of them if their coordinates were given. Each level
+// after that only adds its own vertices, by the level index.
+void addActiveParticles(SimulationControl& c) {
+  typedef LevelIndex::vertex_descriptor vertex_descriptor;
+  const ThreadArgs& args = c.threadArgs[0];
+  const NodeContainer& nodes = *(args.nodes);
+  const LayoutEdges_t& edges = *(args.layoutEdges);
+  if (c.currentLevel == 1 || c.givenCoords) {
+    c.active.clear();
+    for (NodeContainer::size_type v = 0; v < nodes.size(); ++v) {
+      if (nodes.container(v) >= 0) c.active.push_back(v);
+    }
+  }
+  if (!args.levelIndex) return;
+  const LevelIndex& index = *(args.levelIndex);
+  // The anchors of the level are in the grid already
+  for (const vertex_descriptor* v = index.verticesBegin(c.currentLevel);
+       v != index.verticesEnd(c.currentLevel); ++v) {
+    if (edges.hasVertex(*v) && nodes.container(*v) < 0) c.active.push_back(*v);
+  }
+}
 
-  thread_pool threadpool(threadCount);
-  std::vector<std::future<void> > futures;
-  futures.reserve(threadCount);
+// Renumbers the particles and what the iterations index by them, particle
+// order[i] becoming particle i. newIndex is the inverse of order. The graphs
+// keep the original numbering, as only the level starts use them.
+void renumberParticles(SimulationControl& c,
+                       const std::vector<NodeContainer::size_type>& order,
+                       const std::vector<NodeContainer::size_type>& newIndex) {
+  ThreadArgs& args = c.threadArgs[0];
+  args.nodes->permute(order);
+  LevelMap& levels = *(args.levels);
+  LevelMap newLevels(levels.size());
+  for (std::size_t ii = 0; ii < order.size(); ++ii) {
+    newLevels[ii] = levels[order[ii]];
+  }
+  levels.swap(newLevels);
+  args.layoutEdges->renumber(order, newIndex, args.threadCount);
+  for (NodeContainer::size_type& v : c.active) v = newIndex[v];
+}
 
-  const auto wait_for_futures = [&futures] {
-    for (auto& f : futures) f.get();
-    futures.clear();
-  };
-
-  while (currentLevel <= totalLevels) {
-    // Place and initialize the next layer of the graph
-    if (!givenCoords) {
-      addNextLevelFromMap(current_layout, full_graph, levels, currentLevel);
-      initializeCurrentLayer(current_layout, nodes, levels, parents, grid,
-                             currentLevel, full_graph, placementDistance,
-                             placementRadius, placeLeafsClose);
-    } else {
-      currentLevel = totalLevels;
-    }
+// Thread 0: renumbers the particles in the Z-order of their voxels, so
+// particles that are close in space are close in memory too, and so are the
+// rows of the layout edges. The ones that aren't in the grid go last.
+void reorderParticles(SimulationControl& c) {
+  typedef NodeContainer::size_type size_type;
+  const NodeContainer& nodes = *(c.threadArgs[0].nodes);
+  const Grid_t& grid = *(c.threadArgs[0].grid);
+  const size_type n = nodes.size();
+  std::vector<std::pair<long, size_type> > keyed(n);
+  for (size_type ii = 0; ii < n; ++ii) {
+    const FixedVec_p x = nodes.X(ii);
+    const long key = grid.checkInclusion(x) ? grid.zOrder(x)
+                                            : std::numeric_limits<long>::max();
+    keyed[ii] = std::make_pair(key, ii);
+  }
+  std::sort(keyed.begin(), keyed.end());
 
-    FloatType avgPrevious = 0.0;
-    FloatType dx = 10000000.;
-    int iterationCtr = 0;
+  std::vector<size_type> order(n), newIndex(n), original(n);
+  for (size_type ii = 0; ii < n; ++ii) {
+    order[ii] = keyed[ii].second;
+    newIndex[order[ii]] = ii;
+    original[ii] = c.original[order[ii]];
+  }
+  renumberParticles(c, order, newIndex);
+  c.original.swap(original);
+}
 
-    do {
-      // Repulsive terms
-      for (long ii = 0; ii < threadCount; ++ii) {
-        threadArgs[ii].currentLevel = currentLevel;
-        threadArgs[ii].nodeHandler->springConstant(
-            threadArgs[ii].casualSpringConstant);
-        threadArgs[ii].nodeHandler->eqDistance(threadArgs[ii].nbhdRadius);
-        futures.push_back(threadpool.run(calcInteractions,
-                                         static_cast<void*>(&threadArgs[ii])));
-      }
-      wait_for_futures();
-
-      // Attractive terms
-      for (long ii = 0; ii < threadCount; ++ii) {
-        threadArgs[ii].nodeHandler->springConstant(
-            threadArgs[ii].specialSpringConstant);
-        threadArgs[ii].nodeHandler->eqDistance(threadArgs[ii].eqDistance);
-        futures.push_back(threadpool.run(onlyEdgeInteractions,
-                                         static_cast<void*>(&threadArgs[ii])));
-      }
-      wait_for_futures();
+// Thread 0: puts the particles back in the order of the graphs.
+void restoreParticleOrder(SimulationControl& c) {
+  std::vector<NodeContainer::size_type> order(c.original.size());
+  for (std::size_t ii = 0; ii < order.size(); ++ii) order[c.original[ii]] = ii;
+  renumberParticles(c, order, c.original);
+  for (std::size_t ii = 0; ii < order.size(); ++ii) c.original[ii] = ii;
+}
 
-      // Integrate for next time step
-      for (long ii = 0; ii < threadCount; ++ii) {
-        futures.push_back(threadpool.run(integrateParticles,
-                                         static_cast<void*>(&threadArgs[ii])));
-      }
-      wait_for_futures();
+// Thread 0: the center of mass of the vertices of the tree levels so far.
+FixedVec_p centerOfPlacedMass(const SimulationControl& c) {
+  FixedVec<double, n_dimensions> moment = c.placedMoment;
+  for (long ii = 0; ii < c.threadArgs[0].threadCount; ++ii) {
+    moment += c.threadArgs[ii].moment;
+  }
+  FixedVec_p center;
+  for (unsigned int d = 0; d < center.size(); ++d) {
+    center[d] = c.placedMass > 0 ? moment[d] / c.placedMass : 0;
+  }
+  return center;
+}
 
-      // Collect stats for progress
-      for (long ii = 0; ii < threadCount; ++ii) {
-        futures.push_back(threadpool.run(collectEdgeStats,
-                                         static_cast<void*>(&threadArgs[ii])));
+// Thread 0: adds the vertices of the current tree level, and the root with
+// the first, to the placed mass. The threads add where they place the rest.
+void addPlacedMass(SimulationControl& c) {
+  typedef LevelIndex::vertex_descriptor vertex_descriptor;
+  const ThreadArgs& args = c.threadArgs[0];
+  const NodeContainer& nodes = *(args.nodes);
+  const LayoutEdges_t& edges = *(args.layoutEdges);
+  const LevelIndex& index = *(args.levelIndex);
+  const unsigned int first = c.currentLevel == 1 ? 0 : c.currentLevel;
+  for (unsigned int l = first; l <= c.currentLevel; ++l) {
+    for (const vertex_descriptor* v = index.verticesBegin(l);
+         v != index.verticesEnd(l); ++v) {
+      if (!edges.hasVertex(*v)) continue;
+      c.placedMass += nodes.mass(*v);
+      if (l > 0 && !nodes.isAnchor(*v)) continue;
+      const FixedVec_p x = nodes.X(*v);
+      for (unsigned int d = 0; d < x.size(); ++d) {
+        c.placedMoment[d] += double(nodes.mass(*v)) * x[d];
       }
-      wait_for_futures();
+    }
+  }
+}
 
-      FloatType dxNew = collectOutput(&threadArgs[0], chaperone);
-      if (!silentOutput) {
-        printOutput(timer.iteration(), dxNew, currentLevel, std::cerr);
-      }
-      chaperone.level(currentLevel);
+// Thread 0: sets up the next level, or flags that there are none left. The
+// vertices of a tree level are only worked out, into c.placement; all the
+// threads place them after.
+void startLevel(SimulationControl& c) {
+  ThreadArgs& args = c.threadArgs[0];
+  c.placement.clear();
+  // The placement goes by the graphs, and so does everything after the
+  // simulation
+  if (c.reorderInterval > 0) restoreParticleOrder(c);
+  c.currentLevel = c.currentLevel == 0 ? 1 : c.currentLevel + 1;
+  if (c.currentLevel > c.totalLevels) {
+    c.simulationDone = true;
+    return;
+  }
+  // Place and initialize the next layer of the graph
+  if (!c.givenCoords && args.coarsening) {
+    initializeCoarseLayer(*(args.layout_graph), *(args.coarse_graph),
+                          *(args.full_graph), *(args.coarsening),
+                          *(args.nodes), *(args.levels), *(args.parents),
+                          *(args.grid), c.currentLevel, c.placementDistance,
+                          c.placementRadius);
+    args.layoutEdges->rebuild(*(args.layout_graph), *(args.nodes),
+                              *(args.levels), c.currentLevel,
+                              args.threadCount);
+  } else if (!c.givenCoords) {
+    addNextLevelFromMap(*(args.layout_graph), *(args.full_graph),
+                        *(args.levels), c.currentLevel);
+    initializeCurrentLayer(*(args.layout_graph), *(args.levelIndex),
+                           *(args.nodes), *(args.parents), c.currentLevel,
+                           centerOfPlacedMass(c), c.placementDistance,
+                           c.placementRadius, c.placeLeafsClose, c.placement);
+    args.layoutEdges->addLevel(*(args.levelIndex), *(args.nodes),
+                               c.currentLevel, args.threadCount);
+    addPlacedMass(c);
+  } else {
+    c.currentLevel = c.totalLevels;
+    args.layoutEdges->rebuild(*(args.layout_graph), *(args.nodes),
+                              *(args.levels), c.currentLevel,
+                              args.threadCount);
+  }
+  const std::size_t placed = c.active.size();
+  addActiveParticles(c);
+  c.convergence.startLevel(c.active.size() - placed);
+  for (long ii = 0; ii < c.threadArgs[0].threadCount; ++ii) {
+    c.threadArgs[ii].maxMove = 0;
+    c.threadArgs[ii].force2 = 0;
+    c.threadArgs[ii].moved = 0;
+  }
+}
 
-      FloatType avg = (dxNew + dx) * .5;
-      if (abs(dxNew - dx) / dxNew < cutOffPrecision || iterationCtr > 150 ||
-          abs(avgPrevious - avg) / avg < .1 * cutOffPrecision) {
-        ++timer;
-        break;
-      }
+// Thread 0: gathers how the particles moved in the last integration step.
+// Has to be done before the threads get to the next one.
+void collectMotion(SimulationControl& c) {
+  FloatType force2 = 0;
+  long moved = 0;
+  c.maxMove = 0;
+  for (long ii = 0; ii < c.threadArgs[0].threadCount; ++ii) {
+    const ThreadArgs& args = c.threadArgs[ii];
+    c.maxMove = std::max(c.maxMove, std::sqrt(args.maxMove));
+    force2 += args.force2;
+    moved += args.moved;
+  }
+  c.meanForce2 = moved > 0 ? force2 / moved : 0;
+}
 
-      avgPrevious = avg;
-      dx = dxNew;
+// Thread 0: looks at the stats of this iteration and decides whether the
+// level has settled. The edge stats come from the edge pass, so they
+// describe the positions before this iteration's integration step, and the
+// motion the one before.
+void checkProgress(SimulationControl& c) {
+  TimeKeeper& timer = *(c.timer);
+  FloatType dxNew = collectOutput(c.threadArgs, *(c.chaperone));
+  if (!c.silentOutput) {
+    printOutput(timer.iteration(), dxNew, c.currentLevel, std::cerr);
+  }
+  c.chaperone->level(c.currentLevel);
 
-      if (threadArgs[0].stats->collectStatsCheck(timer.iteration())) {
-        char layerChar[64];
-        sprintf(layerChar, "coords/%dlayout%d", timer.iteration(),
-                currentLevel);
-        chaperone.posOutFile(layerChar);
-        chaperone.writeOutFiles();
-      }
+  FloatType value = dxNew;
+  if (c.convergence.criterion() == StopCriterion::kMaxMove) {
+    value = dxNew > 0 ? c.maxMove / dxNew : 0;
+  } else if (c.convergence.criterion() == StopCriterion::kForce) {
+    value = c.meanForce2;
+  }
+  if (c.convergence.update(value)) {
+    ++timer;
+    c.levelDone = true;
+    if (!c.silentOutput) {
+      std::cerr << "\nLevel " << c.currentLevel << " stopped after "
+                << c.convergence.iterations()
+                << " iterations: " << c.convergence.describe() << '\n';
+    }
+    return;
+  }
 
-      ++iterationCtr;
-      ++timer;
+  // Written once the positions of this iteration are in
+  c.writeCoords = c.threadArgs[0].stats->collectStatsCheck(timer.iteration());
+  ++timer;
+  c.levelDone = !timer.rangeCheck();
+  if (c.levelDone && !c.silentOutput) {
+    std::cerr << "\nLevel " << c.currentLevel
+              << " stopped at the iteration limit\n";
+  }
+}
 
-    } while (timer.rangeCheck());
+// Grows the grid to take in the particles that left it in the last
+// integration step, if any did. All the threads have to call it, as they
+// share the rebinning.
+void regrowGrid(ThreadArgs& args, SimulationControl& c) {
+  long escapes = 0;
+  for (long ii = 0; ii < args.threadCount; ++ii) {
+    escapes += c.threadArgs[ii].escapes;
+  }
+  if (escapes == 0) return;
+  Grid_t& grid = *(args.grid);
 
-    ++currentLevel;
+  // Everybody has to have read the counts before anything changes
+  c.barrier->wait();
+  if (args.whichThread == 0) {
+    FixedVec_p mins = grid.min(), maxs = grid.max();
+    for (long ii = 0; ii < args.threadCount; ++ii) {
+      const ThreadArgs& other = c.threadArgs[ii];
+      if (other.escapes == 0) continue;
+      for (unsigned int d = 0; d < mins.size(); ++d) {
+        mins[d] = std::min(mins[d], other.escapeMin[d]);
+        maxs[d] = std::max(maxs[d], other.escapeMax[d]);
+      }
+    }
+    // Some room to grow into, so this doesn't happen every iteration
+    for (unsigned int d = 0; d < mins.size(); ++d) {
+      const FloatType pad = .25 * (maxs[d] - mins[d]);
+      mins[d] -= pad;
+      maxs[d] += pad;
+    }
+    grid.regrow(mins, maxs);
+    args.schedule->gridRegrown();
+  }
+  c.barrier->wait();
+  // The same stride as countCellOccupants, so that needs no barrier
+  grid.rebinOccupants(*(args.nodes), args.whichThread, args.threadCount);
+  args.escapes = 0;
+}
 
-  }  // End of iterative layout.
+// Thread 0: dumps the coordinates of the last iteration.
+void writeCoords(SimulationControl& c) {
+  char layerChar[64];
+  sprintf(layerChar, "coords/%dlayout%d", c.timer->iteration() - 1,
+          c.currentLevel);
+  c.chaperone->posOutFile(layerChar);
+  c.chaperone->writeOutFiles();
+  c.writeCoords = false;
 }
 
-//----------------------------------------------------------
+// The whole simulation, as run by each of the threads. The phases are
+// separated by the barrier; the ones that have to be serial are left to
+// thread 0.
+void runSimulationThread(ThreadArgs& args, SimulationControl& c) {
+  const bool leader = args.whichThread == 0;
+  spin_barrier& barrier = *(c.barrier);
+  Grid_t& grid = *(args.grid);
+  void* arg = static_cast<void*>(&args);
+  while (true) {
+    if (leader) startLevel(c);
+    barrier.wait();
+    if (c.simulationDone) break;
+    // Each thread its share of the new vertices of a tree level, and of the
+    // active particles, which start the level at rest
+    layerNPlacement(c.placement, *(args.nodes), args.whichThread,
+                    args.threadCount, args.moment);
+    for (std::size_t k = args.whichThread; k < c.active.size();
+         k += args.threadCount) {
+      args.nodeHandler->resetMotion(*(args.nodes), c.active[k]);
+    }
+    barrier.wait();
+    args.currentLevel = c.currentLevel;
+    // Not in startLevel, as the others may still be reading it there
+    if (leader) c.levelDone = false;
 
-void initializeCurrentLayer(Graph<FloatType>& layout_graph,
-                            NodeContainer& nodes, LevelMap& levels,
-                            ParentMap& parents, Grid_t& grid,
-                            unsigned int currentLevel,
-                            Graph<FloatType>& actualG,
-                            FloatType placementDistance,
-                            FloatType placementRadius, bool placeLeafsClose) {
-  Graph<FloatType>::vertex_iterator v, vend;
-  out_graph edges2add;
-  FixedVec_p cm;
-  // Get the center of mass for the current level
-  if (currentLevel == 1) {
-    tie(v, vend) = vertices(layout_graph.boostGraph());
-    for (; v != vend; ++v) {
-      // Find the root node and that is the cent mass
-      if (levels[*v] == 0) {
-        cm = nodes[*v].X();
-        break;
+    do {
+      // Nothing moves until the integration step below
+      if (leader && c.writeCoords) writeCoords(c);
+      args.nodeHandler->noiseStep(c.timer->iteration());
+      args.edgeHandler->noiseStep(c.timer->iteration());
+      if (leader) collectMotion(c);
+      if (c.reorderInterval > 0 &&
+          c.convergence.iterations() % c.reorderInterval == 0) {
+        if (leader) reorderParticles(c);
+        barrier.wait();
       }
-    }
-  } else {
-    cm = calcCenterOfMass(layout_graph, nodes, levels, currentLevel);
+
+      // Take in the particles that left the grid last time, then sort all
+      // of them into the voxels they moved to
+      regrowGrid(args, c);
+      countCellOccupants(arg);
+      barrier.wait();
+      if (leader) {
+        grid.allocateOccupants();
+        args.schedule->balanceColors();
+      }
+      barrier.wait();
+      if (args.farField) {
+        args.farField->build(*(args.nodes), args.whichThread,
+                             args.threadCount, barrier);
+      }
+      scatterCellOccupants(arg);
+      barrier.wait();
+      sortCellOccupants(arg);
+      barrier.wait();
+
+      // Repulsive terms, one voxel color at a time
+      for (unsigned int color = 0; color < GridSchedule_t::colors(); ++color) {
+        args.currentColor = color;
+        calcInteractions(arg);
+        barrier.wait();
+      }
+
+      // Attractive terms, which also collect the stats for progress, and
+      // the long-range repulsion
+      farFieldInteractions(arg);
+      onlyEdgeInteractions(arg);
+      barrier.wait();
+
+      // Integrate for next time step
+      if (leader) checkProgress(c);
+      integrateParticles(arg);
+      barrier.wait();
+    } while (!c.levelDone);
   }
-  tie(v, vend) = vertices(layout_graph.boostGraph());
-  // Determine which edges are going to be added to the current layout
-  for (; v != vend; ++v) {
-    if (levels[*v] == currentLevel) {
-      add_edge(parents[*v], *v, edges2add);
+}
+
+}  // namespace
+
+void beginSimulation(ThreadContainer& threads, FloatType cutOffPrecision,
+                     TimeKeeper& timer, ThreadArgs* threadArgs,
+                     PCChaperone& chaperone, unsigned int totalLevels,
+                     bool givenCoords, FloatType placementDistance,
+                     FloatType placementRadius, bool placeLeafsClose,
+                     bool silentOutput, int reorderInterval,
+                     const ConvergenceMonitor& convergence) {
+  long threadCount = threads.size();
+  spin_barrier barrier(threadCount);
+
+  SimulationControl control;
+  control.barrier = &barrier;
+  control.threadArgs = threadArgs;
+  control.chaperone = &chaperone;
+  control.timer = &timer;
+  control.convergence = convergence;
+  control.convergence.precision(cutOffPrecision);
+  control.totalLevels = totalLevels;
+  control.givenCoords = givenCoords;
+  control.placementDistance = placementDistance;
+  control.placementRadius = placementRadius;
+  control.placeLeafsClose = placeLeafsClose;
+  control.silentOutput = silentOutput;
+  control.reorderInterval = reorderInterval;
+  if (reorderInterval > 0) {
+    control.original.resize(threadArgs[0].nodes->size());
+    for (std::size_t ii = 0; ii < control.original.size(); ++ii) {
+      control.original[ii] = ii;
     }
   }
-  layerNPlacement(nodes, grid, edges2add, cm, currentLevel, parents, actualG,
-                  levels, placementDistance, placementRadius, placeLeafsClose);
+  for (long ii = 0; ii < threadCount; ++ii) {
+    threadArgs[ii].active = &control.active;
+    threadArgs[ii].moment = 0;
+  }
+  threadArgs[0].grid->activeParticles(&control.active);
+
+  // One task per thread for the whole layout
+  thread_pool threadpool(threadCount);
+  std::vector<std::future<void> > futures;
+  futures.reserve(threadCount);
+  for (long ii = 0; ii < threadCount; ++ii) {
+    futures.push_back(threadpool.run(runSimulationThread,
+                                     std::ref(threadArgs[ii]),
+                                     std::ref(control)));
+  }
+  for (auto& f : futures) f.get();
+  threadArgs[0].grid->activeParticles(0);
 }
 
 //----------------------------------------------------------
 
-void layerNPlacement(NodeContainer& nodes, Grid_t& grid, out_graph& g,
-                     FixedVec_p& cm, unsigned int currentLevel,
-                     ParentMap& parents, Graph<FloatType>& actualG,
-                     LevelMap& lm, FloatType placementDistance,
-                     FloatType placementRadius, bool placeLeafsClose) {
-  typedef Sphere S;
-  typedef S::vec_type Vec;
-  typedef out_graph::out_edge_iterator oei;
-  typedef out_graph::vertex_descriptor vertex_descriptor;
-  typedef out_graph::vertex_iterator vertex_iterator;
-
-  vertex_iterator v, vend;
-  tie(v, vend) = vertices(g);
-
-  for (; v != vend; ++v) {
-    oei e, eend;
-    tie(e, eend) = out_edges(*v, g);
-    int vertices2place = 0;
-    oei ee = e;
-    while (ee++ != eend) {
-      ++vertices2place;
-    }
-    // int vertices2place = distance( e , eend );
-    if (vertices2place == 0) {
-      continue;
+void initializeCurrentLayer(const CsrGraphView<FloatType>& layout_graph,
+                            const LevelIndex& index, NodeContainer& nodes,
+                            const ParentMap& parents, unsigned int currentLevel,
+                            const FixedVec_p& cm, FloatType placementDistance,
+                            FloatType placementRadius, bool placeLeafsClose,
+                            LayerPlacement& placement) {
+  typedef LevelIndex::vertex_descriptor vertex_descriptor;
+  typedef Sphere::vec_type Vec;
+  // The vertices that are going to be added to the current layout, by
+  // parent
+  std::vector<std::pair<vertex_descriptor, vertex_descriptor> > children;
+  for (const vertex_descriptor* v = index.verticesBegin(currentLevel);
+       v != index.verticesEnd(currentLevel); ++v) {
+    children.push_back(std::make_pair(parents[*v], *v));
+  }
+  std::sort(children.begin(), children.end());
+
+  const int perPoint = drawsPerPoint(NodeContainer::n_dimensions_);
+  placement.clear();
+  placement.radius = currentLevel == 1 ? 1.0 : placementRadius;
+  for (std::size_t first = 0, last; first < children.size(); first = last) {
+    const vertex_descriptor p = children[first].first;
+    for (last = first; last < children.size() && children[last].first == p;
+         ++last) {
     }
-    Node& parentNode = nodes[*v];
-    Node& parentParentNode = nodes[parents[*v]];
-    Vec spot(parentNode.X().begin(), parentNode.X().end());
-    std::vector<Vec> x;
+    const int vertices2place = last - first;
+    const FixedVec_p parentNode = nodes.X(p);
+    Vec spot(parentNode.begin(), parentNode.end());
 
-    if (currentLevel == 1) {
-      S s(spot);
-      s.radius(1.0);
-      seriesOfPointsOnSphere(s, vertices2place, x);
-
-    } else {
+    if (currentLevel > 1) {
       FixedVec_p d;
-      generatePlacementVector(d, parentNode.X(), parentParentNode.X(), cm);
+      generatePlacementVector(d, parentNode, nodes.X(parents[p]), cm);
       FloatType m = magnitude(d.begin(), d.end());
 
       // Determine if any of these children are parents
-      tie(e, eend) = out_edges(*v, g);
-      bool hasChildren = true;
+      bool hasChildren = false;
       if (placeLeafsClose) {
-        for (; e != eend; ++e) {
-          vertex_descriptor other = target(*e, g);
-          if (!doesVertexHaveAnyChildren(actualG, other, g, parents)) {
-            hasChildren = false;
+        for (std::size_t ii = first; ii < last; ++ii) {
+          if (index.childCount(children[ii].second) != 0) {
+            hasChildren = true;
             break;
           }
         }
@@ -396,55 +695,131 @@ void layerNPlacement(NodeContainer& nodes, Grid_t& grid, out_graph& g,
 
       scale(d.begin(), d.end(), scalef / m);
       translate(spot.begin(), spot.end(), d.begin());
-      S s(spot);
-      s.radius(placementRadius);
-      Vec direction(d.begin(), d.end());
-      seriesOfPointsOnSphere(s, vertices2place, x);
     }
 
-    // Initialize the positions of the next level
+    // A point for each child, though the anchors don't take theirs
+    const std::size_t draws = placement.draws.size();
+    for (int ii = 0; ii < vertices2place * perPoint; ++ii) {
+      placement.draws.push_back(rand());
+    }
     int ctr = 0;
-    tie(e, eend) = out_edges(*v, g);
-    for (; e != eend; ++e) {
-      vertex_descriptor other = target(*e, g);
-      if (!nodes[other].isAnchor()) {
-        nodes[other].X(x[ctr].begin(), x[ctr].end());
+    for (std::size_t ii = first; ii < last; ++ii) {
+      const vertex_descriptor other = children[ii].second;
+      if (!nodes.isAnchor(other)) {
+        placement.children.push_back(other);
+        placement.groups.push_back(placement.spots.size());
+        placement.firstDraws.push_back(draws + ctr * perPoint);
         ++ctr;
       }
     }
+    placement.spots.push_back(spot);
+  }
+}
+
+void layerNPlacement(const LayerPlacement& placement, NodeContainer& nodes,
+                     long whichThread, long threadCount,
+                     FixedVec<double, n_dimensions>& moment) {
+  const std::size_t count = placement.children.size();
+  const std::size_t first = chunkStart(count, threadCount, whichThread);
+  const std::size_t last = chunkStart(count, threadCount, whichThread + 1);
+  // This thread's, for all of its children
+  Sphere s;
+  Sphere::vec_type x;
+  s.radius(placement.radius);
+  for (std::size_t ii = first; ii < last; ++ii) {
+    const Sphere::vec_type& spot = placement.spots[placement.groups[ii]];
+    s.location(spot.begin(), spot.end());
+    randomPointOnSurface(s, &placement.draws[placement.firstDraws[ii]], x);
+    const unsigned v = placement.children[ii];
+    nodes.X(v, x.begin(), x.end());
+    for (unsigned int d = 0; d < x.size(); ++d) {
+      moment[d] += double(nodes.mass(v)) * x[d];
+    }
   }
 }
 
 //----------------------------------------------------------
 
-static std::set<long> areParents;
+void initializeCoarseLayer(CsrGraphView<FloatType>& layout_graph,
+                           CsrGraph<FloatType>& coarse,
+                           const CsrGraph<FloatType>& full,
+                           const GraphCoarsening& coarsening,
+                           NodeContainer& nodes, const LevelMap& levels,
+                           const ParentMap& parents, const Grid_t& grid,
+                           unsigned int currentLevel,
+                           FloatType placementDistance,
+                           FloatType placementRadius) {
+  typedef NodeContainer::size_type size_type;
+  const unsigned int k = coarsening.depth() - currentLevel;
+  const size_type vertexCount = nodes.size();
 
-bool doesVertexHaveAnyChildren(Graph<FloatType>& G,
-                               Graph<FloatType>::vertex_descriptor v,
-                               out_graph& g, ParentMap& parents) {
-  if (areParents.empty()) {
-    // Generate list for the first time
-    for (ParentMap::size_type ii = 0; ii < parents.size(); ++ii) {
-      if (parents[ii] >= 0) areParents.insert(parents[ii]);
-    }
+  // Swap in the edges of this level, which aren't a superset of the last
+  if (k == 0) {
+    coarse.clear();
+    layout_graph = CsrGraphView<FloatType>(full);
+  } else {
+    coarse = CsrGraph<FloatType>(vertexCount, coarsening.edges(k),
+                                 std::vector<FloatType>());
+    layout_graph = CsrGraphView<FloatType>(coarse);
   }
 
-  typedef out_graph::out_edge_iterator oei;
-
-  oei e, eend;
-  tie(e, eend) = out_edges(v, g);
+  // The new vertices of each representative go on a small sphere around it,
+  // and those of the coarsest graph on one around the center of the grid
+  std::vector<std::pair<size_type, size_type> > children;
+  std::vector<size_type> roots;
+  for (size_type v = 0; v < vertexCount; ++v) {
+    if (levels[v] != currentLevel || nodes.isAnchor(v)) continue;
+    if (currentLevel == 1) {
+      roots.push_back(v);
+    } else {
+      children.push_back(std::make_pair(parents[v], v));
+    }
+  }
+  std::sort(children.begin(), children.end());
 
-  // Go through all child vertices to see if they
-  // have any of their own.
-  for (; e != eend; ++e) {
-    Graph<FloatType>::vertex_descriptor other = target(*e, g);
-    if (areParents.find(other) != areParents.end()) {
-      return true;
+  std::vector<Sphere::vec_type> x;
+  if (!roots.empty()) {
+    Sphere::vec_type center(NodeContainer::n_dimensions_);
+    for (unsigned int d = 0; d < center.size(); ++d) {
+      center[d] = (grid.min()[d] + grid.max()[d]) * .5;
+    }
+    Sphere s(center);
+    s.radius(roots.size() == 1
+                 ? 0
+                 : placementFormula(placementDistance, roots.size(),
+                                    NodeContainer::n_dimensions_));
+    seriesOfPointsOnSphere(s, roots.size(), x);
+    for (size_type ii = 0; ii < roots.size(); ++ii) {
+      nodes.X(roots[ii], x[ii].begin(), x[ii].end());
+    }
+  }
+  for (size_type first = 0, last; first < children.size(); first = last) {
+    const size_type p = children[first].first;
+    for (last = first; last < children.size() && children[last].first == p;
+         ++last) {
+    }
+    const FixedVec_p parentNode = nodes.X(p);
+    Sphere::vec_type spot(parentNode.begin(), parentNode.end());
+    Sphere s(spot);
+    s.radius(placementRadius);
+    seriesOfPointsOnSphere(s, last - first, x);
+    for (size_type ii = first; ii < last; ++ii) {
+      const size_type v = children[ii].second;
+      nodes.X(v, x[ii - first].begin(), x[ii - first].end());
     }
   }
+}
+
+//----------------------------------------------------------
 
-  // cout << G.idFromIndex(v) <<  " has no children.\n";
-  return false;
+unsigned int setCoarseLevels(const GraphCoarsening& coarsening,
+                             LevelMap& levels, ParentMap& parents) {
+  const unsigned int depth = coarsening.depth();
+  for (LevelMap::size_type v = 0; v < levels.size(); ++v) {
+    levels[v] = depth - coarsening.coarsest(v);
+    parents[v] = coarsening.representative(v);
+  }
+  return depth;
 }
 
 //----------------------------------------------------------
@@ -502,20 +877,23 @@ FloatType collectOutput(ThreadArgs* args, PCChaperone& chaperone) {
 
 //----------------------------------------------------------
 
-FixedVec_p calcCenterOfMass(Graph<FloatType>& g, NodeContainer& nodes,
-                            LevelMap& levels, unsigned int currentLevel) {
+FixedVec_p calcCenterOfMass(const CsrGraphView<FloatType>& g,
+                            const LevelIndex& index, NodeContainer& nodes,
+                            unsigned int currentLevel) {
+  typedef LevelIndex::vertex_descriptor vertex_descriptor;
   FixedVec_p center(0);
   FloatType totalMass = 0;
-  Graph<FloatType>::vertex_iterator vi, vend;
-  for (tie(vi, vend) = vertices(g.boostGraph()); vi != vend; ++vi) {
-    if (levels[*vi] >= currentLevel) {
-      continue;
+  for (unsigned int l = 0; l < currentLevel; ++l) {
+    for (const vertex_descriptor* v = index.verticesBegin(l);
+         v != index.verticesEnd(l); ++v) {
+      if (!g.hasVertex(*v)) {
+        continue;
+      }
+      FixedVec_p location(nodes.X(*v));
+      location.scale(nodes.mass(*v));
+      center += location;
+      totalMass += nodes.mass(*v);
     }
-    Node& n = nodes[*vi];
-    FixedVec_p location(n.X());
-    location.scale(n.mass());
-    center += location;
-    totalMass += n.mass();
   }
   center.scale(1.0 / totalMass);
   return center;
@@ -553,10 +931,10 @@ void gridPrepAndInit(NodeContainer& nc, Grid_t& nw, FloatType voxelLength) {
   FixedVec_p maxs;
 
   // First job is to determine the size of the grid.
-  mins = nc[0].X();
-  maxs = nc[0].X();
+  mins = nc.X(0);
+  maxs = nc.X(0);
   for (size_type ii = 1; ii < nc.size(); ++ii) {
-    const FixedVec_p& x = nc[ii].X();
+    const FixedVec_p x = nc.X(ii);
     // Get info on mins and maxes
     for (size_type jj = 0; jj < x.size(); ++jj) {
       // Min check
@@ -566,9 +944,10 @@ void gridPrepAndInit(NodeContainer& nc, Grid_t& nw, FloatType voxelLength) {
     }
   }
 
-  // Just adding some pad onto the grid.
+  // Just adding some pad onto the grid. It grows when particles leave it
+  // (see regrowGrid), so this needn't cover the whole layout.
   for (size_type jj = 0; jj < mins.size(); ++jj) {
-    FloatType span = 1.00 * (maxs[jj] - mins[jj]);
+    FloatType span = .25 * (maxs[jj] - mins[jj]);
     mins[jj] -= span;
     maxs[jj] += span;
   }
@@ -592,31 +971,38 @@ EllipseFactors parseEllipseFactors(const std::string& optionStr) {
 
 //----------------------------------------------------------
 
+Integrator parseIntegrator(const std::string& optionStr) {
+  if (optionStr == "first") return Integrator::kFirstOrder;
+  if (optionStr == "verlet") return Integrator::kVerlet;
+  if (optionStr == "fire") return Integrator::kFire;
+  throw std::invalid_argument("Unknown integrator " + optionStr);
+}
+
+//----------------------------------------------------------
+
 void interpolateUninitializedPositions(PCChaperone& chaperone,
-                                       const Graph<FloatType>::boost_graph& g,
+                                       const CsrGraph<FloatType>& g,
                                        bool remove_disconnected_nodes) {
   std::size_t num_uninitialized_positions_still,
       num_uninitialized_positions_before;
   do {
     num_uninitialized_positions_before = num_uninitialized_positions_still = 0;
     for (std::size_t ii = 0; ii < chaperone.pc_.size(); ++ii) {
-      if (!chaperone.pc_[ii].isPositionInitialized()) {
+      if (!chaperone.pc_.isPositionInitialized(ii)) {
         ++num_uninitialized_positions_before;
         std::size_t count_initialized_neighbors = 0;
-        Graph<FloatType>::out_edge_iterator eb, ee;
-        for (tie(eb, ee) = out_edges(ii, g); eb != ee; ++eb) {
-          const auto src = source(*eb, g), tgt = target(*eb, g);
-          assert(src == ii || tgt == ii);
-          const auto other = src == ii ? tgt : src;
-          if (chaperone.pc_[other].isPositionInitialized()) {
+        for (auto n = g.neighboursBegin(ii); n != g.neighboursEnd(ii); ++n) {
+          const auto other = *n;
+          if (chaperone.pc_.isPositionInitialized(other)) {
             ++count_initialized_neighbors;
-            for (std::size_t dim = 0; dim < chaperone.pc_[ii].X().size(); ++dim)
-              chaperone.pc_[ii].x[dim] += chaperone.pc_[other].X()[dim];
+            for (unsigned int dim = 0; dim < NodeContainer::n_dimensions_;
+                 ++dim)
+              chaperone.pc_.x(ii, dim) += chaperone.pc_.x(other, dim);
           }
         }
         if (count_initialized_neighbors)
-          for (float& coord : chaperone.pc_[ii].x)
-            coord /= count_initialized_neighbors;
+          for (unsigned int dim = 0; dim < NodeContainer::n_dimensions_; ++dim)
+            chaperone.pc_.x(ii, dim) /= count_initialized_neighbors;
         else {
           ++num_uninitialized_positions_still;
         }
@@ -637,13 +1023,13 @@ void interpolateUninitializedPositions(PCChaperone& chaperone,
               << " nodes that are DISCONNECTED from any nodes which had their "
                  "positions initialized!\nTHOSE NODES ARE:\n";
     for (std::size_t ii = 0; ii < chaperone.pc_.size(); ++ii)
-      if (!chaperone.pc_[ii].isPositionInitialized())
-        std::cout << '\t' << chaperone.pc_[ii].id() << '\n';
+      if (!chaperone.pc_.isPositionInitialized(ii))
+        std::cout << '\t' << chaperone.pc_.id(ii) << '\n';
     if (remove_disconnected_nodes) {
       std::cout
           << "Removing them from the graph before further processing...\n";
       for (std::size_t ii = chaperone.pc_.size(); ii > 0; --ii)
-        if (!chaperone.pc_[ii - 1].isPositionInitialized())
+        if (!chaperone.pc_.isPositionInitialized(ii - 1))
           chaperone.pc_.erase(ii - 1);
     }
     std::cout << std::endl;
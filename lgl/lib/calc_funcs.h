@@ -16,11 +16,13 @@
 #include "boost/graph/kruskal_min_spanning_tree.hpp"
 #include "boost/graph/visitors.hpp"
 #include "boost/property_map/property_map.hpp"
+#include "coarsening.h"
 #include "configs.h"
+#include "convergence.h"
+#include "csr_graph.h"
 #include "fixed_vec.h"
 #include "grid.h"
 #include "lgl/lib/particle_interaction_handler.h"
-#include "particle.h"
 #include "particle_container.h"
 #include "particle_container_chaperone.h"
 #include "sphere.h"
@@ -31,37 +33,71 @@
 namespace lgl {
 namespace lib {
 
-typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS>
-    out_graph;
 typedef std::vector<FloatType> EllipseFactors;
 
 struct ThreadArgs {
   NodeContainer* nodes;
   VoxelHandler* voxelHandler;
+  // Set up for the repulsive terms (casual spring constant, nbhdRadius)
   NodeInteractionHandler* nodeHandler;
-  FixedVec_l* voxelList;
+  // Set up for the edges (special spring constant, eqDistance)
+  NodeInteractionHandler* edgeHandler;
+  unsigned int currentColor;
   ParticleStats_t* stats;
-  long voxelListSize;
   Grid_t* grid;
+  GridSchedule_t* schedule;
+  // The particles that left the grid in the last integration step, and the
+  // box around them
+  long escapes;
+  FixedVec_p escapeMin;
+  FixedVec_p escapeMax;
+  // How the particles moved in the last integration step: the square of
+  // the longest move, and the sum of the squared forces over the particles
+  // that moved
+  FloatType maxMove;
+  FloatType force2;
+  long moved;
+  // The mass-weighted sum of where this thread placed the vertices of the
+  // tree levels and of how far it moved the particles it integrated, over
+  // the whole layout, for the center of mass of the placed vertices
+  FixedVec<double, n_dimensions> moment;
   FloatType eqDistance;
   EllipseFactors ellipseFactors;
-  GridIterator* gridIterator;
   long threadCount;
   long whichThread;
   FloatType nbhdRadius;
   FloatType casualSpringConstant;
   FloatType specialSpringConstant;
-  Graph<FloatType>* full_graph;
-  Graph<FloatType>* layout_graph;
+  const CsrGraph<FloatType>* full_graph;
+  CsrGraphView<FloatType>* layout_graph;
+  // The coarse graph of the current level of a multilevel layout, which
+  // layout_graph is a view of
+  CsrGraph<FloatType>* coarse_graph;
+  // Flat copy of layout_graph, shared by all threads
+  LayoutEdges_t* layoutEdges;
+  // Long-range repulsion, shared by all threads, or null if it is off
+  BarnesHutTree_t* farField;
+  // The hierarchy of a multilevel layout, or null for the tree levels
+  const GraphCoarsening* coarsening;
   LevelMap* levels;
   ParentMap* parents;
+  // The vertices of full_graph by level, those of the tree levels or of the
+  // coarse graphs, or null if there are no levels to go through
+  const LevelIndex* levelIndex;
   unsigned int currentLevel;
+  // The particles that take part in the current level, in the order they
+  // came in, shared by all threads: the placed ones, and any others in the
+  // grid
+  const std::vector<NodeContainer::size_type>* active;
 };
 
+void* countCellOccupants(void* arg);
+void* scatterCellOccupants(void* arg);
+void* sortCellOccupants(void* arg);
 void* calcInteractions(void* arg);
 void* integrateParticles(void* arg);
 void* onlyEdgeInteractions(void* arg);
-void* collectEdgeStats(void* arg);
+void* farFieldInteractions(void* arg);
 
 int generateMSTFromNodes(NodeContainer& nodes, ThreadArgs* args, long p);
 
@@ -70,32 +106,86 @@ void beginSimulation(ThreadContainer& threads, FloatType cutOffPrecision,
                      TimeKeeper& timer, ThreadArgs* threadArgs,
                      PCChaperone& chaperone, unsigned int totalLevels, bool b,
                      FloatType placementDistance, FloatType placementRadius,
-                     bool placeLeafsClose, bool silentOutput);
+                     bool placeLeafsClose, bool silentOutput,
+                     int reorderInterval,
+                     const ConvergenceMonitor& convergence);
 
 void adjustWeightsBasedOnChildrenCount(NodeContainer& nodes);
 void solidifyLargeEdges(NodeContainer& nodes);
 
-FixedVec_p calcCenterOfMass(Graph<FloatType>& g, NodeContainer& nodes,
-                            LevelMap& levels, unsigned int currentLevel);
-
-void initializeCurrentLayer(Graph<FloatType>& g, NodeContainer& nodes,
-                            LevelMap& levels, ParentMap& p, Grid_t& grid,
-                            unsigned int currentLevel, Graph<FloatType>& full,
-                            FloatType placementDistance,
-                            FloatType placementRadius, bool placeLeafsClose);
+// The center of mass of the vertices of g before currentLevel, found
+// through index, the level index of the graph g views. A layout keeps a
+// running one instead, see ThreadArgs::moment.
+FixedVec_p calcCenterOfMass(const CsrGraphView<FloatType>& g,
+                            const LevelIndex& index, NodeContainer& nodes,
+                            unsigned int currentLevel);
+
+// Where the children of a tree level go: on a sphere around a spot by each
+// parent, the points drawn as seriesOfPointsOnSphere would draw them. All
+// the draws of rand() are made up front, in the order a serial placement
+// would make them, so that the children can be placed on any number of
+// threads and still go where they would on one.
+struct LayerPlacement {
+  void clear() {
+    children.clear();
+    groups.clear();
+    firstDraws.clear();
+    draws.clear();
+    spots.clear();
+  }
+
+  // The children to place, by parent and then in ascending order
+  std::vector<unsigned> children;
+  // The index in spots of the parent of each, and where its draws start
+  std::vector<unsigned> groups;
+  std::vector<std::size_t> firstDraws;
+  std::vector<int> draws;
+  // The centers of the spheres, one per parent
+  std::vector<Sphere::vec_type> spots;
+  FloatType radius = 1;
+};
 
-long activeEdgeCount(Node& n);
+// Works out where the vertices of currentLevel go, leaving the placing to
+// layerNPlacement. The children of a parent go placementFormula away from
+// it, or right by it if placeLeafsClose and none of them has children, in
+// the direction away from cm, the center of mass of the levels before.
+void initializeCurrentLayer(const CsrGraphView<FloatType>& g,
+                            const LevelIndex& index, NodeContainer& nodes,
+                            const ParentMap& parents, unsigned int currentLevel,
+                            const FixedVec_p& cm, FloatType placementDistance,
+                            FloatType placementRadius, bool placeLeafsClose,
+                            LayerPlacement& placement);
+
+// Places the share of placement of thread whichThread of threadCount, and
+// adds the mass-weighted positions it gave them to moment.
+void layerNPlacement(const LayerPlacement& placement, NodeContainer& nodes,
+                     long whichThread, long threadCount,
+                     FixedVec<double, n_dimensions>& moment);
+
+// The multilevel counterpart of addNextLevelFromMap and
+// initializeCurrentLayer: makes g the coarse graph of the current level and
+// places the vertices that are new to it around their representatives. g
+// views full, or coarse, which holds the coarse graph. Expects the levels
+// and parents to be set with setCoarseLevels.
+void initializeCoarseLayer(CsrGraphView<FloatType>& g,
+                           CsrGraph<FloatType>& coarse,
+                           const CsrGraph<FloatType>& full,
+                           const GraphCoarsening& coarsening,
+                           NodeContainer& nodes, const LevelMap& levels,
+                           const ParentMap& parents, const Grid_t& grid,
+                           unsigned int currentLevel,
+                           FloatType placementDistance,
+                           FloatType placementRadius);
+
+// Layout level l of a multilevel layout is coarse graph depth() - l, so the
+// vertices of the coarsest graph are at level 1. Returns the level count.
+unsigned int setCoarseLevels(const GraphCoarsening& coarsening,
+                             LevelMap& levels, ParentMap& parents);
 
 FloatType activateNextLayerOfEdges(NodeContainer& n, unsigned int currentLevel,
                                    ThreadArgs* threadArgs);
-FloatType getBufferDistance(Node& n);
 void printOutput(long i, FloatType d, long ll, std::ostream& o);
 
-void layerNPlacement(NodeContainer& nodes, Grid_t& grid, out_graph& g,
-                     FixedVec_p& cm, unsigned int currentLevel,
-                     ParentMap& parents, Graph<FloatType>& full, LevelMap& lm,
-                     FloatType placementDistance, FloatType placementRadius,
-                     bool placeLeafsClose);
 void generatePlacementVector(FixedVec_p& d, const FixedVec_p& parentNode,
                              const FixedVec_p& parentParentNode,
                              const FixedVec_p& cm);
@@ -103,12 +193,12 @@ FloatType placementFormula(FloatType placementDistance, int vertices2place,
                            int dimension);
 
 void gridPrepAndInit(NodeContainer& nc, Grid_t& g, FloatType voxelLength);
-bool doesVertexHaveAnyChildren(Graph<FloatType>& G,
-                               Graph<FloatType>::vertex_descriptor v,
-                               out_graph& g, ParentMap& parents);
 
 EllipseFactors parseEllipseFactors(const std::string& optionStr);
 
+// The integrator named first, verlet or fire (see Integrator).
+Integrator parseIntegrator(const std::string& optionStr);
+
 // Attempts to initialize any particle positions that are not initialized yet,
 // by way of interpolation from its neighbors which have initialized positions
 // already, if any. This is done by picking the "center point" of those
@@ -118,7 +208,7 @@ EllipseFactors parseEllipseFactors(const std::string& optionStr);
 // to isolated and totally uninitialized islands). Also, the progress of the
 // stages and the final accomplishment is printed to stdout.
 void interpolateUninitializedPositions(PCChaperone& chaperone,
-                                       const Graph<FloatType>::boost_graph& g,
+                                       const CsrGraph<FloatType>& g,
                                        bool remove_disconnected_nodes);
 
 }  // namespace lib
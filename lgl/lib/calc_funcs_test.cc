@@ -0,0 +1,107 @@
+#include "lgl/lib/calc_funcs.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lgl {
+namespace lib {
+namespace {
+
+typedef LevelIndex::vertex_descriptor vertex_descriptor;
+typedef CsrGraph<FloatType>::Edge Edge;
+
+const FloatType kPlacementDistance = 2;
+const FloatType kPlacementRadius = 0.5;
+
+// A tree with 0 at its root and 1 and 4 under it. At level 2, 1 has a leaf,
+// 2, and a parent, 3, for children, and 4 only the leafs 6 and 7.
+class LayerPlacementTest : public ::testing::Test {
+ protected:
+  LayerPlacementTest()
+      : tree(8,
+             std::vector<Edge>{Edge(0, 1), Edge(0, 4), Edge(1, 2), Edge(1, 3),
+                               Edge(3, 5), Edge(4, 6), Edge(4, 7)},
+             std::vector<FloatType>()),
+        levels{0, 1, 2, 2, 1, 3, 2, 2},
+        parents{0, 0, 1, 1, 0, 3, 4, 4},
+        index(tree, levels, parents),
+        nodes(tree.vertexCount()) {
+    const FloatType x[][2] = {{0, 0}, {1, 0}, {0, 0}, {0, 0},
+                              {0, 1}, {0, 0}, {0, 0}, {0, 0}};
+    for (vertex_descriptor v = 0; v < tree.vertexCount(); ++v) {
+      FixedVec_p at(0);
+      at[0] = x[v][0];
+      at[1] = x[v][1];
+      nodes.X(v, at.begin(), at.end());
+      nodes.mass(v, 1);
+    }
+  }
+
+  // Works out level 2 and places it on one thread
+  void PlaceLevel2(bool placeLeafsClose) {
+    const CsrGraphView<FloatType> view(tree, levels, 2);
+    initializeCurrentLayer(view, index, nodes, parents, 2,
+                           calcCenterOfMass(view, index, nodes, 2),
+                           kPlacementDistance, kPlacementRadius,
+                           placeLeafsClose, placement);
+    FixedVec<double, n_dimensions> moment = 0;
+    layerNPlacement(placement, nodes, 0, 1, moment);
+  }
+
+  // The spot child was placed around
+  Sphere::vec_type SpotOf(vertex_descriptor child) const {
+    for (std::size_t ii = 0; ii < placement.children.size(); ++ii) {
+      if (placement.children[ii] == child) {
+        return placement.spots[placement.groups[ii]];
+      }
+    }
+    ADD_FAILURE() << child << " was not placed";
+    return Sphere::vec_type(NodeContainer::n_dimensions_, 0);
+  }
+
+  FloatType Distance(const Sphere::vec_type& spot, vertex_descriptor v) const {
+    const FixedVec_p x = nodes.X(v);
+    FloatType d2 = 0;
+    for (unsigned int ii = 0; ii < NodeContainer::n_dimensions_; ++ii) {
+      d2 += (spot[ii] - x[ii]) * (spot[ii] - x[ii]);
+    }
+    return std::sqrt(d2);
+  }
+
+  CsrGraph<FloatType> tree;
+  LevelMap levels;
+  ParentMap parents;
+  LevelIndex index;
+  NodeContainer nodes;
+  LayerPlacement placement;
+};
+
+TEST_F(LayerPlacementTest, ChildrenGoPlacementDistanceAway) {
+  PlaceLevel2(false);
+  for (vertex_descriptor v : {2, 3}) {
+    EXPECT_NEAR(kPlacementDistance, Distance(SpotOf(v), 1), 1e-5) << v;
+    EXPECT_NEAR(kPlacementRadius, Distance(SpotOf(v), v), 1e-5) << v;
+  }
+  for (vertex_descriptor v : {6, 7}) {
+    EXPECT_NEAR(kPlacementDistance, Distance(SpotOf(v), 4), 1e-5) << v;
+    EXPECT_NEAR(kPlacementRadius, Distance(SpotOf(v), v), 1e-5) << v;
+  }
+}
+
+TEST_F(LayerPlacementTest, OnlyLeafsGoCloseToTheirParent) {
+  PlaceLevel2(true);
+  // 3 has a child of its own, so neither it nor the leaf 2 goes close
+  for (vertex_descriptor v : {2, 3}) {
+    EXPECT_NEAR(kPlacementDistance, Distance(SpotOf(v), 1), 1e-5) << v;
+  }
+  for (vertex_descriptor v : {6, 7}) {
+    EXPECT_NEAR(0, Distance(SpotOf(v), 4), 1e-5) << v;
+    EXPECT_NEAR(kPlacementRadius, Distance(SpotOf(v), v), 1e-5) << v;
+  }
+}
+
+}  // namespace
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,132 @@
+#include "coarsening.h"
+
+#include <algorithm>
+
+namespace lgl {
+namespace lib {
+
+namespace {
+
+// The current graph as adjacency arrays over the original vertex indices.
+struct Adjacency {
+  std::vector<std::size_t> offsets;
+  std::vector<unsigned int> targets;
+
+  Adjacency(std::size_t vertexCount,
+            const GraphCoarsening::EdgeList& edges) {
+    offsets.assign(vertexCount + 1, 0);
+    for (const GraphCoarsening::Edge& e : edges) {
+      ++offsets[e.first + 1];
+      ++offsets[e.second + 1];
+    }
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+      offsets[v + 1] += offsets[v];
+    }
+    targets.resize(offsets[vertexCount]);
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const GraphCoarsening::Edge& e : edges) {
+      targets[cursor[e.first]++] = e.second;
+      targets[cursor[e.second]++] = e.first;
+    }
+  }
+
+  std::size_t degree(unsigned int v) const {
+    return offsets[v + 1] - offsets[v];
+  }
+};
+
+const unsigned int kUnmatched = ~0u;
+
+}  // namespace
+
+void GraphCoarsening::build(const CsrGraph<FloatType>& g,
+                            std::size_t minVertices) {
+  const std::size_t vertexCount = g.vertexCount();
+  edges_.clear();
+  coarsest_.assign(vertexCount, 0);
+  representative_.resize(vertexCount);
+  for (std::size_t v = 0; v < vertexCount; ++v) representative_[v] = v;
+  vertexCounts_.assign(1, vertexCount);
+
+  EdgeList current;
+  current.reserve(g.edgeCount());
+  for (unsigned int s = 0; s < vertexCount; ++s) {
+    for (const unsigned int* t = g.neighboursBegin(s); t != g.neighboursEnd(s);
+         ++t) {
+      if (s < *t) current.push_back(Edge(s, *t));
+    }
+  }
+
+  std::vector<unsigned int> alive(vertexCount);
+  for (std::size_t v = 0; v < vertexCount; ++v) alive[v] = v;
+  std::vector<unsigned int> match(vertexCount, kUnmatched);
+
+  while (alive.size() > minVertices) {
+    const Adjacency adj(vertexCount, current);
+
+    // Low degrees first, so the hubs are left to be the representatives
+    std::stable_sort(alive.begin(), alive.end(),
+                     [&adj](unsigned int a, unsigned int b) {
+                       return adj.degree(a) < adj.degree(b);
+                     });
+    for (unsigned int u : alive) {
+      if (match[u] != kUnmatched) continue;
+      unsigned int best = kUnmatched;
+      for (std::size_t ii = adj.offsets[u]; ii < adj.offsets[u + 1]; ++ii) {
+        const unsigned int w = adj.targets[ii];
+        if (match[w] == kUnmatched &&
+            (best == kUnmatched || adj.degree(w) < adj.degree(best))) {
+          best = w;
+        }
+      }
+      if (best != kUnmatched) {
+        const bool keepU = adj.degree(u) > adj.degree(best);
+        match[u] = keepU ? u : best;
+        match[best] = match[u];
+      } else if (adj.degree(u) == 1) {
+        const unsigned int w = adj.targets[adj.offsets[u]];
+        match[u] = match[w];
+      }
+    }
+
+    const std::size_t k = vertexCounts_.size();
+    std::vector<unsigned int> next;
+    for (unsigned int v : alive) {
+      if (match[v] == kUnmatched || match[v] == v) {
+        next.push_back(v);
+        coarsest_[v] = k;
+      } else {
+        representative_[v] = match[v];
+      }
+    }
+    // Not worth another level
+    if (next.size() > alive.size() * 19 / 20) {
+      for (unsigned int v : alive) {
+        representative_[v] = v;
+        coarsest_[v] = k - 1;
+      }
+      break;
+    }
+
+    EdgeList coarse;
+    coarse.reserve(current.size());
+    for (const Edge& e : current) {
+      const unsigned int a = match[e.first] == kUnmatched ? e.first
+                                                          : match[e.first];
+      const unsigned int b = match[e.second] == kUnmatched ? e.second
+                                                           : match[e.second];
+      if (a != b) coarse.push_back(Edge(std::min(a, b), std::max(a, b)));
+    }
+    std::sort(coarse.begin(), coarse.end());
+    coarse.erase(std::unique(coarse.begin(), coarse.end()), coarse.end());
+
+    for (unsigned int v : alive) match[v] = kUnmatched;
+    alive.swap(next);
+    current.swap(coarse);
+    edges_.push_back(current);
+    vertexCounts_.push_back(alive.size());
+  }
+}
+
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,59 @@
+#ifndef LGL_LIB_COARSENING_H_
+#define LGL_LIB_COARSENING_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+// A hierarchy of ever coarser versions of a graph, for a multilevel layout.
+// Every step matches up neighbouring vertices and merges each match into one
+// of its vertices, its representative. Leaves without a free neighbour get
+// merged into their neighbour anyway, so stars shrink too. That way every
+// coarse graph is a graph on a subset of the original vertices, and the
+// layout can go from the coarsest to the original graph on the same
+// particles, placing each vertex next to its representative as it shows up.
+//
+// Graph 0 is the original graph and graph depth() - 1 the coarsest.
+class GraphCoarsening {
+ public:
+  typedef std::pair<unsigned int, unsigned int> Edge;
+  typedef std::vector<Edge> EdgeList;
+
+  // Coarsens g until at most minVertices are left, or a step no longer
+  // shrinks the graph by much (e.g. when it has many components).
+  void build(const CsrGraph<FloatType>& g, std::size_t minVertices);
+
+  unsigned int depth() const { return edges_.size() + 1; }
+
+  // The edges of coarse graph k, for 0 < k < depth(). Each edge is only
+  // listed once.
+  const EdgeList& edges(unsigned int k) const { return edges_[k - 1]; }
+
+  // The coarsest graph that v is still part of.
+  unsigned int coarsest(unsigned int v) const { return coarsest_[v]; }
+
+  // The vertex v got merged into, or v itself if it made it to the
+  // coarsest graph.
+  unsigned int representative(unsigned int v) const {
+    return representative_[v];
+  }
+
+  std::size_t vertexCount(unsigned int k) const { return vertexCounts_[k]; }
+
+ private:
+  std::vector<EdgeList> edges_;
+  std::vector<unsigned int> coarsest_;
+  std::vector<unsigned int> representative_;
+  std::vector<std::size_t> vertexCounts_;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_COARSENING_H_
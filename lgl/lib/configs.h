@@ -6,10 +6,11 @@
 #include <set>
 #include <vector>
 
+#include "barnes_hut.h"
 #include "graph.h"
 #include "grid.h"
 #include "grid_schedule.h"
-#include "particle.h"
+#include "layout_edges.h"
 #include "particle_container.h"
 #include "particle_container_chaperone.h"
 #include "particle_interaction_handler.h"
@@ -29,9 +30,8 @@ const unsigned int DIMENSION = 2;
 
 const Dimension n_dimensions = k2Dimensions;
 
-typedef Particle<n_dimensions> Node;
 typedef ParticleContainer<n_dimensions> NodeContainer;
-typedef Grid<Particle<n_dimensions>> Grid_t;
+typedef Grid<NodeContainer> Grid_t;
 typedef FixedVec<FloatType, n_dimensions> FixedVec_p;
 typedef FixedVec<long, n_dimensions> FixedVec_l;
 typedef GridIter<Grid_t> GridIterator;
@@ -41,7 +41,9 @@ typedef Voxel<n_dimensions> Voxel_t;
 typedef ParticleInteractionHandler<n_dimensions> NodeInteractionHandler;
 typedef VoxelInteractionHandler<n_dimensions> VoxelHandler;
 typedef GridSchedule_MTS<Grid_t> GridSchedule_t;
-typedef ParticleStats<Particle<n_dimensions>> ParticleStats_t;
+typedef ParticleStats<NodeContainer> ParticleStats_t;
+typedef LayoutEdges<n_dimensions> LayoutEdges_t;
+typedef BarnesHutTree<n_dimensions> BarnesHutTree_t;
 // typedef Graph<FloatType> Graph_t;
 typedef std::vector<unsigned> LevelMap;
 typedef std::vector<unsigned> ParentMap;
@@ -0,0 +1,118 @@
+#include "convergence.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace lgl {
+namespace lib {
+
+namespace {
+
+// What the values start out as, so the first iteration never counts as
+// settled
+const FloatType kUnsettled = 10000000.;
+
+const char* criterionName(StopCriterion c) {
+  switch (c) {
+    case StopCriterion::kEdgeLength:
+      return "edge length";
+    case StopCriterion::kMaxMove:
+      return "largest move";
+    case StopCriterion::kForce:
+      return "mean squared force";
+  }
+  return "";
+}
+
+}  // namespace
+
+FloatType ConvergenceMonitor::tolerance() const {
+  if (tolerance_ > 0) return tolerance_;
+  return criterion_ == StopCriterion::kMaxMove ? .01 : .005;
+}
+
+void ConvergenceMonitor::startLevel(std::size_t newNodes) {
+  levelBudget_ = budgetBase_ + static_cast<unsigned int>(
+                                   std::ceil(budgetPerNode_ * newNodes));
+  iterations_ = 0;
+  reason_ = Reason::kRunning;
+  values_.assign(1, kUnsettled);
+  previousAverage_ = 0;
+}
+
+FloatType ConvergenceMonitor::average(FloatType value) const {
+  FloatType sum = value;
+  unsigned int count = 1;
+  for (auto v = values_.rbegin(); v != values_.rend() && count < window_;
+       ++v, ++count) {
+    sum += *v;
+  }
+  return sum / count;
+}
+
+bool ConvergenceMonitor::update(FloatType value) {
+  // The motion is that of the last step, and nothing has moved yet the
+  // first time
+  if (criterion_ != StopCriterion::kEdgeLength && iterations_ == 0) {
+    ++iterations_;
+    return false;
+  }
+  const FloatType avg = average(value);
+  if (criterion_ == StopCriterion::kMaxMove) {
+    if (value < tolerance()) reason_ = Reason::kBelowTolerance;
+  } else if (criterion_ == StopCriterion::kForce) {
+    // Nothing moving at all is settled too
+    if (value <= 0 || std::abs(previousAverage_ - avg) / avg < tolerance()) {
+      reason_ = Reason::kAveragesSettled;
+    }
+  } else if (std::abs(value - values_.back()) / value < precision_) {
+    reason_ = Reason::kSettled;
+  } else if (std::abs(previousAverage_ - avg) / avg < .1 * precision_) {
+    reason_ = Reason::kAveragesSettled;
+  }
+  if (reason_ == Reason::kRunning && iterations_ > levelBudget_) {
+    reason_ = Reason::kBudget;
+  }
+  if (reason_ != Reason::kRunning) return true;
+
+  previousAverage_ = avg;
+  values_.push_back(value);
+  if (values_.size() > window_) values_.pop_front();
+  ++iterations_;
+  return false;
+}
+
+std::string ConvergenceMonitor::describe() const {
+  std::ostringstream o;
+  switch (reason_) {
+    case Reason::kRunning:
+      o << "still running";
+      break;
+    case Reason::kSettled:
+      o << "the " << criterionName(criterion_) << " settled";
+      break;
+    case Reason::kAveragesSettled:
+      o << "the average " << criterionName(criterion_) << " over "
+        << window_ << " iterations settled";
+      break;
+    case Reason::kBelowTolerance:
+      o << "the " << criterionName(criterion_) << " fell below "
+        << tolerance();
+      break;
+    case Reason::kBudget:
+      o << "out of its budget of " << levelBudget_ << " iterations";
+      break;
+  }
+  return o.str();
+}
+
+StopCriterion parseStopCriterion(const std::string& optionStr) {
+  if (optionStr == "edge") return StopCriterion::kEdgeLength;
+  if (optionStr == "move") return StopCriterion::kMaxMove;
+  if (optionStr == "force") return StopCriterion::kForce;
+  throw std::invalid_argument("Unknown stopping criterion " + optionStr);
+}
+
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,101 @@
+#ifndef LGL_LIB_CONVERGENCE_H_
+#define LGL_LIB_CONVERGENCE_H_
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+// What tells that a level has settled, as measured every iteration.
+//  kEdgeLength: the average length of the edges of the layout.
+//  kMaxMove: the longest distance any particle moved in the last step,
+//    relative to the average edge length.
+//  kForce: the mean squared force on the particles in the last step, which
+//    goes with how fast the energy of the layout still decreases.
+enum class StopCriterion { kEdgeLength, kMaxMove, kForce };
+
+// Decides when a level is done. A level has settled once the value of the
+// criterion stops changing: when it changes by less than the precision from
+// one iteration to the next, relative to its value, or when its average
+// over the last window iterations changes by less than a tenth of that.
+// The motion of the particles goes by a tolerance instead: the largest move
+// is too noisy to settle, and stays put at the force limit while the layout
+// is still far off, so it has to drop below the tolerance, and the force
+// decays too steadily, so its average has to change by less than the
+// tolerance. Failing that, the level stops when it runs out of its
+// iteration budget, which is a base plus so many per node the level added.
+//
+// The defaults are what lglayout always did: the edge lengths, a window of
+// 2, and 150 iterations for every level. The tolerance is .01 for the
+// largest move and .005 for the force unless set.
+class ConvergenceMonitor {
+ public:
+  enum class Reason {
+    kRunning,
+    kSettled,
+    kAveragesSettled,
+    kBelowTolerance,
+    kBudget
+  };
+
+  StopCriterion criterion() const { return criterion_; }
+  void criterion(StopCriterion c) { criterion_ = c; }
+
+  FloatType precision() const { return precision_; }
+  void precision(FloatType p) { precision_ = p; }
+
+  FloatType tolerance() const;
+  void tolerance(FloatType t) { tolerance_ = t; }
+
+  unsigned int window() const { return window_; }
+  void window(unsigned int w) { window_ = w < 1 ? 1 : w; }
+
+  void budget(unsigned int base, FloatType perNode) {
+    budgetBase_ = base;
+    budgetPerNode_ = perNode;
+  }
+
+  // Starts over for a level that added newNodes particles.
+  void startLevel(std::size_t newNodes);
+
+  // Takes the value of the criterion for another iteration. Returns true
+  // once the level is done, and reason() says why.
+  bool update(FloatType value);
+
+  Reason reason() const { return reason_; }
+  unsigned int iterations() const { return iterations_; }
+  unsigned int levelBudget() const { return levelBudget_; }
+
+  // Why the level stopped, for the progress output.
+  std::string describe() const;
+
+ private:
+  FloatType average(FloatType value) const;
+
+  StopCriterion criterion_ = StopCriterion::kEdgeLength;
+  FloatType precision_ = .00001;
+  // 0 for that of the criterion
+  FloatType tolerance_ = 0;
+  unsigned int window_ = 2;
+  unsigned int budgetBase_ = 150;
+  FloatType budgetPerNode_ = 0;
+
+  unsigned int levelBudget_ = 0;
+  unsigned int iterations_ = 0;
+  Reason reason_ = Reason::kRunning;
+  // The last values, newest at the back, and the last average
+  std::deque<FloatType> values_;
+  FloatType previousAverage_ = 0;
+};
+
+// The criterion named edge, move or force.
+StopCriterion parseStopCriterion(const std::string& optionStr);
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_CONVERGENCE_H_
@@ -0,0 +1,53 @@
+#ifndef LGL_LIB_COUNTER_RNG_H_
+#define LGL_LIB_COUNTER_RNG_H_
+
+#include <cstdint>
+
+namespace lgl {
+namespace lib {
+
+// The output function of SplitMix64 (Steele, Lea and Flood, 2014). A
+// bijection on 64 bit words that turns consecutive inputs into
+// statistically independent outputs.
+inline std::uint64_t splitMix64(std::uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// A counter-based random number generator: every draw is a hash of the seed
+// and of a key that says what the draw is for, rather than the next value of
+// a shared state. Draws thus come out the same whichever thread makes them
+// and in whatever order, and threads don't have to synchronize for them.
+class CounterRng {
+ public:
+  explicit CounterRng(std::uint64_t seed = 1) : seed_(seed) {}
+
+  std::uint64_t seed() const { return seed_; }
+  void seed(std::uint64_t s) { seed_ = s; }
+
+  // The stream for the key (a, b, c).
+  std::uint64_t stream(std::uint64_t a, std::uint64_t b,
+                       std::uint64_t c) const {
+    return splitMix64(splitMix64(splitMix64(seed_ ^ a) ^ b) ^ c);
+  }
+
+  // The n-th draw of a stream, 64 random bits.
+  static std::uint64_t draw(std::uint64_t stream, std::uint64_t n) {
+    return splitMix64(stream + n);
+  }
+
+  // The top 24 bits of a draw as a float in [0, 1).
+  static float unit(std::uint64_t bits) {
+    return static_cast<float>(bits >> 40) * (1.f / (1u << 24));
+  }
+
+ private:
+  std::uint64_t seed_;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_COUNTER_RNG_H_
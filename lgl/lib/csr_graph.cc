@@ -0,0 +1,232 @@
+#include "csr_graph.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <tuple>
+
+#include "spanning_tree.h"
+#include "tree_search.h"
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph()
+    : offsets(1, 0),
+      edges(0),
+      weight(false),
+      ids(std::make_shared<vertex_index_map>()) {}
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(size_type vertexCount,
+                           const std::vector<Edge>& e,
+                           const std::vector<Weight>& w)
+    : offsets(vertexCount + 1, 0),
+      edges(0),
+      weight(!w.empty()),
+      ids(std::make_shared<vertex_index_map>()) {
+  for (const Edge& x : e) {
+    ++offsets[x.first + 1];
+    if (x.second != x.first) ++offsets[x.second + 1];
+  }
+  for (size_type v = 0; v < vertexCount; ++v) {
+    offsets[v + 1] += offsets[v];
+  }
+  targets.resize(offsets[vertexCount]);
+  if (weight) weights.resize(offsets[vertexCount]);
+  std::vector<size_type> cursor(offsets.begin(), offsets.end() - 1);
+  for (size_type ii = 0; ii < e.size(); ++ii) {
+    const Edge& x = e[ii];
+    size_type a = cursor[x.first]++;
+    targets[a] = x.second;
+    if (weight) weights[a] = w[ii];
+    if (x.second == x.first) continue;
+    a = cursor[x.second]++;
+    targets[a] = x.first;
+    if (weight) weights[a] = w[ii];
+  }
+  sortRows();
+}
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(const Graph<Weight>& g)
+    : edges(g.edgeCount()), weight(g.hasWeights()), ids(g.sharedIdMap()) {
+  typedef typename Graph<Weight>::boost_graph BG;
+  typename Graph<Weight>::out_edge_iterator ei, eend;
+  const BG& bg = g.boostGraph();
+  // The out edges of the boost graph are sets already
+  offsets.reserve(g.vertexCount() + 1);
+  offsets.push_back(0);
+  targets.reserve(2 * g.edgeCount());
+  if (weight) weights.reserve(2 * g.edgeCount());
+  for (size_type v = 0; v < g.vertexCount(); ++v) {
+    for (std::tie(ei, eend) = out_edges(v, bg); ei != eend; ++ei) {
+      targets.push_back(target(*ei, bg));
+      if (weight) weights.push_back(g.getWeight(*ei));
+    }
+    offsets.push_back(targets.size());
+  }
+}
+
+template <typename Weight>
+void CsrGraph<Weight>::sortRows() {
+  const size_type vertexCount = CsrGraph<Weight>::vertexCount();
+  std::vector<std::pair<vertex_descriptor, Weight>> row;
+  size_type out = 0, loops = 0;
+  for (size_type v = 0; v < vertexCount; ++v) {
+    const size_type first = offsets[v], last = offsets[v + 1];
+    offsets[v] = out;
+    if (weight) {
+      // The lightest of the duplicates comes first
+      row.clear();
+      for (size_type ii = first; ii < last; ++ii) {
+        row.push_back(std::make_pair(targets[ii], weights[ii]));
+      }
+      std::sort(row.begin(), row.end());
+      for (size_type ii = 0; ii < row.size(); ++ii) {
+        if (ii > 0 && row[ii].first == row[ii - 1].first) continue;
+        targets[out] = row[ii].first;
+        weights[out] = row[ii].second;
+        ++out;
+      }
+    } else {
+      std::sort(targets.begin() + first, targets.begin() + last);
+      for (size_type ii = first; ii < last; ++ii) {
+        if (ii > first && targets[ii] == targets[ii - 1]) continue;
+        targets[out++] = targets[ii];
+      }
+    }
+    if (std::binary_search(targets.begin() + offsets[v], targets.begin() + out,
+                           static_cast<vertex_descriptor>(v))) {
+      ++loops;
+    }
+  }
+  offsets[vertexCount] = out;
+  if (out < targets.size()) {
+    targets.resize(out);
+    targets.shrink_to_fit();
+    if (weight) {
+      weights.resize(out);
+      weights.shrink_to_fit();
+    }
+  }
+  edges = (out + loops) / 2;
+}
+
+template <typename Weight>
+void CsrGraph<Weight>::clear() {
+  offsets.assign(1, 0);
+  std::vector<vertex_descriptor>().swap(targets);
+  std::vector<Weight>().swap(weights);
+  edges = 0;
+  weight = false;
+  ids = std::make_shared<vertex_index_map>();
+}
+
+template <typename Weight>
+bool CsrGraph<Weight>::doesEdgeExist(vertex_descriptor u,
+                                     vertex_descriptor v) const {
+  if (u >= vertexCount() || v >= vertexCount()) {
+    return false;
+  }
+  return std::binary_search(neighboursBegin(u), neighboursEnd(u), v);
+}
+
+template class CsrGraph<FloatType>;
+
+namespace {
+
+typedef CsrGraph<FloatType>::vertex_descriptor vertex_descriptor;
+typedef CsrGraph<FloatType>::size_type size_type;
+
+}  // namespace
+
+LevelIndex::LevelIndex(const CsrGraph<FloatType>& g,
+                       const std::vector<unsigned>& lm,
+                       const std::vector<unsigned>& parents)
+    : g(&g), levels(&lm), children(g.vertexCount(), 0) {
+  const size_type n = g.vertexCount();
+  unsigned int levelCount = 0;
+  for (size_type v = 0; v < n; ++v) {
+    levelCount = std::max(levelCount, lm[v] + 1);
+  }
+  starts.assign(levelCount + 1, 0);
+  for (size_type v = 0; v < n; ++v) ++starts[lm[v] + 1];
+  for (unsigned int l = 0; l < levelCount; ++l) starts[l + 1] += starts[l];
+  vertices.resize(n);
+  std::vector<size_type> cursor(starts.begin(), starts.end() - 1);
+  for (size_type v = 0; v < n; ++v) vertices[cursor[lm[v]]++] = v;
+  // The vertices at level 0 have no parent
+  for (size_type ii = starts[std::min(1u, levelCount)]; ii < n; ++ii) {
+    ++children[parents[vertices[ii]]];
+  }
+}
+
+void setMSTFromGraph(const CsrGraph<FloatType>& g, CsrGraph<FloatType>& mst,
+                     bool useOriginalWeights, unsigned int threadCount) {
+  const bool original = useOriginalWeights && g.hasWeights();
+  std::vector<WeightedEdge> candidates;
+  candidates.reserve(g.edgeCount());
+  for (vertex_descriptor u = 0; u < g.vertexCount(); ++u) {
+    // Each edge once, from its smaller end, and no loops
+    const vertex_descriptor* v =
+        std::upper_bound(g.neighboursBegin(u), g.neighboursEnd(u), u);
+    const FloatType* w = g.weightsBegin(u) + (v - g.neighboursBegin(u));
+    for (; v != g.neighboursEnd(u); ++v, ++w) {
+      const FloatType weight =
+          original ? *w : -static_cast<FloatType>(g.degree(u) + g.degree(*v));
+      candidates.push_back(WeightedEdge{weight, u, *v});
+    }
+  }
+
+  std::vector<CsrGraph<FloatType>::Edge> tree;
+  std::vector<FloatType> weights;
+  for (const WeightedEdge& e :
+       spanningForest(g.vertexCount(), candidates, threadCount)) {
+    tree.push_back(CsrGraph<FloatType>::Edge(e.u, e.v));
+    weights.push_back(e.w);
+  }
+  mst = CsrGraph<FloatType>(g.vertexCount(), tree, weights);
+  mst.vertexIdMap(g.sharedIdMap());
+}
+
+void setLevelMapFromMST(const CsrGraph<FloatType>& mst,
+                        std::vector<unsigned>& lm,
+                        std::vector<unsigned>& parents,
+                        vertex_descriptor root, unsigned int threadCount) {
+  TreeSearch search(mst, threadCount);
+  search.run(root);
+  lm.swap(search.levels);
+  parents.swap(search.parents);
+}
+
+std::pair<vertex_descriptor, int> generateLevelsFromGraph(
+    const CsrGraph<FloatType>& g, std::vector<unsigned>& levels,
+    std::vector<unsigned>& parents, vertex_descriptor* rootPtr,
+    CsrGraph<FloatType>& mst, bool useOriginalWeights,
+    unsigned int threadCount) {
+  // Now to make a tree based on these weights
+  setMSTFromGraph(g, mst, useOriginalWeights, threadCount);
+  TreeSearch search(mst, threadCount);
+  vertex_descriptor root;
+  if (!rootPtr) {
+    search.run(0);
+    root = search.centre();
+    std::cerr << "root finding done!" << std::endl;
+  } else {
+    root = *rootPtr;
+  }
+  // Generate a breadth first level map
+  search.run(root);
+  levels.swap(search.levels);
+  parents.swap(search.parents);
+  const int maxL = std::max<int>(search.levelStarts.size() - 2, 0);
+  // Return the descriptor to the one that started it all
+  // with the total level count
+  return std::make_pair(root, maxL);
+}
+
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,256 @@
+#ifndef LGL_LIB_CSR_GRAPH_H_
+#define LGL_LIB_CSR_GRAPH_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "id_table.h"
+
+namespace lgl {
+namespace lib {
+
+// An undirected graph in compressed sparse row form: the neighbours of each
+// vertex lie in one flat array, in ascending order, and the weights of the
+// edges in a parallel one. Every edge is kept from both of its ends, a loop
+// once. It can't be changed once built, which is what makes it small: 4
+// bytes an arc, 8 with weights, where the boost graph behind Graph has a
+// std::set node for every arc and a list node for every edge.
+template <typename Weight>
+class CsrGraph {
+ public:
+  typedef unsigned int vertex_descriptor;
+  typedef std::size_t size_type;
+  typedef std::pair<vertex_descriptor, vertex_descriptor> Edge;
+  typedef IdTable vertex_index_map;
+  typedef Weight weight_type;
+
+  CsrGraph();
+
+  // The graph on vertexCount vertices with the given edges, weighted if
+  // weights isn't empty. Of parallel edges the lightest is kept.
+  CsrGraph(size_type vertexCount, const std::vector<Edge>& edges,
+           const std::vector<Weight>& weights);
+
+  // The same graph as g, ids and all
+  explicit CsrGraph(const Graph<Weight>& g);
+
+  // MUTATORS
+  void vertexIdMap(std::shared_ptr<const vertex_index_map> m) {
+    ids = std::move(m);
+  }
+
+  void clear();
+
+  // ACCESSORS
+  size_type vertexCount() const { return offsets.size() - 1; }
+
+  size_type edgeCount() const { return edges; }
+
+  size_type degree(vertex_descriptor v) const {
+    return offsets[v + 1] - offsets[v];
+  }
+
+  const vertex_descriptor* neighboursBegin(vertex_descriptor v) const {
+    return targets.data() + offsets[v];
+  }
+  const vertex_descriptor* neighboursEnd(vertex_descriptor v) const {
+    return targets.data() + offsets[v + 1];
+  }
+
+  // The weights of the edges to the neighbours of v, in the same order.
+  // Only if hasWeights().
+  const Weight* weightsBegin(vertex_descriptor v) const {
+    return weights.data() + offsets[v];
+  }
+
+  bool hasWeights() const { return weight; }
+
+  bool doesEdgeExist(vertex_descriptor u, vertex_descriptor v) const;
+
+  const vertex_index_map& vertexIdMap() const { return *ids; }
+
+  std::shared_ptr<const vertex_index_map> sharedIdMap() const { return ids; }
+
+  const char* idFromIndex(int i) const {
+    if (i < 0 || i >= ids->size()) {
+      throw std::invalid_argument("idFromIndex: no such vertex");
+    }
+    return ids->id(i);
+  }
+  int indexFromId(const std::string& s) const {
+    const int i = ids->find(s);
+    if (i < 0) throw std::invalid_argument("indexFromId: no vertex " + s);
+    return i;
+  }
+
+ private:
+  // Sorts the rows, merges their duplicates and squeezes out the gaps.
+  void sortRows();
+
+  // Where the row of each vertex starts in targets, and one past the end
+  std::vector<size_type> offsets;
+  std::vector<vertex_descriptor> targets;
+  std::vector<Weight> weights;
+  size_type edges;
+  bool weight;
+  std::shared_ptr<const vertex_index_map> ids;
+};
+
+// The part of a CsrGraph that a tree layout has got to by some level: the
+// edges whose later end, by the level map, is at a level in [1, level].
+// That is the layout graph that addNextLevelFromMap grows level by level,
+// without a copy of any of it. Without a level map it is all of the graph.
+template <typename Weight>
+class CsrGraphView {
+ public:
+  typedef typename CsrGraph<Weight>::vertex_descriptor vertex_descriptor;
+  typedef typename CsrGraph<Weight>::size_type size_type;
+
+  CsrGraphView() : g(0), levels(0), level(0) {}
+
+  explicit CsrGraphView(const CsrGraph<Weight>& graph)
+      : g(&graph), levels(0), level(0) {}
+
+  CsrGraphView(const CsrGraph<Weight>& graph,
+               const std::vector<unsigned>& lm, unsigned int l)
+      : g(&graph), levels(&lm), level(l) {}
+
+  size_type vertexCount() const { return g == 0 ? 0 : g->vertexCount(); }
+
+  bool hasEdge(vertex_descriptor u, vertex_descriptor v) const {
+    if (levels == 0) return true;
+    const unsigned int l = std::max((*levels)[u], (*levels)[v]);
+    return l >= 1 && l <= level;
+  }
+
+  // Whether v is a vertex of the view. With a level map only the vertices
+  // with an edge in it are.
+  bool hasVertex(vertex_descriptor v) const {
+    if (levels == 0) return v < vertexCount();
+    if ((*levels)[v] > level) return false;
+    for (const vertex_descriptor* u = g->neighboursBegin(v);
+         u != g->neighboursEnd(v); ++u) {
+      if (hasEdge(v, *u)) return true;
+    }
+    return false;
+  }
+
+  // Calls f with each neighbour that v has an edge to in the view, in
+  // ascending order.
+  template <typename F>
+  void forEachNeighbour(vertex_descriptor v, F f) const {
+    for (const vertex_descriptor* u = g->neighboursBegin(v);
+         u != g->neighboursEnd(v); ++u) {
+      if (hasEdge(v, *u)) f(*u);
+    }
+  }
+
+ private:
+  const CsrGraph<Weight>* g;
+  const std::vector<unsigned>* levels;
+  unsigned int level;
+};
+
+// The vertices of a CsrGraph bucketed by level, by a level map, and so the
+// edges by the level of their later end too: those of level l are the ones
+// from the vertices at l to neighbours no later. Built once, it lets a tree
+// layout take on each level through just its own vertices and their rows,
+// where going by the level map means a pass over the whole graph.
+class LevelIndex {
+ public:
+  typedef CsrGraph<FloatType>::vertex_descriptor vertex_descriptor;
+  typedef CsrGraph<FloatType>::size_type size_type;
+
+  LevelIndex() : g(0), levels(0), starts(1, 0) {}
+
+  // g and lm have to outlive the index, and lm not change but for being
+  // permuted and put back in between uses. parents is the parent map that
+  // goes with lm.
+  LevelIndex(const CsrGraph<FloatType>& g, const std::vector<unsigned>& lm,
+             const std::vector<unsigned>& parents);
+
+  size_type vertexCount() const { return g == 0 ? 0 : g->vertexCount(); }
+
+  // One past the highest level
+  unsigned int levelCount() const { return starts.size() - 1; }
+
+  // The vertices at level l, in ascending order
+  const vertex_descriptor* verticesBegin(unsigned int l) const {
+    return vertices.data() + starts[std::min(l, levelCount())];
+  }
+  const vertex_descriptor* verticesEnd(unsigned int l) const {
+    return vertices.data() + starts[std::min(l + 1, levelCount())];
+  }
+
+  // The vertices whose parent v is
+  unsigned int childCount(vertex_descriptor v) const { return children[v]; }
+
+  // Calls f(v, u) once for each edge whose later end is at level l, v
+  // being that end, in ascending order of v and then of u. An edge with
+  // both ends at l comes from the smaller one.
+  template <typename F>
+  void forEachEdge(unsigned int l, F f) const {
+    for (const vertex_descriptor* v = verticesBegin(l); v != verticesEnd(l);
+         ++v) {
+      for (const vertex_descriptor* u = g->neighboursBegin(*v);
+           u != g->neighboursEnd(*v); ++u) {
+        const unsigned int lu = (*levels)[*u];
+        if (lu < l || (lu == l && *u >= *v)) f(*v, *u);
+      }
+    }
+  }
+
+ private:
+  const CsrGraph<FloatType>* g;
+  const std::vector<unsigned>* levels;
+  // Where the vertices of each level start in vertices, and the end
+  std::vector<size_type> starts;
+  std::vector<vertex_descriptor> vertices;
+  std::vector<unsigned> children;
+};
+
+// Sets mst to a minimum spanning forest of g, with the weights of g or, if
+// !useOriginalWeights, with the negative of the sum of the degrees of the
+// ends of each edge. Ties go to the edge with the smaller ends, so the tree
+// doesn't depend on the order the edges were read in, nor on threadCount,
+// the threads spanningForest gets.
+void setMSTFromGraph(const CsrGraph<FloatType>& g, CsrGraph<FloatType>& mst,
+                     bool useOriginalWeights, unsigned int threadCount = 0);
+
+// A breadth first search of the tree mst from root, a TreeSearch on
+// threadCount threads: the hop count of each vertex from the root, and its
+// parent. The root's parent is -1, and the vertices it doesn't reach are at
+// level 0 with parent 0.
+void setLevelMapFromMST(const CsrGraph<FloatType>& mst,
+                        std::vector<unsigned>& lm,
+                        std::vector<unsigned>& parents,
+                        CsrGraph<FloatType>::vertex_descriptor root,
+                        unsigned int threadCount = 0);
+
+// As for Graph: makes the tree in mst, picks the root, the vertex with the
+// least sum of hop counts to the others in it, unless *rootPtr is given,
+// and sets the level map from it. Returns the root and the level count.
+std::pair<CsrGraph<FloatType>::vertex_descriptor, int> generateLevelsFromGraph(
+    const CsrGraph<FloatType>& g, std::vector<unsigned>& levels,
+    std::vector<unsigned>& parents,
+    CsrGraph<FloatType>::vertex_descriptor* rootPtr, CsrGraph<FloatType>& mst,
+    bool useOriginalWeights, unsigned int threadCount = 0);
+
+// Takes the layout graph g up to level, in which model gets laid out.
+inline void addNextLevelFromMap(CsrGraphView<FloatType>& g,
+                                const CsrGraph<FloatType>& model,
+                                const std::vector<unsigned>& lm,
+                                unsigned int level) {
+  g = CsrGraphView<FloatType>(model, lm, level);
+}
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_CSR_GRAPH_H_
@@ -1,6 +1,8 @@
 #include "graph.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 
 #include "boost/graph/adjacency_list.hpp"
 #include "boost/graph/breadth_first_search.hpp"
@@ -8,13 +10,15 @@
 #include "boost/property_map/property_map.hpp"
 #include "boost/tokenizer.hpp"
 #include "fixed_vec.h"
-#include "mutual_map.h"
+#include "id_table.h"
+#include "spanning_tree.h"
 
 namespace lgl {
 namespace lib {
 
 template <typename Weight>
-Graph<Weight>::Graph() : weight(false) {}
+Graph<Weight>::Graph()
+    : ids(std::make_shared<vertex_index_map>()), weight(false) {}
 
 template <typename Weight>
 Graph<Weight>::Graph(const Graph<Weight>& g) {
@@ -23,7 +27,7 @@ Graph<Weight>::Graph(const Graph<Weight>& g) {
 
 template <typename Weight>
 void Graph<Weight>::vertexIdMap(const vertex_index_map& m) {
-  mutmap = m;
+  ids = std::make_shared<vertex_index_map>(m);
 }
 
 template <typename Weight>
@@ -34,7 +38,7 @@ void Graph<Weight>::boostGraph(const Graph<Weight>::boost_graph& g) {
 template <typename Weight>
 void Graph<Weight>::clear() {
   G.clear();
-  mutmap.clear();
+  ids = std::make_shared<vertex_index_map>();
 }
 
 template <typename Weight>
@@ -53,9 +57,8 @@ void Graph<Weight>::removeEdge(const Graph<Weight>::edge_descriptor& e) {
 
 template <typename Weight>
 void Graph<Weight>::eraseEdge(const Graph<Weight>::edge_descriptor& e) {
+  // The vertices stay, and so do their ids
   removeEdge(e);
-  if (mutmap.doesMapExist(source(e, G))) mutmap.removeMap(source(e, G));
-  if (mutmap.doesMapExist(target(e, G))) mutmap.removeMap(target(e, G));
 }
 
 template <typename Weight>
@@ -71,7 +74,7 @@ typename Graph<Weight>::edges_size_type Graph<Weight>::edgeCount() const {
 template <typename Weight>
 const typename Graph<Weight>::vertex_index_map& Graph<Weight>::vertexIdMap()
     const {
-  return mutmap;
+  return *ids;
 }
 
 template <typename Weight>
@@ -116,7 +119,7 @@ template <typename Weight>
 Graph<Weight>& Graph<Weight>::operator=(const Graph<Weight>& g) {
   G = g.boostGraph();
   weight = g.hasWeights();
-  mutmap = g.vertexIdMap();
+  ids = g.sharedIdMap();
   return *this;
 }
 
@@ -126,7 +129,7 @@ template <typename Graph>
 void remap(Graph& g) {
   const typename Graph::boost_graph& bg = g.boostGraph();
   typename Graph::boost_graph ng;
-  typename Graph::vertex_index_map nids;
+  auto nids = std::make_shared<typename Graph::vertex_index_map>();
   typename Graph::vertex_descriptor v1, v2, v1new, v2new;
   typename Graph::edge_iterator ee1, ee2;
 
@@ -135,21 +138,21 @@ void remap(Graph& g) {
   for (tie(ee1, ee2) = edges(bg); ee1 != ee2; ++ee1) {
     v1 = source(*ee1, bg);
     if (marked[v1] == -1) {
-      nids.createMap(g.idFromIndex(v1), index);
+      nids->add(g.idFromIndex(v1), g.vertexIdMap().idLength(v1));
       v1new = index;
       marked[v1] = index;
       ++index;
     } else {
-      v1new = nids.findLatter(g.idFromIndex(v1));
+      v1new = marked[v1];
     }
     v2 = target(*ee1, bg);
     if (marked[v2] == -1) {
-      nids.createMap(g.idFromIndex(v2), index);
+      nids->add(g.idFromIndex(v2), g.vertexIdMap().idLength(v2));
       v2new = index;
       marked[v2] = index;
       ++index;
     } else {
-      v2new = nids.findLatter(g.idFromIndex(v2));
+      v2new = marked[v2];
     }
     if (!g.hasWeights())
       add_edge(v1new, v2new, ng);
@@ -157,7 +160,7 @@ void remap(Graph& g) {
       add_edge(v1new, v2new, g.getWeight(*ee1), ng);
   }
   g.boostGraph(ng);
-  g.vertexIdMap(nids);
+  g.vertexIdMap(std::move(nids));
 }
 template void remap(Graph<FloatType>& g);
 
@@ -243,20 +246,25 @@ getVertexWMostEdges(Graph<FloatType>&);
 
 template <typename Graph>
 void setMSTFromGraph(Graph& g, Graph& mst) {
-  std::vector<typename Graph::edge_descriptor> new_edges;
+  typename Graph::edge_iterator ei, eend;
   typename Graph::edge_descriptor e;
   typename Graph::boost_graph& mst_graph = mst.boostGraph();
   const typename Graph::boost_graph& old_graph = g.boostGraph();
   typename Graph::weight_map old_weights = g.weights();
-  kruskal_minimum_spanning_tree(old_graph, std::back_inserter(new_edges));
+  std::vector<WeightedEdge> edges;
+  edges.reserve(g.edgeCount());
+  for (tie(ei, eend) = boost::edges(old_graph); ei != eend; ++ei) {
+    const unsigned int s = source(*ei, old_graph), t = target(*ei, old_graph);
+    edges.push_back(
+        WeightedEdge{old_weights[*ei], std::min(s, t), std::max(s, t)});
+  }
   bool inserted;
-  for (unsigned int ii = 0; ii < new_edges.size(); ++ii) {
-    tie(e, inserted) = add_edge(source(new_edges[ii], old_graph),
-                                target(new_edges[ii], old_graph), mst_graph);
-    get(boost::edge_weight, mst_graph)[e] = old_weights[new_edges[ii]];
+  for (const WeightedEdge& te : spanningForest(g.vertexCount(), edges)) {
+    tie(e, inserted) = add_edge(te.u, te.v, mst_graph);
+    get(boost::edge_weight, mst_graph)[e] = te.w;
   }
   mst.hasWeights(true);
-  mst.vertexIdMap(g.vertexIdMap());
+  mst.vertexIdMap(g.sharedIdMap());
 }
 template void setMSTFromGraph(Graph<FloatType>&, Graph<FloatType>&);
 
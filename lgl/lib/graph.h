@@ -5,6 +5,8 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -17,7 +19,7 @@
 #include "boost/property_map/property_map.hpp"
 #include "boost/tokenizer.hpp"
 #include "fixed_vec.h"
-#include "mutual_map.h"
+#include "id_table.h"
 
 namespace lgl {
 namespace lib {
@@ -33,7 +35,7 @@ template <typename Weight>
 class Graph {
  public:
   typedef typename std::pair<unsigned int, unsigned int> Edge;
-  typedef MutualMap<std::string, int> vertex_index_map;
+  typedef IdTable vertex_index_map;
   typedef typename boost::adjacency_list<
       boost::setS, boost::vecS, boost::undirectedS,
       boost::property<boost::vertex_name_t, int>,
@@ -52,7 +54,8 @@ class Graph {
 
  private:
   boost_graph G;
-  vertex_index_map mutmap;
+  // Shared by the graphs made from this one, as they don't change it
+  std::shared_ptr<const vertex_index_map> ids;
   bool weight;
 
  public:
@@ -63,6 +66,10 @@ class Graph {
   // MUTATORS
   void vertexIdMap(const vertex_index_map& m);
 
+  void vertexIdMap(std::shared_ptr<const vertex_index_map> m) {
+    ids = std::move(m);
+  }
+
   void boostGraph(const boost_graph& g);
 
   boost_graph& boostGraph() { return G; }
@@ -82,6 +89,9 @@ class Graph {
 
   const vertex_index_map& vertexIdMap() const;
 
+  // To give another graph the same ids without copying them
+  std::shared_ptr<const vertex_index_map> sharedIdMap() const { return ids; }
+
   const boost_graph& boostGraph() const { return G; }
 
   weight_map weights() { return get(boost::edge_weight, G); }
@@ -94,8 +104,17 @@ class Graph {
 
   void hasWeights(bool b) { weight = b; }
 
-  std::string idFromIndex(int i) const { return mutmap.findFormer(i); }
-  int indexFromId(std::string& s) const { return mutmap.findLatter(s); }
+  const char* idFromIndex(int i) const {
+    if (i < 0 || i >= ids->size()) {
+      throw std::invalid_argument("idFromIndex: no such vertex");
+    }
+    return ids->id(i);
+  }
+  int indexFromId(const std::string& s) const {
+    const int i = ids->find(s);
+    if (i < 0) throw std::invalid_argument("indexFromId: no vertex " + s);
+    return i;
+  }
 
   bool doesEdgeExist(vertex_descriptor u, vertex_descriptor v) const;
 
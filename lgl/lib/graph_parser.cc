@@ -0,0 +1,348 @@
+#include "graph_parser.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "thread_pool.h"
+
+namespace lgl {
+namespace lib {
+
+namespace {
+
+// A few chunks per thread, so one with long lines doesn't hold up the rest
+const unsigned int kChunksPerThread = 4;
+
+// A file mapped into memory for reading
+class MappedFile {
+ public:
+  explicit MappedFile(const char* file) {
+    const int fd = ::open(file, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      if (fd >= 0) ::close(fd);
+      throw std::runtime_error(std::string("Open of ") + file + " failed");
+    }
+    size_ = st.st_size;
+    if (size_ > 0) {
+      map_ = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+      map_ = 0;
+      throw std::runtime_error(std::string("mmap of ") + file + " failed");
+    }
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+    if (map_ != 0) munmap(map_, size_);
+  }
+
+  const char* begin() const { return static_cast<const char*>(map_); }
+  const char* end() const { return begin() + size_; }
+
+ private:
+  void* map_ = 0;
+  std::size_t size_ = 0;
+};
+
+// An id in the mapped file
+struct Token {
+  const char* p;
+  std::size_t n;
+  std::uint64_t hash;
+};
+
+struct TokenHash {
+  std::size_t operator()(const Token& t) const { return t.hash; }
+};
+
+struct TokenEqual {
+  bool operator()(const Token& a, const Token& b) const {
+    return a.n == b.n && std::memcmp(a.p, b.p, a.n) == 0;
+  }
+};
+
+// FNV-1a
+std::uint64_t hashBytes(const char* p, std::size_t n) {
+  std::uint64_t h = 14695981039346656037ull;
+  for (std::size_t ii = 0; ii < n; ++ii) {
+    h = (h ^ static_cast<unsigned char>(p[ii])) * 1099511628211ull;
+  }
+  return h;
+}
+
+// Where an id first turned up: twice the offset of the line, plus one for
+// the second id of the line
+struct Entry {
+  std::uint64_t first;
+  unsigned int index;
+};
+
+// The ids of the file, shared by the threads. Split into shards with a lock
+// each, so the threads seldom wait for each other.
+class ShardedIdTable {
+ public:
+  Entry* intern(const char* p, std::size_t n, std::uint64_t order) {
+    const Token t = {p, n, hashBytes(p, n)};
+    Shard& s = shards_[t.hash >> (64 - kShardBits)];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto found = s.ids.insert(std::make_pair(t, Entry{order, 0}));
+    Entry& e = found.first->second;
+    e.first = std::min(e.first, order);
+    return &e;
+  }
+
+  // Numbers the ids in the order they first turned up.
+  void number(std::vector<std::string>& ids) {
+    std::vector<std::pair<std::uint64_t, Entry*>> order;
+    for (Shard& s : shards_) {
+      for (auto& id : s.ids) {
+        order.push_back(std::make_pair(id.second.first, &id.second));
+      }
+    }
+    std::sort(order.begin(), order.end());
+    for (unsigned int ii = 0; ii < order.size(); ++ii) {
+      order[ii].second->index = ii;
+    }
+    ids.resize(order.size());
+    for (Shard& s : shards_) {
+      for (auto& id : s.ids) {
+        ids[id.second.index].assign(id.first.p, id.first.n);
+      }
+    }
+  }
+
+ private:
+  static const unsigned int kShardBits = 6;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Token, Entry, TokenHash, TokenEqual> ids;
+  };
+
+  Shard shards_[1 << kShardBits];
+};
+
+// The edges of a chunk, in its order
+struct Chunk {
+  struct Arc {
+    Entry* u;
+    Entry* v;
+    float w;
+  };
+
+  const char* begin;
+  const char* end;
+  std::vector<Arc> arcs;
+  bool weighted = false;
+};
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// The start of the line after the one p is in, or end
+const char* nextLine(const char* p, const char* end) {
+  const char* nl =
+      static_cast<const char*>(std::memchr(p, '\n', end - p));
+  return nl == 0 ? end : nl + 1;
+}
+
+// Splits a line into up to max tokens, returning how many there are
+unsigned int tokenize(const char* p, const char* end, Token* tokens,
+                      unsigned int max) {
+  unsigned int count = 0;
+  while (true) {
+    while (p != end && isSpace(*p)) ++p;
+    if (p == end) return count;
+    const char* q = p;
+    while (q != end && !isSpace(*q)) ++q;
+    if (count == max) return count + 1;
+    tokens[count].p = p;
+    tokens[count].n = q - p;
+    ++count;
+    p = q;
+  }
+}
+
+float parseWeight(const Token& t) {
+  // The token isn't terminated, and may end the file
+  char buf[64];
+  const std::size_t n = std::min(t.n, sizeof(buf) - 1);
+  std::memcpy(buf, t.p, n);
+  buf[n] = 0;
+  return std::strtof(buf, 0);
+}
+
+// Cuts the file into chunks that start at a line for which isStart holds
+template <typename IsStart>
+std::vector<Chunk> cutChunks(const MappedFile& f, unsigned int count,
+                             IsStart isStart) {
+  std::vector<Chunk> chunks;
+  const char* begin = f.begin();
+  const std::size_t size = f.end() - begin;
+  for (unsigned int ii = 0; ii < count && begin != f.end(); ++ii) {
+    const char* end = f.end();
+    if (ii + 1 < count) {
+      end = std::max(begin, f.begin() + size * (ii + 1) / count);
+      if (end != f.begin()) end = nextLine(end - 1, f.end());
+      while (end != f.end() && !isStart(end, f.end())) {
+        end = nextLine(end, f.end());
+      }
+    }
+    Chunk c;
+    c.begin = begin;
+    c.end = end;
+    chunks.push_back(std::move(c));
+    begin = end;
+  }
+  return chunks;
+}
+
+bool isHeader(const char* p, const char* end) {
+  return end - p >= 2 && p[0] == '#' && p[1] == ' ';
+}
+
+void parseLGLChunk(const char* file, const char* base, Chunk& c,
+                   ShardedIdTable& table, float lower, float upper) {
+  Token head = {0, 0, 0};
+  // Interned once one of its edges is kept
+  Entry* headEntry = 0;
+  Token t[3];
+  for (const char* line = c.begin; line != c.end;) {
+    const char* next = nextLine(line, c.end);
+    const unsigned int n = tokenize(line, next, t, 2);
+    const std::uint64_t order = 2 * static_cast<std::uint64_t>(line - base);
+    line = next;
+    if (n == 0) continue;
+    if (t[0].n == 1 && t[0].p[0] == '#') {
+      if (n < 2) {
+        throw std::runtime_error(std::string(file) + ": # without an id");
+      }
+      head = t[1];
+      headEntry = 0;
+      continue;
+    }
+    if (head.p == 0) {
+      throw std::runtime_error(std::string(file) +
+                               ": a neighbour before the first # line");
+    }
+    float w = 0;
+    if (n > 1) {
+      w = parseWeight(t[1]);
+      c.weighted = true;
+      if (w <= lower || w > upper) continue;
+    }
+    if (headEntry == 0) headEntry = table.intern(head.p, head.n, order);
+    Entry* v = table.intern(t[0].p, t[0].n, order + 1);
+    c.arcs.push_back(Chunk::Arc{headEntry, v, w});
+  }
+}
+
+void parseNCOLChunk(const char* file, const char* base, Chunk& c,
+                    ShardedIdTable& table) {
+  Token t[3];
+  for (const char* line = c.begin; line != c.end;) {
+    const char* next = nextLine(line, c.end);
+    const unsigned int n = tokenize(line, next, t, 3);
+    const std::uint64_t order = 2 * static_cast<std::uint64_t>(line - base);
+    line = next;
+    if (n == 0) continue;
+    if (n == 1) {
+      throw std::runtime_error(std::string(file) + ": an edge with one id");
+    }
+    float w = 0;
+    if (n > 2) {
+      w = parseWeight(t[2]);
+      c.weighted = true;
+    }
+    Entry* u = table.intern(t[0].p, t[0].n, order);
+    Entry* v = table.intern(t[1].p, t[1].n, order + 1);
+    c.arcs.push_back(Chunk::Arc{u, v, w});
+  }
+}
+
+// Runs parse on every chunk and puts the results together
+template <typename Parse>
+void parseChunks(std::vector<Chunk>& chunks, unsigned int threadCount,
+                 ShardedIdTable& table, Parse parse, ParsedGraph& g) {
+  {
+    thread_pool pool(std::max(1u, std::min<unsigned int>(threadCount,
+                                                          chunks.size())));
+    std::vector<std::future<void>> futures;
+    for (Chunk& c : chunks) {
+      futures.push_back(pool.run(parse, std::ref(c)));
+    }
+    // Rethrows what the parsing threw
+    for (auto& f : futures) f.get();
+  }
+
+  table.number(g.ids);
+  std::size_t count = 0;
+  bool weighted = false;
+  for (const Chunk& c : chunks) {
+    count += c.arcs.size();
+    weighted = weighted || c.weighted;
+  }
+  g.edges.clear();
+  g.edges.reserve(count);
+  g.weights.clear();
+  if (weighted) g.weights.reserve(count);
+  for (Chunk& c : chunks) {
+    for (const Chunk::Arc& a : c.arcs) {
+      g.edges.push_back(ParsedGraph::Edge(a.u->index, a.v->index));
+      if (weighted) g.weights.push_back(a.w);
+    }
+    std::vector<Chunk::Arc>().swap(c.arcs);
+  }
+}
+
+unsigned int threadsFor(unsigned int threadCount) {
+  if (threadCount > 0) return threadCount;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+}  // namespace
+
+void parseLGL(const char* file, ParsedGraph& g, float lower, float upper,
+              unsigned int threadCount) {
+  threadCount = threadsFor(threadCount);
+  MappedFile f(file);
+  std::vector<Chunk> chunks =
+      cutChunks(f, threadCount * kChunksPerThread, isHeader);
+  ShardedIdTable table;
+  parseChunks(chunks, threadCount, table,
+              [&](Chunk& c) {
+                parseLGLChunk(file, f.begin(), c, table, lower, upper);
+              },
+              g);
+}
+
+void parseNCOL(const char* file, ParsedGraph& g, unsigned int threadCount) {
+  threadCount = threadsFor(threadCount);
+  MappedFile f(file);
+  std::vector<Chunk> chunks =
+      cutChunks(f, threadCount * kChunksPerThread,
+                [](const char*, const char*) { return true; });
+  ShardedIdTable table;
+  parseChunks(chunks, threadCount, table,
+              [&](Chunk& c) { parseNCOLChunk(file, f.begin(), c, table); },
+              g);
+}
+
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,49 @@
+#ifndef LGL_LIB_GRAPH_PARSER_H_
+#define LGL_LIB_GRAPH_PARSER_H_
+
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lgl {
+namespace lib {
+
+// The edges of a graph file, as parsed by parseLGL or parseNCOL.
+struct ParsedGraph {
+  typedef std::pair<unsigned int, unsigned int> Edge;
+
+  // The vertex ids, numbered in the order they first turn up in the file
+  std::vector<std::string> ids;
+  // In the order of the file, duplicates and all
+  std::vector<Edge> edges;
+  // The weight of each edge, or empty if the file has none. An edge without
+  // a weight in a file that has them weighs 0.
+  std::vector<float> weights;
+};
+
+// Parses a graph file on threadCount threads, all the cores for 0. The file
+// is mapped into memory and cut into chunks at line boundaries, or at the
+// "# " lines that start the neighbours of a vertex for LGL. The chunks are
+// tokenized in parallel, interning the ids into a table shared by the
+// threads, and put together in the order of the file, so the result is the
+// same whatever the thread count. Throws std::runtime_error if the file
+// can't be read or is malformed.
+
+// An LGL file: a "# id" line, followed by a line per neighbour with its id
+// and optionally the weight of the edge. Weighted edges are kept if their
+// weight is in (lower, upper]; the vertices of those that aren't are left
+// out unless some other edge keeps them.
+void parseLGL(const char* file, ParsedGraph& g,
+              float lower = -std::numeric_limits<float>::infinity(),
+              float upper = std::numeric_limits<float>::infinity(),
+              unsigned int threadCount = 0);
+
+// An NCOL file: a line per edge with the ids of its vertices and
+// optionally its weight.
+void parseNCOL(const char* file, ParsedGraph& g, unsigned int threadCount = 0);
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_GRAPH_PARSER_H_
@@ -0,0 +1,230 @@
+#include "lgl/lib/graph_parser.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lgl {
+namespace lib {
+namespace {
+
+const unsigned int kThreadCounts[] = {1, 2, 3, 7, 16, 64};
+
+std::string TempFile(const std::string& name) {
+  return ::testing::TempDir() + "/" + name;
+}
+
+void WriteFile(const std::string& file, const std::string& text) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out << text;
+}
+
+// Builds what the parser should make of a file along with its text
+class ExpectedGraph {
+ public:
+  void addEdge(const std::string& u, const std::string& v, float w) {
+    const unsigned int iu = index(u);
+    graph.edges.push_back(ParsedGraph::Edge(iu, index(v)));
+    weights.push_back(w);
+  }
+
+  ParsedGraph graph;
+  // Kept even if the file turns out to have no weights
+  std::vector<float> weights;
+
+ private:
+  unsigned int index(const std::string& id) {
+    auto found = indices.insert(std::make_pair(id, graph.ids.size()));
+    if (found.second) graph.ids.push_back(id);
+    return found.first->second;
+  }
+
+  std::map<std::string, unsigned int> indices;
+};
+
+// Ids of all sorts of lengths, so the lines are too
+std::string RandomId(std::mt19937& rng) {
+  const unsigned int n = rng() % 400;
+  std::string id = "v" + std::to_string(n);
+  if (n % 7 == 0) id += std::string(rng() % 60, 'x');
+  return id;
+}
+
+std::string RandomSpace(std::mt19937& rng) {
+  const char* spaces[] = {" ", "  ", "\t", " \t "};
+  return spaces[rng() % 4];
+}
+
+// Ends lines with \n or \r\n, with blank lines here and there
+std::string RandomNewline(std::mt19937& rng) {
+  std::string nl = rng() % 3 == 0 ? "\r\n" : "\n";
+  if (rng() % 20 == 0) nl += rng() % 2 ? "\n" : "\r\n";
+  return nl;
+}
+
+// A weight as the file writes it, and as strtof reads it back
+float RandomWeight(std::mt19937& rng, std::string& text) {
+  text = std::to_string(static_cast<int>(rng() % 2000) - 1000) + "." +
+         std::to_string(rng() % 100);
+  return std::strtof(text.c_str(), 0);
+}
+
+// An LGL file of the given number of vertex blocks, some of them long
+// enough to span many chunks, some empty. Edges weighing outside
+// (lower, upper] aren't expected, nor heads with none of their edges kept.
+std::string RandomLGL(std::mt19937& rng, unsigned int blocks, bool weighted,
+                      float lower, float upper, ExpectedGraph& expected) {
+  std::string text;
+  for (unsigned int b = 0; b < blocks; ++b) {
+    const std::string head = RandomId(rng);
+    text += "# " + head + RandomNewline(rng);
+    const unsigned int count = rng() % 10 == 0 ? 300 : rng() % 6;
+    for (unsigned int ii = 0; ii < count; ++ii) {
+      const std::string v = RandomId(rng);
+      text += RandomSpace(rng).substr(1) + v;
+      float w = 0;
+      // Even a weighted file may leave a weight out, which keeps the edge
+      if (weighted && rng() % 10 != 0) {
+        std::string wText;
+        w = RandomWeight(rng, wText);
+        text += RandomSpace(rng) + wText + RandomNewline(rng);
+        if (w <= lower || w > upper) continue;
+      } else {
+        text += RandomNewline(rng);
+      }
+      expected.addEdge(head, v, w);
+    }
+  }
+  return text;
+}
+
+std::string RandomNCOL(std::mt19937& rng, unsigned int lines, bool weighted,
+                       ExpectedGraph& expected) {
+  std::string text;
+  for (unsigned int ii = 0; ii < lines; ++ii) {
+    const std::string u = RandomId(rng), v = RandomId(rng);
+    text += u + RandomSpace(rng) + v;
+    float w = 0;
+    if (weighted && rng() % 10 != 0) {
+      std::string wText;
+      w = RandomWeight(rng, wText);
+      text += RandomSpace(rng) + wText;
+    }
+    text += RandomNewline(rng);
+    expected.addEdge(u, v, w);
+  }
+  return text;
+}
+
+void ExpectParsed(const ExpectedGraph& expected, bool weighted,
+                  const ParsedGraph& g) {
+  EXPECT_EQ(expected.graph.ids, g.ids);
+  EXPECT_EQ(expected.graph.edges, g.edges);
+  if (weighted) {
+    EXPECT_EQ(expected.weights, g.weights);
+  } else {
+    EXPECT_TRUE(g.weights.empty());
+  }
+}
+
+TEST(GraphParserTest, LGLIsTheSameOnEveryThreadCount) {
+  for (bool weighted : {false, true}) {
+    std::mt19937 rng(weighted);
+    ExpectedGraph expected;
+    const float inf = std::numeric_limits<float>::infinity();
+    const std::string file = TempFile("parse.lgl");
+    WriteFile(file, RandomLGL(rng, 2000, weighted, -inf, inf, expected));
+    for (unsigned int threads : kThreadCounts) {
+      SCOPED_TRACE(threads);
+      ParsedGraph g;
+      parseLGL(file.c_str(), g, -inf, inf, threads);
+      ExpectParsed(expected, weighted, g);
+    }
+  }
+}
+
+TEST(GraphParserTest, LGLKeepsTheSameWeightsOnEveryThreadCount) {
+  std::mt19937 rng(2);
+  ExpectedGraph expected;
+  const std::string file = TempFile("parse_filtered.lgl");
+  WriteFile(file, RandomLGL(rng, 2000, true, -200, 500, expected));
+  for (unsigned int threads : kThreadCounts) {
+    SCOPED_TRACE(threads);
+    ParsedGraph g;
+    parseLGL(file.c_str(), g, -200, 500, threads);
+    ExpectParsed(expected, true, g);
+  }
+}
+
+TEST(GraphParserTest, NCOLIsTheSameOnEveryThreadCount) {
+  for (bool weighted : {false, true}) {
+    std::mt19937 rng(3 + weighted);
+    ExpectedGraph expected;
+    const std::string file = TempFile("parse.ncol");
+    WriteFile(file, RandomNCOL(rng, 5000, weighted, expected));
+    for (unsigned int threads : kThreadCounts) {
+      SCOPED_TRACE(threads);
+      ParsedGraph g;
+      parseNCOL(file.c_str(), g, threads);
+      ExpectParsed(expected, weighted, g);
+    }
+  }
+}
+
+TEST(GraphParserTest, ReadsCRLFAndALastLineWithoutNewline) {
+  const std::string lgl = TempFile("crlf.lgl");
+  WriteFile(lgl, "# a\r\nb 1.5\r\n\r\n# c\r\na");
+  const std::string ncol = TempFile("crlf.ncol");
+  WriteFile(ncol, "a b\r\nc a 2\r\n\r\nb c");
+  for (unsigned int threads : kThreadCounts) {
+    SCOPED_TRACE(threads);
+    ParsedGraph g;
+    parseLGL(lgl.c_str(), g, -std::numeric_limits<float>::infinity(),
+             std::numeric_limits<float>::infinity(), threads);
+    EXPECT_EQ(g.ids, std::vector<std::string>({"a", "b", "c"}));
+    EXPECT_EQ(g.edges, std::vector<ParsedGraph::Edge>({{0, 1}, {2, 0}}));
+    EXPECT_EQ(g.weights, std::vector<float>({1.5, 0}));
+
+    parseNCOL(ncol.c_str(), g, threads);
+    EXPECT_EQ(g.ids, std::vector<std::string>({"a", "b", "c"}));
+    EXPECT_EQ(g.edges,
+              std::vector<ParsedGraph::Edge>({{0, 1}, {2, 0}, {1, 2}}));
+    EXPECT_EQ(g.weights, std::vector<float>({0, 2, 0}));
+  }
+}
+
+TEST(GraphParserTest, LGLRejectsANeighbourBeforeTheFirstHeader) {
+  // Long enough that the other threads get chunks of their own
+  std::mt19937 rng(5);
+  ExpectedGraph unused;
+  const float inf = std::numeric_limits<float>::infinity();
+  const std::string file = TempFile("no_header.lgl");
+  WriteFile(file, "b\n" + RandomLGL(rng, 500, false, -inf, inf, unused));
+  for (unsigned int threads : kThreadCounts) {
+    SCOPED_TRACE(threads);
+    ParsedGraph g;
+    EXPECT_THROW(parseLGL(file.c_str(), g, -inf, inf, threads),
+                 std::runtime_error);
+  }
+}
+
+TEST(GraphParserTest, NCOLRejectsAnEdgeWithOneId) {
+  const std::string file = TempFile("one_id.ncol");
+  WriteFile(file, "a b\nc\n");
+  for (unsigned int threads : kThreadCounts) {
+    SCOPED_TRACE(threads);
+    ParsedGraph g;
+    EXPECT_THROW(parseNCOL(file.c_str(), g, threads), std::runtime_error);
+  }
+}
+
+}  // namespace
+}  // namespace lib
+}  // namespace lgl
@@ -1,11 +1,13 @@
 #include "grid.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 
 #include "fixed_vec.h"
-#include "particle.h"
+#include "particle_container.h"
 #include "types.h"
 #include "voxel.h"
 
@@ -28,6 +30,59 @@ const unsigned int iterMax2D = 5;
 const unsigned int iterMax3D = 14;
 }  // namespace NbhrVoxelPositions
 
+namespace {
+
+// Morton codes interleave the bits of the coordinates, 31 bits of each in 2D
+// and 21 in 3D, so the codes stay positive longs.
+const unsigned int kMortonBits[4] = {0, 62, 31, 21};
+
+std::uint64_t spreadBits2(std::uint64_t x) {
+  x &= 0xffffffffull;
+  x = (x | x << 16) & 0x0000ffff0000ffffull;
+  x = (x | x << 8) & 0x00ff00ff00ff00ffull;
+  x = (x | x << 4) & 0x0f0f0f0f0f0f0f0full;
+  x = (x | x << 2) & 0x3333333333333333ull;
+  x = (x | x << 1) & 0x5555555555555555ull;
+  return x;
+}
+
+std::uint64_t compactBits2(std::uint64_t x) {
+  x &= 0x5555555555555555ull;
+  x = (x | x >> 1) & 0x3333333333333333ull;
+  x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0full;
+  x = (x | x >> 4) & 0x00ff00ff00ff00ffull;
+  x = (x | x >> 8) & 0x0000ffff0000ffffull;
+  x = (x | x >> 16) & 0xffffffffull;
+  return x;
+}
+
+std::uint64_t spreadBits3(std::uint64_t x) {
+  x &= 0x1fffffull;
+  x = (x | x << 32) & 0x1f00000000ffffull;
+  x = (x | x << 16) & 0x1f0000ff0000ffull;
+  x = (x | x << 8) & 0x100f00f00f00f00full;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+
+std::uint64_t compactBits3(std::uint64_t x) {
+  x &= 0x1249249249249249ull;
+  x = (x | x >> 2) & 0x10c30c30c30c30c3ull;
+  x = (x | x >> 4) & 0x100f00f00f00f00full;
+  x = (x | x >> 8) & 0x1f0000ff0000ffull;
+  x = (x | x >> 16) & 0x1f00000000ffffull;
+  x = (x | x >> 32) & 0x1fffffull;
+  return x;
+}
+
+std::size_t slotOf(long code, std::size_t mask) {
+  return (static_cast<std::uint64_t>(code) * 0x9e3779b97f4a7c15ull >> 24) &
+         mask;
+}
+
+}  // namespace
+
 template <typename Occupant>
 void Grid<Occupant>::initVoxels() {
   vec_type xyz;
@@ -67,8 +122,40 @@ void Grid<Occupant>::initVoxels() {
 
 template <typename Occupant>
 void Grid<Occupant>::allocate() {
+  cellList_.clear();
+  occupied_.clear();
+  colorCells_.assign(voxelColorCount<n_dimensions_>(),
+                     std::vector<size_type>());
+  if (sparse_) {
+    std::vector<std::atomic<size_type>>().swap(cellCursor_);
+    std::vector<std::atomic<std::uint64_t>>().swap(occupiedBits_);
+    cells_.clear();
+    return;
+  }
   voxels_ = new voxel_type[voxelCount];
   assert(voxels_);
+  // Atomics can't be moved, so the cursors are rebuilt from scratch.
+  std::vector<std::atomic<size_type>>(voxelCount).swap(cellCursor_);
+  for (size_type ii = 0; ii < voxelCount; ++ii) cellCursor_[ii] = 0;
+  std::vector<std::atomic<std::uint64_t>>((voxelCount + 63) / 64)
+      .swap(occupiedBits_);
+  for (std::atomic<std::uint64_t>& bits : occupiedBits_) bits = 0;
+  Grid_::orderVoxels();
+}
+
+template <typename Occupant>
+void Grid<Occupant>::orderVoxels() {
+  std::vector<std::pair<long, size_type>> keyed(voxelCount);
+  for (size_type ii = 0; ii < voxelCount; ++ii) {
+    keyed[ii] = std::make_pair(mortonCode(coordsOf(ii)), ii);
+  }
+  std::sort(keyed.begin(), keyed.end());
+  zOrderVoxels_.resize(voxelCount);
+  zRanks_.resize(voxelCount);
+  for (size_type ii = 0; ii < voxelCount; ++ii) {
+    zOrderVoxels_[ii] = keyed[ii].second;
+    zRanks_[keyed[ii].second] = ii;
+  }
 }
 
 template <typename Occupant>
@@ -80,7 +167,17 @@ void Grid<Occupant>::initGrid() {
     voxPerEdge[ii] = (unsigned int)ceil((maxs[ii] - ctr) / voxelLength);
     maxs[ii] = mins[ii] + voxPerEdge[ii] * voxelLength;
   }
-  voxelCount = voxPerEdge.product();
+  if (sparse_) {
+    for (size_type ii = 0; ii < n_dimensions_; ++ii) {
+      if (voxPerEdge[ii] >= (1l << kMortonBits[n_dimensions_])) {
+        std::cerr << "The sparse grid can't have more than 2^"
+                  << kMortonBits[n_dimensions_] << " voxels per edge\n";
+        std::exit(EXIT_FAILURE);
+      }
+    }
+  }
+  // Only the dense grid allocates them all
+  voxelCount = sparse_ ? 0 : voxPerEdge.product();
   // This determines the number of voxels enclosed
   // in each dimension.
   size_type count = 1;
@@ -90,7 +187,7 @@ void Grid<Occupant>::initGrid() {
     voxPerDim[ii] = count;
   }
   Grid_::allocate();
-  Grid_::initVoxels();
+  if (!sparse_) Grid_::initVoxels();
 }
 
 template <typename Occupant>
@@ -111,6 +208,93 @@ typename Grid<Occupant>::voxel_type* Grid<Occupant>::getVoxelFromPosition(
   }
 }
 
+template <typename Occupant>
+long Grid<Occupant>::cellOf(const vec_type& x) const {
+  if (!checkInclusion(x)) return -1;
+  if (!sparse_) {
+    voxel_type* v = Grid_::getVoxelFromPosition(x);
+    return v ? v->index() : -1;
+  }
+  return zOrder(x);
+}
+
+template <typename Occupant>
+long Grid<Occupant>::zOrder(const vec_type& x) const {
+  Vec_l coord;
+  for (size_type d = 0; d < n_dimensions_; ++d) {
+    coord[d] = std::min(static_cast<long>((x[d] - mins[d]) / voxelLength),
+                        voxPerEdge[d] - 1);
+  }
+  return mortonCode(coord);
+}
+
+template <typename Occupant>
+long Grid<Occupant>::mortonCode(const Vec_l& c) {
+  if (n_dimensions_ == 2) return spreadBits2(c[0]) | spreadBits2(c[1]) << 1;
+  std::uint64_t code = 0;
+  for (size_type d = 0; d < n_dimensions_; ++d) code |= spreadBits3(c[d]) << d;
+  return code;
+}
+
+template <typename Occupant>
+typename Grid<Occupant>::Vec_l Grid<Occupant>::mortonCoords(long code) {
+  Vec_l c;
+  for (size_type d = 0; d < n_dimensions_; ++d) {
+    c[d] = n_dimensions_ == 2 ? compactBits2(code >> d) : compactBits3(code >> d);
+  }
+  return c;
+}
+
+template <typename Occupant>
+typename Grid<Occupant>::Vec_l Grid<Occupant>::coordsOf(size_type entry) const {
+  Vec_l c;
+  for (size_type d = n_dimensions_; d-- > 0;) {
+    c[d] = entry / voxPerDim[d];
+    entry %= voxPerDim[d];
+  }
+  return c;
+}
+
+template <typename Occupant>
+long Grid<Occupant>::findCell(long code) const {
+  const std::size_t mask = slotKeys_.size() - 1;
+  for (std::size_t slot = slotOf(code, mask);; slot = (slot + 1) & mask) {
+    if (slotKeys_[slot] == code) return slotCells_[slot];
+    if (slotKeys_[slot] < 0) return -1;
+  }
+}
+
+template <typename Occupant>
+int Grid<Occupant>::occupiedNeighbours(size_type c, voxel_type** nbhrs) {
+  const unsigned int iterMax = n_dimensions_ == 2
+                                   ? NbhrVoxelPositions::iterMax2D
+                                   : NbhrVoxelPositions::iterMax3D;
+  const Vec_l coord = sparse_ ? mortonCoords(cellKeys_[c]) : coordsOf(c);
+  int count = 0;
+  nbhrs[count++] = &cell(c);
+  for (unsigned int k = 1; k < iterMax; ++k) {
+    Vec_l nbhr;
+    bool inside = true;
+    for (size_type d = 0; d < n_dimensions_; ++d) {
+      nbhr[d] = coord[d] + NbhrVoxelPositions::off_[d][k];
+      inside = inside && nbhr[d] >= 0 && nbhr[d] < voxPerEdge[d];
+    }
+    if (!inside) continue;
+    if (!sparse_) {
+      long entry = 0;
+      for (size_type d = 0; d < n_dimensions_; ++d) {
+        entry += nbhr[d] * voxPerDim[d];
+      }
+      voxel_type& v = voxels_[entry];
+      if (!v.empty()) nbhrs[count++] = &v;
+      continue;
+    }
+    const long found = findCell(mortonCode(nbhr));
+    if (found >= 0) nbhrs[count++] = &cells_[found];
+  }
+  return count;
+}
+
 template <typename Occupant>
 void Grid<Occupant>::print(std::ostream& o) const {
   o << "voxelLength: " << voxelLength << '\t' << "voxelCount: " << voxelCount
@@ -129,8 +313,180 @@ void Grid<Occupant>::print(std::ostream& o) const {
   }
 }
 
-template class Grid<Particle<k2Dimensions>>;
-template class Grid<Particle<k3Dimensions>>;
+template <typename Occupant>
+void Grid<Occupant>::countOccupants(const Occupant& pc, long whichThread,
+                                    long threadCount) {
+  if (sparse_) {
+    std::vector<keyed_index>& run = runs_[whichThread];
+    run.clear();
+    for (index_type k = whichThread; k < activeCount(pc); k += threadCount) {
+      const index_type ii = activeParticle(k);
+      const long c = pc.container(ii);
+      if (c >= 0) run.push_back(keyed_index(c, ii));
+    }
+    std::sort(run.begin(), run.end());
+    return;
+  }
+  for (index_type k = whichThread; k < activeCount(pc); k += threadCount) {
+    const index_type ii = activeParticle(k);
+    const long c = pc.container(ii);
+    // The first occupant marks the voxel
+    if (c >= 0 && cellCursor_[c].fetch_add(1, std::memory_order_relaxed) == 0) {
+      const size_type rank = zRanks_[c];
+      occupiedBits_[rank / 64].fetch_or(std::uint64_t(1) << rank % 64,
+                                        std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename Occupant>
+void Grid<Occupant>::allocateOccupants() {
+  if (sparse_) return Grid_::allocateSparseOccupants();
+  // The voxels that were occupied last time may not be any more
+  for (size_type c : occupied_) voxels_[c].occupants(0, 0);
+  occupied_.clear();
+  size_type total = 0;
+  for (std::size_t word = 0; word < occupiedBits_.size(); ++word) {
+    std::uint64_t bits = occupiedBits_[word].load(std::memory_order_relaxed);
+    if (bits == 0) continue;
+    occupiedBits_[word].store(0, std::memory_order_relaxed);
+    for (; bits != 0; bits &= bits - 1) {
+      const size_type c = zOrderVoxels_[word * 64 + __builtin_ctzll(bits)];
+      occupied_.push_back(c);
+      total += cellCursor_[c].load(std::memory_order_relaxed);
+    }
+  }
+
+  cellList_.resize(total);
+  const index_type* const list = cellList_.data();
+  for (std::vector<size_type>& colorList : colorCells_) colorList.clear();
+  size_type start = 0;
+  for (size_type c : occupied_) {
+    const size_type count = cellCursor_[c].load(std::memory_order_relaxed);
+    voxels_[c].occupants(list + start, list + start + count);
+    cellCursor_[c].store(start, std::memory_order_relaxed);
+    start += count;
+    colorCells_[voxelColor<n_dimensions_>(coordsOf(c))].push_back(c);
+  }
+}
+
+template <typename Occupant>
+void Grid<Occupant>::allocateSparseOccupants() {
+  // Merge the runs of the threads, pairwise until one is left
+  merged_.clear();
+  std::vector<std::size_t> bounds(1, 0);
+  for (const std::vector<keyed_index>& run : runs_) {
+    merged_.insert(merged_.end(), run.begin(), run.end());
+    bounds.push_back(merged_.size());
+  }
+  while (bounds.size() > 2) {
+    std::vector<std::size_t> next(1, 0);
+    std::size_t ii = 0;
+    for (; ii + 2 < bounds.size(); ii += 2) {
+      std::inplace_merge(merged_.begin() + bounds[ii],
+                         merged_.begin() + bounds[ii + 1],
+                         merged_.begin() + bounds[ii + 2]);
+      next.push_back(bounds[ii + 2]);
+    }
+    if (ii + 1 < bounds.size()) next.push_back(bounds.back());
+    bounds.swap(next);
+  }
+
+  // One voxel per distinct code
+  cellList_.resize(merged_.size());
+  const index_type* const list = cellList_.data();
+  const precision vr = voxelLength * .5;
+  cells_.clear();
+  cellKeys_.clear();
+  for (std::size_t first = 0, last; first < merged_.size(); first = last) {
+    const long code = merged_[first].first;
+    for (last = first; last < merged_.size() && merged_[last].first == code;
+         ++last) {
+      cellList_[last] = merged_[last].second;
+    }
+    const Vec_l coord = mortonCoords(code);
+    vec_type origin;
+    for (size_type d = 0; d < n_dimensions_; ++d) {
+      origin[d] = mins[d] + vr + coord[d] * voxelLength;
+    }
+    voxel_type v;
+    v.index(cells_.size());
+    v.origin(origin);
+    v.radius(vr);
+    v.occupants(list + first, list + last);
+    cells_.push_back(v);
+    cellKeys_.push_back(code);
+  }
+
+  std::size_t capacity = 16;
+  while (capacity < 2 * cells_.size()) capacity *= 2;
+  slotKeys_.assign(capacity, -1);
+  slotCells_.resize(capacity);
+  for (auto& colorList : colorCells_) colorList.clear();
+  for (size_type c = 0; c < cells_.size(); ++c) {
+    std::size_t slot = slotOf(cellKeys_[c], capacity - 1);
+    while (slotKeys_[slot] >= 0) slot = (slot + 1) & (capacity - 1);
+    slotKeys_[slot] = cellKeys_[c];
+    slotCells_[slot] = c;
+    colorCells_[voxelColor<n_dimensions_>(mortonCoords(cellKeys_[c]))]
+        .push_back(c);
+  }
+}
+
+template <typename Occupant>
+void Grid<Occupant>::scatterOccupants(const Occupant& pc, long whichThread,
+                                      long threadCount) {
+  if (sparse_) return;
+  for (index_type k = whichThread; k < activeCount(pc); k += threadCount) {
+    const index_type ii = activeParticle(k);
+    const long c = pc.container(ii);
+    if (c >= 0)
+      cellList_[cellCursor_[c].fetch_add(1, std::memory_order_relaxed)] = ii;
+  }
+}
+
+template <typename Occupant>
+void Grid<Occupant>::sortOccupants(long whichThread, long threadCount) {
+  // The sparse cell list comes out sorted
+  if (sparse_) return;
+  for (size_type ii = whichThread; ii < occupied_.size(); ii += threadCount) {
+    const size_type c = occupied_[ii];
+    cellCursor_[c].store(0, std::memory_order_relaxed);
+    const voxel_type& v = voxels_[c];
+    if (v.occupancy() < 2) continue;
+    index_type* const first = cellList_.data() + (v.begin() - cellList_.data());
+    std::sort(first, first + v.occupancy());
+  }
+}
+
+template <typename Occupant>
+void Grid<Occupant>::rebuildOccupants(const Occupant& pc) {
+  Grid_::countOccupants(pc, 0, 1);
+  Grid_::allocateOccupants();
+  Grid_::scatterOccupants(pc, 0, 1);
+  Grid_::sortOccupants(0, 1);
+}
+
+template <typename Occupant>
+void Grid<Occupant>::regrow(const vec_type& minsXYZ, const vec_type& maxsXYZ) {
+  delete[] voxels_;
+  voxels_ = 0;
+  mins = minsXYZ;
+  maxs = maxsXYZ;
+  Grid_::initGrid();
+}
+
+template <typename Occupant>
+void Grid<Occupant>::rebinOccupants(Occupant& pc, long whichThread,
+                                    long threadCount) {
+  for (index_type k = whichThread; k < activeCount(pc); k += threadCount) {
+    const index_type ii = activeParticle(k);
+    if (pc.container(ii) >= 0) pc.container(ii, Grid_::cellOf(pc.X(ii)));
+  }
+}
+
+template class Grid<ParticleContainer<k2Dimensions>>;
+template class Grid<ParticleContainer<k3Dimensions>>;
 
 // GridIter
 
@@ -164,8 +520,9 @@ void GridIter<Grid>::initFromGrid(Grid& g) {
   iterator::initVals();
   voxPerDim = g.voxPerDim;
   dimensions = g.voxPerEdge;
-  start_ = neighbor_ = current_ = begin_ = &g[0];
-  end_ = &g[g.size() - 1];
+  start_ = neighbor_ = current_ = begin_ = g.voxels_;
+  // A sparse grid has none
+  end_ = g.size() ? begin_ + g.size() - 1 : begin_;
 }
 
 template <typename Grid>
@@ -317,95 +674,104 @@ bool GridIter<Grid>::incNbhr() {
   }
 }
 
-template class GridIter<Grid<Particle<k2Dimensions>>>;
-template class GridIter<Grid<Particle<k3Dimensions>>>;
+template class GridIter<Grid<ParticleContainer<k2Dimensions>>>;
+template class GridIter<Grid<ParticleContainer<k3Dimensions>>>;
 
-template <typename Particle, typename Grid>
-void _placement_error(Particle& p, Grid& g, const char* message) {
+template <typename Container, typename Grid>
+void _placement_error(const Container& pc, typename Container::size_type i,
+                      Grid& g, const char* message) {
   std::cerr << "An error occured shifting a particle around in the voxels: "
             << message << '\n';
   std::cerr << "If the entry is outside the grid, this could be fixed by "
                "initializing a larger grid\n";
   std::cerr << "Particle: ";
-  p.print(std::cerr);
+  pc.printParticle(i, std::cerr);
   std::cerr << "Grid: ";
   g.print(std::cerr);
   std::exit(EXIT_FAILURE);
 }
 
-template void
-_placement_error<Particle<k2Dimensions>, Grid<Particle<k2Dimensions>>>(
-    Particle<k2Dimensions>& p, Grid<Particle<k2Dimensions>>& g,
-    const char* message);
-
-template void
-_placement_error<Particle<k3Dimensions>, Grid<Particle<k3Dimensions>>>(
-    Particle<k3Dimensions>& p, Grid<Particle<k3Dimensions>>& g,
-    const char* message);
-
-template <typename Particle, typename Grid>
-void _place_particle(Particle& p, Grid& g) {
-  typename Grid::voxel_type* vox = g.getVoxelFromPosition(p.X());
-  if (vox == 0) {
-    return _placement_error(p, g, "Entry Is Outside Of Grid");
+template void _placement_error<ParticleContainer<k2Dimensions>,
+                               Grid<ParticleContainer<k2Dimensions>>>(
+    const ParticleContainer<k2Dimensions>& pc,
+    ParticleContainer<k2Dimensions>::size_type i,
+    Grid<ParticleContainer<k2Dimensions>>& g, const char* message);
+
+template void _placement_error<ParticleContainer<k3Dimensions>,
+                               Grid<ParticleContainer<k3Dimensions>>>(
+    const ParticleContainer<k3Dimensions>& pc,
+    ParticleContainer<k3Dimensions>::size_type i,
+    Grid<ParticleContainer<k3Dimensions>>& g, const char* message);
+
+template <typename Container, typename Grid>
+void _place_particle(Container& pc, typename Container::size_type i, Grid& g) {
+  const long c = g.cellOf(pc.X(i));
+  if (c < 0) {
+    return _placement_error(pc, i, g, "Entry Is Outside Of Grid");
   }
-  if (vox->lock() != 0)
-    return _placement_error(p, g, "Failed to acquire lock on voxel");
-  vox->insert(p);
-  vox->unlock();
-  p.container(vox->index());
+  pc.container(i, c);
 }
 
-template void
-_place_particle<Particle<k2Dimensions>, Grid<Particle<k2Dimensions>>>(
-    Particle<k2Dimensions>& p, Grid<Particle<k2Dimensions>>& g);
-
-template void
-_place_particle<Particle<k3Dimensions>, Grid<Particle<k3Dimensions>>>(
-    Particle<k3Dimensions>& p, Grid<Particle<k3Dimensions>>& g);
-
-template <typename Particle, typename Grid>
-void _remove_particle(Particle& p, Grid& g) {
-  if (p.container() < 0) {
-    return _placement_error(p, g, "Remove is illegitimate");
+template void _place_particle<ParticleContainer<k2Dimensions>,
+                              Grid<ParticleContainer<k2Dimensions>>>(
+    ParticleContainer<k2Dimensions>& pc,
+    ParticleContainer<k2Dimensions>::size_type i,
+    Grid<ParticleContainer<k2Dimensions>>& g);
+
+template void _place_particle<ParticleContainer<k3Dimensions>,
+                              Grid<ParticleContainer<k3Dimensions>>>(
+    ParticleContainer<k3Dimensions>& pc,
+    ParticleContainer<k3Dimensions>::size_type i,
+    Grid<ParticleContainer<k3Dimensions>>& g);
+
+template <typename Container, typename Grid>
+void _remove_particle(Container& pc, typename Container::size_type i,
+                      Grid& g) {
+  if (pc.container(i) < 0) {
+    return _placement_error(pc, i, g, "Remove is illegitimate");
   }
-  typename Grid::voxel_type* vox = &(g[p.container()]);
-  vox->lock();
-  vox->remove(p);
-  vox->unlock();
-  p.container(-1);
+  pc.container(i, -1);
 }
 
-template void
-_remove_particle<Particle<k2Dimensions>, Grid<Particle<k2Dimensions>>>(
-    Particle<k2Dimensions>& p, Grid<Particle<k2Dimensions>>& g);
+template void _remove_particle<ParticleContainer<k2Dimensions>,
+                               Grid<ParticleContainer<k2Dimensions>>>(
+    ParticleContainer<k2Dimensions>& pc,
+    ParticleContainer<k2Dimensions>::size_type i,
+    Grid<ParticleContainer<k2Dimensions>>& g);
 
-template void
-_remove_particle<Particle<k3Dimensions>, Grid<Particle<k3Dimensions>>>(
-    Particle<k3Dimensions>& p, Grid<Particle<k3Dimensions>>& g);
+template void _remove_particle<ParticleContainer<k3Dimensions>,
+                               Grid<ParticleContainer<k3Dimensions>>>(
+    ParticleContainer<k3Dimensions>& pc,
+    ParticleContainer<k3Dimensions>::size_type i,
+    Grid<ParticleContainer<k3Dimensions>>& g);
 
-template <typename Particle, typename Grid>
-void shift_particle(Particle& p, Grid& g) {
+template <typename Container, typename Grid>
+void shift_particle(Container& pc, typename Container::size_type i, Grid& g) {
   // Check to see if the particle has even left the current voxel, which is
-  // usually not the case.
-  if (p.container() >= 0) {
-    const typename Grid::voxel_type& v = g[p.container()];
-    if (v.check_inclusion_fuzzy(p.X())) {
+  // usually not the case. The voxels of a sparse grid come and go, so there
+  // it just gets placed again.
+  if (pc.container(i) >= 0 && !g.sparse()) {
+    const typename Grid::voxel_type& v = g[pc.container(i)];
+    if (v.check_inclusion_fuzzy(pc.X(i))) {
       // The particle has not left the voxel
       return;
     }
-    _remove_particle(p, g);
+    _remove_particle(pc, i, g);
   }
-  _place_particle(p, g);
+  _place_particle(pc, i, g);
 }
 
-template void
-shift_particle<Particle<k2Dimensions>, Grid<Particle<k2Dimensions>>>(
-    Particle<k2Dimensions>& p, Grid<Particle<k2Dimensions>>& g);
-
-template void
-shift_particle<Particle<k3Dimensions>, Grid<Particle<k3Dimensions>>>(
-    Particle<k3Dimensions>& p, Grid<Particle<k3Dimensions>>& g);
+template void shift_particle<ParticleContainer<k2Dimensions>,
+                             Grid<ParticleContainer<k2Dimensions>>>(
+    ParticleContainer<k2Dimensions>& pc,
+    ParticleContainer<k2Dimensions>::size_type i,
+    Grid<ParticleContainer<k2Dimensions>>& g);
+
+template void shift_particle<ParticleContainer<k3Dimensions>,
+                             Grid<ParticleContainer<k3Dimensions>>>(
+    ParticleContainer<k3Dimensions>& pc,
+    ParticleContainer<k3Dimensions>::size_type i,
+    Grid<ParticleContainer<k3Dimensions>>& g);
 
 }  // namespace lib
 }  // namespace lgl
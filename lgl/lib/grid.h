@@ -1,6 +1,11 @@
 #ifndef LGL_LIB_GRID_H_
 #define LGL_LIB_GRID_H_
 
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "pthread_wrapper.h"
 #include "types.h"
 #include "voxel.h"
@@ -11,8 +16,49 @@ namespace lib {
 template <typename Grid>
 class GridIter;
 
+// The voxels are split into colors for the repulsive phase (see
+// GridSchedule_MTS::colors). This is how far apart voxels of the same color
+// are in dimension d, and the color of the voxel at coordinates c.
+inline long voxelColorStride(unsigned int d, unsigned int dimensions) {
+  return d + 1 == dimensions ? 2 : 3;
+}
+
+template <Dimension D>
+unsigned int voxelColorCount() {
+  unsigned int count = 1;
+  for (unsigned int d = 0; d < D; ++d) count *= voxelColorStride(d, D);
+  return count;
+}
+
+template <Dimension D>
+unsigned int voxelColor(const FixedVec<long, D>& c) {
+  unsigned int color = 0;
+  for (unsigned int d = D; d-- > 0;) {
+    const long stride = voxelColorStride(d, D);
+    color = color * stride + c[d] % stride;
+  }
+  return color;
+}
+
 // This is a simple cubical grid. The number of rows=cols=levels.
 // It is essential a handler for voxels that generate the grid.
+// Occupant is the particle container whose indices fill the voxels.
+//
+// The occupants are kept as a cell list: one array of particle indices sorted
+// by voxel (and by index within a voxel), which each voxel points a range
+// into. Moving a particle only updates its container index; the cell list is
+// rebuilt from those indices once per iteration, by the four phases below.
+// Counting also marks the voxels that have occupants in a bitmap, so the
+// rest of the rebuild and the interactions only ever visit those, however
+// big and empty the grid is (see occupiedCells).
+//
+// The grid can also be sparse, in which case only the voxels that are
+// occupied exist, and only for the iteration. They are rebuilt with the cell
+// list, and found by the Morton code of their coordinates, which is what the
+// particles hold as their container index then. Memory thus goes with the
+// particle count rather than with the volume, which suits layouts that are
+// huge or very spread out. GridIter doesn't work on a sparse grid; use
+// occupiedCells and occupiedNeighbours instead.
 template <typename Occupant>
 class Grid : public Amutex {
   friend class GridIter<Grid<Occupant>>;
@@ -24,6 +70,7 @@ class Grid : public Amutex {
   typedef typename Occupant::precision precision;
   typedef typename Occupant::vec_type vec_type;
   typedef Voxel<n_dimensions_> voxel_type;
+  typedef typename voxel_type::occupant_type index_type;
   typedef GridIter<Grid<Occupant>> iterator;
 
  private:
@@ -38,12 +85,62 @@ class Grid : public Amutex {
   vec_type mins;         // Xmin Ymin Zmin etc ...
   vec_type maxs;         // Xmax Ymax Zmax etc ...
   Vec_l voxPerDim;
+  std::vector<index_type> cellList_;
+  // Per voxel: the occupant count while counting, then the next free slot in
+  // cellList_ while scattering. Reset to 0 when sorting.
+  std::vector<std::atomic<size_type>> cellCursor_;
+  // Dense only: the voxels in Z order, and the position of each voxel in it.
+  // The occupancy bitmap goes by that position, so the occupied voxels come
+  // out of it in Z order.
+  std::vector<size_type> zOrderVoxels_;
+  std::vector<size_type> zRanks_;
+  std::vector<std::atomic<std::uint64_t>> occupiedBits_;
+  std::vector<size_type> occupied_;
+
+  // The sparse backend. The occupied voxels, by Morton code, then an open
+  // addressing table from Morton code to their position in cells_ (-1 for
+  // a free slot).
+  bool sparse_ = false;
+  std::vector<voxel_type> cells_;
+  std::vector<long> cellKeys_;
+  std::vector<long> slotKeys_;
+  std::vector<size_type> slotCells_;
+  // The occupied voxels of each color, on either backend
+  std::vector<std::vector<size_type>> colorCells_;
+  // What each thread found in countOccupants, as sorted (code, particle)
+  typedef std::pair<long, index_type> keyed_index;
+  std::vector<std::vector<keyed_index>> runs_ =
+      std::vector<std::vector<keyed_index>>(1);
+  std::vector<keyed_index> merged_;
+  // The particles that the rebuild looks at, or null for all of them
+  const std::vector<index_type>* active_ = 0;
 
  private:
   void initVoxels();
 
   void allocate();
 
+  void allocateSparseOccupants();
+
+  // How many particles the rebuild looks at, and the k-th of them.
+  index_type activeCount(const Occupant& pc) const {
+    return active_ ? active_->size() : pc.size();
+  }
+  index_type activeParticle(index_type k) const {
+    return active_ ? (*active_)[k] : k;
+  }
+
+  // Sets up zOrderVoxels_ and zRanks_.
+  void orderVoxels();
+
+  static Vec_l mortonCoords(long code);
+
+  // The coordinates of the dense voxel with the given index.
+  Vec_l coordsOf(size_type entry) const;
+
+  // The position of the voxel with the given code in cells_, or -1.
+  long findCell(long code) const;
+
  public:
   Grid() : voxels_(0) {}
 
@@ -58,8 +155,69 @@ class Grid : public Amutex {
   // point would be in. The current
   voxel_type* getVoxelFromPosition(const vec_type& x) const;
 
+  // Switches to the sparse backend. Has to be done before initGrid.
+  void sparse(bool s) { sparse_ = s; }
+  bool sparse() const { return sparse_; }
+
+  // The most threads that will share the rebuild of the cell list.
+  void threads(long threadCount) { runs_.resize(threadCount); }
+
+  // Restricts the rebuild of the cell list, and rebinOccupants, to the
+  // given particles, which have to take in every particle that has a voxel.
+  // Null for all of them.
+  void activeParticles(const std::vector<index_type>* a) { active_ = a; }
+
+  // What the container index of a particle at x should be: the index of its
+  // voxel, or its Morton code on a sparse grid. -1 if x isn't in the grid.
+  long cellOf(const vec_type& x) const;
+
+  // The position of the voxel at coordinates c along a Z-order curve, which
+  // keeps voxels that are close in space close in the order.
+  static long mortonCode(const Vec_l& c);
+
+  // The Morton code of the voxel that x is in. x has to be in the grid.
+  long zOrder(const vec_type& x) const;
+
+  // The occupied voxels of the given color in Z order, as positions for
+  // cell(). Those are the voxel indices on a dense grid. Valid from
+  // allocateOccupants to the next countOccupants.
+  const std::vector<size_type>& occupiedCells(unsigned int color) const {
+    return colorCells_[color];
+  }
+  voxel_type& cell(size_type c) { return sparse_ ? cells_[c] : voxels_[c]; }
+
+  // The occupied voxels among the ones that GridIter::incNbhr visits from
+  // cell c, which is the first of them. nbhrs needs room for 14. Returns how
+  // many there are.
+  int occupiedNeighbours(size_type c, voxel_type** nbhrs);
+
   void print(std::ostream& o = std::cout) const;
 
+  // Cell list rebuild. Each phase has to be finished by all the threads
+  // before any of them starts the next one. The threaded phases split the
+  // work by striding over the active particles or the occupied voxels.
+  // 1) Count the occupants of every voxel.
+  void countOccupants(const Occupant& pc, long whichThread, long threadCount);
+  // 2) Serial: turn the counts into ranges and hand those to the voxels.
+  void allocateOccupants();
+  // 3) Drop every particle index into its voxel's range.
+  void scatterOccupants(const Occupant& pc, long whichThread,
+                        long threadCount);
+  // 4) Sort each range, so that the interaction order is deterministic.
+  void sortOccupants(long whichThread, long threadCount);
+
+  // All of the above on the calling thread.
+  void rebuildOccupants(const Occupant& pc);
+
+  // Resizes the grid to cover at least [minsXYZ, maxsXYZ]. Every voxel gets
+  // replaced, so iterators and voxel lists have to be renewed, and the
+  // occupants have to be rebinned before the cell list is rebuilt.
+  void regrow(const vec_type& minsXYZ, const vec_type& maxsXYZ);
+
+  // Puts every particle that has a voxel back into the one at its position,
+  // striding over the particles like countOccupants.
+  void rebinOccupants(Occupant& pc, long whichThread, long threadCount);
+
   void min(const vec_type& m) { mins = m; }
   void max(const vec_type& m) { maxs = m; }
   void voxelWidth(precision l) { voxelLength = l; }
@@ -208,22 +366,26 @@ class GridIter {
   }
 };
 
-template <typename Particle, typename Grid>
-void _placement_error(Particle& p, Grid& g, const char* message);
+template <typename Container, typename Grid>
+void _placement_error(const Container& pc, typename Container::size_type i,
+                      Grid& g, const char* message);
+
+// These only maintain the container index of the particle. Voxel contents
+// catch up the next time the cell list is rebuilt.
 
 // The particle does not have to be in the grid
 // this to work.
-template <typename Particle, typename Grid>
-void _place_particle(Particle& p, Grid& g);
+template <typename Container, typename Grid>
+void _place_particle(Container& pc, typename Container::size_type i, Grid& g);
 
 // This assumes the particle is already in the grid.
 // If the particle is not....!!
-template <typename Particle, typename Grid>
-void _remove_particle(Particle& p, Grid& g);
+template <typename Container, typename Grid>
+void _remove_particle(Container& pc, typename Container::size_type i, Grid& g);
 
 // This assumes the particle is already in the grid.
-template <typename Particle, typename Grid>
-void shift_particle(Particle& p, Grid& g);
+template <typename Container, typename Grid>
+void shift_particle(Container& pc, typename Container::size_type i, Grid& g);
 
 }  // namespace lib
 }  // namespace lgl
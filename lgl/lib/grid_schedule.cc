@@ -1,5 +1,8 @@
 #include "grid_schedule.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace lgl {
 namespace lib {
 
@@ -128,6 +131,31 @@ typename GridSchedule_MTS<Grid>::size_type GridSchedule_MTS<Grid>::getVoxelList(
   return jj;
 }
 
+template <typename Grid>
+unsigned int GridSchedule_MTS<Grid>::colors() {
+  return voxelColorCount<n_dimensions_>();
+}
+
+template <typename Grid>
+void GridSchedule_MTS<Grid>::gridRegrown() {
+  GS_::initFromGrid(*grid);
+}
+
+template <typename Grid>
+void GridSchedule_MTS<Grid>::balanceColors() {
+  colorQueues.resize(GS_::colors());
+  for (unsigned int color = 0; color < GS_::colors(); ++color) {
+    // The pairs within a voxel go with the square of its occupancy, and the
+    // ones with its neighbours about the same in a crowded region
+    weights.clear();
+    for (typename Grid::size_type c : grid->occupiedCells(color)) {
+      const size_type occupancy = grid->cell(c).occupancy();
+      weights.push_back(occupancy * occupancy);
+    }
+    colorQueues[color].build(weights, threadCount);
+  }
+}
+
 template <typename Occupant>
 bool GridSchedule_MTS<Occupant>::getNextVoxel(iterator& i) {
   size_type occupancy = 0;
@@ -170,8 +198,8 @@ void GridSchedule_MTS<Grid>::printVoxelList(std::ostream& o) const {
   }
 }
 
-template class GridSchedule_MTS<Grid<Particle<k2Dimensions>>>;
-template class GridSchedule_MTS<Grid<Particle<k3Dimensions>>>;
+template class GridSchedule_MTS<Grid<ParticleContainer<k2Dimensions>>>;
+template class GridSchedule_MTS<Grid<ParticleContainer<k3Dimensions>>>;
 
 }  // namespace lib
 }  // namespace lgl
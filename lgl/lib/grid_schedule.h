@@ -3,11 +3,13 @@
 
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 #include "grid.h"
-#include "particle.h"
+#include "particle_container.h"
 #include "types.h"
 #include "voxel.h"
+#include "work_queue.h"
 
 namespace lgl {
 namespace lib {
@@ -39,6 +41,8 @@ class GridSchedule_MTS {
   size_type gridSize;
   Amutex mutex;
   size_type currentVoxel;
+  std::vector<WorkQueue> colorQueues;
+  std::vector<WorkQueue::size_type> weights;
 
   // Not sure what to do with these
   GridSchedule_MTS() { GS_::initVars(); }
@@ -62,6 +66,24 @@ class GridSchedule_MTS {
 
   size_type getVoxelList(long thread, Vec_l* l);
 
+  // The voxels are split into colors for the repulsive phase. Voxels of the
+  // same color are at least 3 apart in every dimension but the last and 2
+  // apart in the last, so the half shells that GridIter::incNbhr visits from
+  // them don't overlap. Every particle thus has a single writer while the
+  // threads work through one color, and the colors are run one after another.
+  static unsigned int colors();
+
+  // Picks up a change in the size of the grid (see Grid::regrow).
+  void gridRegrown();
+
+  // Splits the occupied voxels of each color into chunks of about the same
+  // work for the threads to take from colorQueue, by the current occupancy.
+  // Has to be redone after every Grid::allocateOccupants.
+  void balanceColors();
+
+  // The work of the given color, as positions in Grid::occupiedCells.
+  WorkQueue& colorQueue(unsigned int color) { return colorQueues[color]; }
+
   bool getNextVoxel(iterator& i);
   void renew();
 
@@ -0,0 +1,71 @@
+#include "id_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lgl {
+namespace lib {
+
+void IdTable::clear() {
+  names_.clear();
+  offsets_.assign(1, 0);
+  slots_.assign(16, Slot{0, -1});
+}
+
+std::uint32_t IdTable::hash(const char* id, std::size_t length) {
+  // FNV-1a
+  std::uint32_t h = 2166136261u;
+  for (std::size_t ii = 0; ii < length; ++ii) {
+    h = (h ^ static_cast<unsigned char>(id[ii])) * 16777619u;
+  }
+  return h;
+}
+
+int IdTable::add(const char* id, std::size_t length) {
+  if (2 * (size() + 1) > static_cast<int>(slots_.size())) grow();
+  const int index = size();
+  names_.insert(names_.end(), id, id + length);
+  names_.push_back(0);
+  offsets_.push_back(names_.size());
+
+  const std::uint32_t h = hash(id, length);
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t s = h & mask;
+  while (slots_[s].index >= 0) s = (s + 1) & mask;
+  slots_[s] = Slot{h, index};
+  return index;
+}
+
+int IdTable::find(const char* id, std::size_t length) const {
+  const std::uint32_t h = hash(id, length);
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t s = h & mask; slots_[s].index >= 0; s = (s + 1) & mask) {
+    const Slot& slot = slots_[s];
+    if (slot.hash == h && idLength(slot.index) == length &&
+        std::memcmp(this->id(slot.index), id, length) == 0) {
+      return slot.index;
+    }
+  }
+  return -1;
+}
+
+bool IdTable::less(int a, int b) const {
+  const std::size_t la = idLength(a), lb = idLength(b);
+  const int c = std::memcmp(id(a), id(b), std::min(la, lb));
+  return c < 0 || (c == 0 && la < lb);
+}
+
+void IdTable::grow() {
+  std::vector<Slot> old(2 * slots_.size(), Slot{0, -1});
+  old.swap(slots_);
+  const std::size_t mask = slots_.size() - 1;
+  for (const Slot& slot : old) {
+    if (slot.index < 0) continue;
+    std::size_t s = slot.hash & mask;
+    while (slots_[s].index >= 0) s = (s + 1) & mask;
+    slots_[s] = slot;
+  }
+}
+
+}  // namespace lib
+}  // namespace lgl
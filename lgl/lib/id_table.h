@@ -0,0 +1,62 @@
+#ifndef LGL_LIB_ID_TABLE_H_
+#define LGL_LIB_ID_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lgl {
+namespace lib {
+
+// The ids of the vertices of a graph, numbered 0, 1, ... in the order they
+// are added. The ids are kept once, one after the other in an arena and
+// each followed by a 0, so an id is found from its index by offset. The
+// index of an id is found through an open addressing hash table of the
+// indices.
+class IdTable {
+ public:
+  IdTable() { clear(); }
+
+  void clear();
+
+  // Adds an id that isn't there yet, returning its index.
+  int add(const char* id, std::size_t length);
+  int add(const std::string& id) { return add(id.c_str(), id.size()); }
+
+  int size() const { return static_cast<int>(offsets_.size()) - 1; }
+
+  // The id of index, a 0 terminated string that stays valid until the
+  // table changes
+  const char* id(int index) const { return names_.data() + offsets_[index]; }
+  std::size_t idLength(int index) const {
+    return offsets_[index + 1] - offsets_[index] - 1;
+  }
+
+  // The index of id, or -1 if it isn't there.
+  int find(const char* id, std::size_t length) const;
+  int find(const std::string& id) const { return find(id.c_str(), id.size()); }
+
+  // Whether the id of a comes before that of b, by their bytes.
+  bool less(int a, int b) const;
+
+ private:
+  struct Slot {
+    std::uint32_t hash;
+    int index;
+  };
+
+  static std::uint32_t hash(const char* id, std::size_t length);
+  void grow();
+
+  std::vector<char> names_;
+  // Where each id starts in names_, and where the next one would
+  std::vector<std::size_t> offsets_;
+  // A power of 2 of them, at most half taken
+  std::vector<Slot> slots_;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_ID_TABLE_H_
@@ -1,14 +1,21 @@
 #include "io.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "binary_graph.h"
 #include "boost/graph/breadth_first_search.hpp"
 #include "boost/graph/visitors.hpp"
 #include "boost/lexical_cast.hpp"
-#include "boost/tokenizer.hpp"
+#include "csr_graph.h"
 #include "graph.h"
+#include "graph_parser.h"
 #include "types.h"
 
 namespace lgl {
@@ -20,10 +27,58 @@ struct vertex_id_compare {
   vertex_id_compare(const Graph& g1) : g(g1) {}
   bool operator()(const typename Graph::vertex_descriptor v1,
                   const typename Graph::vertex_descriptor v2) const {
-    return g.idFromIndex(v1) < g.idFromIndex(v2);
+    return g.vertexIdMap().less(v1, v2);
   }
 };
 
+// Fills g with the parsed edges, in the order of the file. Of the
+// duplicates of a weighted edge the lightest is kept.
+template <typename Graph>
+void buildGraph(Graph& g, const ParsedGraph& parsed) {
+  typedef typename Graph::boost_graph BG;
+  typedef typename Graph::vertex_index_map VIM;
+
+  auto idmap = std::make_shared<VIM>();
+  for (const std::string& id : parsed.ids) {
+    idmap->add(id);
+  }
+  BG bg(parsed.ids.size());
+  const bool hasweight = !parsed.weights.empty();
+  for (std::size_t ii = 0; ii < parsed.edges.size(); ++ii) {
+    const ParsedGraph::Edge& e = parsed.edges[ii];
+    if (!hasweight) {
+      add_edge(e.first, e.second, bg);
+      continue;
+    }
+    typename Graph::weight_type w = parsed.weights[ii];
+    typename Graph::edge_descriptor eee;
+    bool found = false;
+    std::tie(eee, found) = edge(e.first, e.second, bg);
+    if (found) {
+      w = std::min(w, get(boost::edge_weight, bg)[eee]);
+      get(boost::edge_weight, bg)[eee] = w;
+    } else {
+      add_edge(e.first, e.second, w, bg);
+    }
+  }
+
+  g.boostGraph(bg);
+  if (hasweight) {
+    g.hasWeights(true);
+  }
+  g.vertexIdMap(std::move(idmap));
+}
+
+template <typename Weight>
+void buildGraph(CsrGraph<Weight>& g, const ParsedGraph& parsed) {
+  auto idmap = std::make_shared<IdTable>();
+  for (const std::string& id : parsed.ids) {
+    idmap->add(id);
+  }
+  g = CsrGraph<Weight>(parsed.ids.size(), parsed.edges, parsed.weights);
+  g.vertexIdMap(std::move(idmap));
+}
+
 template <typename Graph>
 void writeLGL(const Graph& g, const char* file) {
   const typename Graph::boost_graph& bg = g.boostGraph();
@@ -57,13 +112,15 @@ void writeLGL(const Graph& g, const char* file) {
     if (ee1 == ee2) {
       continue;
     }
-    std::string lines("# " + ids.findFormer(v1) + '\n');
+    std::string lines("# ");
+    lines += ids.id(v1);
+    lines += '\n';
     bool entry = false;
     while (ee1 != ee2) {
       v2 = target(*ee1, bg);
-      if (g.idFromIndex(v1) < g.idFromIndex(v2)) {
+      if (ids.less(v1, v2)) {
         entry = true;
-        lines += ids.findFormer(v2);
+        lines += ids.id(v2);
         if (g.hasWeights()) {
           lines += " " + boost::lexical_cast<std::string, W>(g.getWeight(*ee1));
         }
@@ -78,6 +135,51 @@ void writeLGL(const Graph& g, const char* file) {
 }
 template void writeLGL(const Graph<FloatType>& g, const char* file);
 
+void writeLGL(const CsrGraph<FloatType>& g, const char* file) {
+  typedef CsrGraph<FloatType>::vertex_descriptor vertex_descriptor;
+  const IdTable& ids = g.vertexIdMap();
+
+  if (g.edgeCount() == 0) {
+    return;
+  }
+
+  std::ofstream out(file);
+  if (!out) {
+    std::cerr << "writeLGL: Open of " << file << " failed.\n";
+    exit(EXIT_FAILURE);
+  }
+
+  // Sort based on ids
+  std::vector<vertex_descriptor> vertices(g.vertexCount());
+  for (vertex_descriptor v = 0; v < vertices.size(); ++v) vertices[v] = v;
+  std::sort(vertices.begin(), vertices.end(),
+            [&ids](vertex_descriptor a, vertex_descriptor b) {
+              return ids.less(a, b);
+            });
+
+  for (vertex_descriptor v1 : vertices) {
+    std::string lines("# ");
+    lines += ids.id(v1);
+    lines += '\n';
+    bool entry = false;
+    const FloatType* w = g.weightsBegin(v1);
+    for (const vertex_descriptor* v2 = g.neighboursBegin(v1);
+         v2 != g.neighboursEnd(v1); ++v2, ++w) {
+      if (ids.less(v1, *v2)) {
+        entry = true;
+        lines += ids.id(*v2);
+        if (g.hasWeights()) {
+          lines += " " + boost::lexical_cast<std::string, FloatType>(*w);
+        }
+        lines += '\n';
+      }
+    }
+    if (entry) {
+      out << lines;
+    }
+  }
+}
+
 template <typename Graph>
 void writeNCOL(const Graph& g, const char* file) {
   const typename Graph::boost_graph& bg = g.boostGraph();
@@ -115,10 +217,11 @@ void writeNCOL(const Graph& g, const char* file) {
     bool entry = false;
     while (ee1 != ee2) {
       v2 = target(*ee1, bg);
-      if (g.idFromIndex(v1) < g.idFromIndex(v2)) {
+      if (ids.less(v1, v2)) {
         entry = true;
-        lines += ids.findFormer(v1) + " ";
-        lines += ids.findFormer(v2);
+        lines += ids.id(v1);
+        lines += ' ';
+        lines += ids.id(v2);
         if (g.hasWeights()) {
           lines += " " + boost::lexical_cast<std::string, W>(g.getWeight(*ee1));
         }
@@ -141,144 +244,201 @@ template void readLGL(Graph<FloatType>& g, const char* file);
 
 template <typename Graph>
 void readLGL(Graph& g, const char* file, typename Graph::weight_type cutoff) {
-  typedef typename Graph::boost_graph BG;
-  typedef typename Graph::vertex_index_map VIM;
-  typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
-  typename Graph::weight_type
-      w{};  // value-initializing to avoid non-legit warning on line 804: ‘w’
-            // may be used uninitialized in this function
-            // [-Wmaybe-uninitialized]
-
-  std::ifstream in(file);
-  if (!in) {
-    std::cerr << "readLGL: Open of " << file << " failed.\n";
+  ParsedGraph parsed;
+  try {
+    parseLGL(file, parsed, -std::numeric_limits<float>::infinity(), cutoff);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "readLGL: " << e.what() << '\n';
     exit(EXIT_FAILURE);
   }
+  buildGraph(g, parsed);
+}
+template void readLGL(Graph<FloatType>& g, const char* file,
+                      typename Graph<FloatType>::weight_type cutoff);
+template void readLGL(CsrGraph<FloatType>& g, const char* file,
+                      FloatType cutoff);
+
+template <typename Graph>
+void readNCOL(Graph& g, const char* file) {
+  ParsedGraph parsed;
+  try {
+    parseNCOL(file, parsed);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "readNCOL: " << e.what() << '\n';
+    exit(EXIT_FAILURE);
+  }
+  buildGraph(g, parsed);
+}
+template void readNCOL(Graph<FloatType>& g, const char* file);
+template void readNCOL(CsrGraph<FloatType>& g, const char* file);
 
-  boost::char_separator<char> sep(" ");
-  VIM idmap;
-  BG bg;
-  int index = 0;
-  int u = 0, v = 0;
+template <typename Graph>
+void readBinaryGraph(Graph& g, const char* file) {
+  readBinaryGraph(g, file,
+                  std::numeric_limits<typename Graph::weight_type>::max());
+}
+template void readBinaryGraph(Graph<FloatType>& g, const char* file);
 
-  bool hasweight = false;
-  std::string head(256, ' ');
+template <typename Graph>
+void readBinaryGraph(Graph& g, const char* file,
+                     typename Graph::weight_type cutoff) {
+  typedef typename Graph::boost_graph BG;
+  typedef typename Graph::vertex_index_map VIM;
+  typedef BinaryGraph::size_type size_type;
 
-  while (true) {
-    std::string id1(256, ' ');
-    std::string id2(256, ' ');
-    char l[256];
-    if (in.eof()) {
-      break;
-    }
-    in.getline(l, 256);
-    std::string line(l);
-    // cout << "LINE: " << line << endl;
-    if (line == "") {
-      break;
-    }
-    tokenizer tokens(line, sep);
-    tokenizer::iterator tok_iter = tokens.begin();
-    id1 = *tok_iter++;
-    if (tok_iter != tokens.end()) {
-      id2 = *tok_iter;
-    }
-    // cout << "IDS: " << id1 << " " << id2 << endl;
-    if (id1 == "#") {
-      head = id2;
-      continue;
-    } else {
-      if (id2[0] != ' ') {
-        w = atof(id2.c_str());
-        hasweight = true;
-      }
-      if (hasweight && w > cutoff) {
-        continue;
-      }
-      if (idmap.doesMapExist(head)) {
-        u = idmap.findLatter(head);
-      } else {
-        idmap.createMap(head, index);
-        u = index++;
-      }
-      if (idmap.doesMapExist(id1)) {
-        v = idmap.findLatter(id1);
-      } else {
-        idmap.createMap(id1, index);
-        v = index++;
+  BinaryGraph bin;
+  try {
+    bin.open(file);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "readBinaryGraph: " << e.what() << '\n';
+    exit(EXIT_FAILURE);
+  }
+  const bool hasweight = bin.hasWeights();
+
+  // The vertices that keep an edge, in the order of the file
+  std::vector<int> index(bin.vertexCount(), -1);
+  int count = 0;
+  for (size_type v = 0; v < bin.vertexCount(); ++v) {
+    const float* w = bin.weightsBegin(v);
+    for (const BinaryGraph::vertex_type* u = bin.neighboursBegin(v);
+         u != bin.neighboursEnd(v); ++u, ++w) {
+      if (!hasweight || *w <= cutoff) {
+        index[v] = count++;
+        break;
       }
     }
-    if (!hasweight) {
-      add_edge(u, v, bg);
-    } else {
-      // Take the lowest edge if it is redundant
-      int nv = num_vertices(bg);
-      typename Graph::edge_descriptor eee;
-      bool found = false;
-      if (nv > u && nv > v) {
-        std::tie(eee, found) = edge(u, v, bg);
-      }
-      if (found) {
-        w = std::min(w, get(boost::edge_weight, bg)[eee]);
-        get(boost::edge_weight, bg)[eee] = w;
-      } else {
-        add_edge(u, v, w, bg);
+  }
+
+  auto idmap = std::make_shared<VIM>();
+  BG bg(count);
+  for (size_type v = 0; v < bin.vertexCount(); ++v) {
+    if (index[v] < 0) continue;
+    idmap->add(bin.id(v), bin.idLength(v));
+    const float* w = bin.weightsBegin(v);
+    for (const BinaryGraph::vertex_type* u = bin.neighboursBegin(v);
+         u != bin.neighboursEnd(v); ++u, ++w) {
+      // Each edge once
+      if (*u < v) continue;
+      if (!hasweight) {
+        add_edge(index[v], index[*u], bg);
+      } else if (*w <= cutoff) {
+        add_edge(index[v], index[*u], *w, bg);
       }
     }
-    // cout << "READ: ADDED " << u << " " << v << " " << w << endl;
   }
 
   g.boostGraph(bg);
   if (hasweight) {
     g.hasWeights(true);
   }
-  g.vertexIdMap(idmap);
+  g.vertexIdMap(std::move(idmap));
 }
-template void readLGL(Graph<FloatType>& g, const char* file,
-                      typename Graph<FloatType>::weight_type cutoff);
-
-template <typename Graph>
-void readNCOL(Graph& g, const char* file) {
-  typedef typename Graph::boost_graph BG;
-  typedef typename Graph::vertex_index_map VIM;
-
-  std::ifstream in(file);
-  if (!in) {
-    std::cerr << "readNCOL: Open of " << file << " failed.\n";
+template void readBinaryGraph(Graph<FloatType>& g, const char* file,
+                              typename Graph<FloatType>::weight_type cutoff);
+
+void readBinaryGraph(CsrGraph<FloatType>& g, const char* file,
+                     FloatType cutoff) {
+  typedef BinaryGraph::size_type size_type;
+  typedef CsrGraph<FloatType>::Edge Edge;
+
+  BinaryGraph bin;
+  try {
+    bin.open(file);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "readBinaryGraph: " << e.what() << '\n';
     exit(EXIT_FAILURE);
   }
+  const bool hasweight = bin.hasWeights();
+
+  // As for Graph, the vertices that keep an edge, in the order of the file
+  std::vector<int> index(bin.vertexCount(), -1);
+  int count = 0;
+  for (size_type v = 0; v < bin.vertexCount(); ++v) {
+    const float* w = bin.weightsBegin(v);
+    for (const BinaryGraph::vertex_type* u = bin.neighboursBegin(v);
+         u != bin.neighboursEnd(v); ++u, ++w) {
+      if (!hasweight || *w <= cutoff) {
+        index[v] = count++;
+        break;
+      }
+    }
+  }
+
+  auto idmap = std::make_shared<IdTable>();
+  std::vector<Edge> edges;
+  std::vector<FloatType> weights;
+  edges.reserve(bin.edgeCount());
+  if (hasweight) weights.reserve(bin.edgeCount());
+  for (size_type v = 0; v < bin.vertexCount(); ++v) {
+    if (index[v] < 0) continue;
+    idmap->add(bin.id(v), bin.idLength(v));
+    const float* w = bin.weightsBegin(v);
+    for (const BinaryGraph::vertex_type* u = bin.neighboursBegin(v);
+         u != bin.neighboursEnd(v); ++u, ++w) {
+      // Each edge once
+      if (*u < v || (hasweight && *w > cutoff)) continue;
+      edges.push_back(Edge(index[v], index[*u]));
+      if (hasweight) weights.push_back(*w);
+    }
+  }
+  bin.close();
 
-  VIM idmap;
-  BG bg;
-  int index = 0;
+  g = CsrGraph<FloatType>(count, edges, weights);
+  g.vertexIdMap(std::move(idmap));
+}
 
-  std::string id1(256, ' ');
-  std::string id2(256, ' ');
+template <typename Graph>
+void writeBinaryGraph(const Graph& g, const char* file) {
+  const typename Graph::boost_graph& bg = g.boostGraph();
+  typename Graph::out_edge_iterator ee1, ee2;
 
-  in >> id1;
-  while (id1 != "" && !in.eof()) {
-    int u, v;
-    if (idmap.doesMapExist(id1)) {
-      u = idmap.findLatter(id1);
-    } else {
-      idmap.createMap(id1, index);
-      u = index++;
-    }
-    in >> id2;
-    if (idmap.doesMapExist(id2)) {
-      v = idmap.findLatter(id2);
-    } else {
-      idmap.createMap(id2, index);
-      v = index++;
+  // In the order of the vertex indices, so the graph reads back the same
+  std::vector<BinaryGraph::size_type> offsets(1, 0);
+  std::vector<BinaryGraph::vertex_type> targets;
+  std::vector<float> weights;
+  std::vector<std::string> ids;
+  offsets.reserve(g.vertexCount() + 1);
+  targets.reserve(2 * g.edgeCount());
+  ids.reserve(g.vertexCount());
+  for (typename Graph::vertices_size_type v = 0; v < g.vertexCount(); ++v) {
+    for (std::tie(ee1, ee2) = out_edges(v, bg); ee1 != ee2; ++ee1) {
+      targets.push_back(target(*ee1, bg));
+      if (g.hasWeights()) {
+        weights.push_back(g.getWeight(*ee1));
+      }
     }
-    add_edge(u, v, bg);
-    in >> id1;
+    offsets.push_back(targets.size());
+    ids.push_back(g.idFromIndex(v));
   }
 
-  g.boostGraph(bg);
-  g.vertexIdMap(idmap);
+  try {
+    BinaryGraph::write(file, offsets, targets, weights, ids);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "writeBinaryGraph: " << e.what() << '\n';
+    exit(EXIT_FAILURE);
+  }
 }
-template void readNCOL(Graph<FloatType>& g, const char* file);
+template void writeBinaryGraph(const Graph<FloatType>& g, const char* file);
+
+template <typename Graph>
+void readGraph(Graph& g, const char* file) {
+  readGraph(g, file, std::numeric_limits<typename Graph::weight_type>::max());
+}
+template void readGraph(Graph<FloatType>& g, const char* file);
+template void readGraph(CsrGraph<FloatType>& g, const char* file);
+
+template <typename Graph>
+void readGraph(Graph& g, const char* file, typename Graph::weight_type cutoff) {
+  if (BinaryGraph::isBinaryGraph(file)) {
+    readBinaryGraph(g, file, cutoff);
+  } else {
+    readLGL(g, file, cutoff);
+  }
+}
+template void readGraph(Graph<FloatType>& g, const char* file,
+                        typename Graph<FloatType>::weight_type cutoff);
+template void readGraph(CsrGraph<FloatType>& g, const char* file,
+                        FloatType cutoff);
 
 template <typename Graph, typename LevelMap>
 void writeLevelMap2File(const Graph& g, const LevelMap& levels,
@@ -301,105 +461,47 @@ void writeLevelMap2File(const Graph& g, const LevelMap& levels,
     level_type l1 = levels[v1];
     level_type l2 = levels[v2];
     level_type l = GraphDetail::mmax<level_type>(l1, l2);
-    out << ids.findFormer(v1) << " " << ids.findFormer(v2) << " " << l << '\n';
+    out << ids.id(v1) << " " << ids.id(v2) << " " << l << '\n';
   }
 }
 template void writeLevelMap2File(const Graph<FloatType>& g,
                                  const std::vector<unsigned>& levels,
                                  const char* file);
 
-template <typename Graph>
-void readLGL_weightMin(Graph& g, const char* file,
-                       typename Graph::weight_type cutoff) {
-  typedef typename Graph::boost_graph BG;
-  typedef typename Graph::vertex_index_map VIM;
-  typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
-  typename Graph::weight_type w;
+void writeLevelMap2File(const CsrGraph<FloatType>& g,
+                        const std::vector<unsigned>& levels,
+                        const char* file) {
+  typedef CsrGraph<FloatType>::vertex_descriptor vertex_descriptor;
+  const IdTable& ids = g.vertexIdMap();
 
-  std::ifstream in(file);
-  if (!in) {
-    std::cerr << "readLGL: Open of " << file << " failed.\n";
+  std::ofstream out(file);
+  if (!out) {
+    std::cerr << "writeLevelMap2File: Open of " << file << " failed.\n";
     exit(EXIT_FAILURE);
   }
 
-  boost::char_separator<char> sep(" ");
-  VIM idmap;
-  BG bg;
-  int index = 0;
-  int u = 0, v = 0;
-
-  bool hasweight = false;
-  std::string head(256, ' ');
-
-  while (true) {
-    std::string id1(256, ' ');
-    std::string id2(256, ' ');
-    char l[256];
-    if (in.eof()) {
-      break;
-    }
-    in.getline(l, 256);
-    std::string line(l);
-    // cout << "LINE: " << line << endl;
-    if (line == "") {
-      break;
-    }
-    tokenizer tokens(line, sep);
-    tokenizer::iterator tok_iter = tokens.begin();
-    id1 = *tok_iter++;
-    if (tok_iter != tokens.end()) {
-      id2 = *tok_iter;
-    }
-    // cout << "IDS: " << id1 << " " << id2 << endl;
-    if (id1 == "#") {
-      head = id2;
-      continue;
-    } else {
-      if (id2[0] != ' ') {
-        w = atof(id2.c_str());
-        hasweight = true;
-      }
-      if (hasweight && w <= cutoff) {
-        continue;
-      }
-      if (idmap.doesMapExist(head)) {
-        u = idmap.findLatter(head);
-      } else {
-        idmap.createMap(head, index);
-        u = index++;
-      }
-      if (idmap.doesMapExist(id1)) {
-        v = idmap.findLatter(id1);
-      } else {
-        idmap.createMap(id1, index);
-        v = index++;
-      }
+  for (vertex_descriptor v1 = 0; v1 < g.vertexCount(); ++v1) {
+    for (const vertex_descriptor* v2 = g.neighboursBegin(v1);
+         v2 != g.neighboursEnd(v1); ++v2) {
+      // Each edge once
+      if (*v2 < v1) continue;
+      const unsigned l = std::max(levels[v1], levels[*v2]);
+      out << ids.id(v1) << " " << ids.id(*v2) << " " << l << '\n';
     }
-    if (!hasweight) {
-      add_edge(u, v, bg);
-    } else {
-      // Take the lowest edge if it is redundant
-      int nv = num_vertices(bg);
-      typename Graph::edge_descriptor eee;
-      bool found = false;
-      if (nv > u && nv > v) {
-        tie(eee, found) = edge(u, v, bg);
-      }
-      if (found) {
-        w = std::min(w, get(boost::edge_weight, bg)[eee]);
-        get(boost::edge_weight, bg)[eee] = w;
-      } else {
-        add_edge(u, v, w, bg);
-      }
-    }
-    // cout << "READ: ADDED " << u << " " << v << " " << w << endl;
   }
+}
 
-  g.boostGraph(bg);
-  if (hasweight) {
-    g.hasWeights(true);
+template <typename Graph>
+void readLGL_weightMin(Graph& g, const char* file,
+                       typename Graph::weight_type cutoff) {
+  ParsedGraph parsed;
+  try {
+    parseLGL(file, parsed, cutoff);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "readLGL: " << e.what() << '\n';
+    exit(EXIT_FAILURE);
   }
-  g.vertexIdMap(idmap);
+  buildGraph(g, parsed);
 }
 template void readLGL_weightMin(Graph<FloatType>& g, const char* file,
                                 typename Graph<FloatType>::weight_type cutoff);
@@ -423,7 +525,7 @@ int writeCurrentLGL(Graph<FloatType>& g, const char* outfile, int cset,
          ++ei) {
       v1 = source(*ei, g.boostGraph());
       v2 = target(*ei, g.boostGraph());
-      if (g.idFromIndex(v1) > g.idFromIndex(v2)) {
+      if (g.vertexIdMap().less(v2, v1)) {
         continue;
       }
       if (already.find(v1) == already.end()) {
@@ -447,7 +549,7 @@ int writeCurrentLGL(Graph<FloatType>& g, const char* outfile, int cset,
     }
   }
 
-  newG.vertexIdMap(g.vertexIdMap());
+  newG.vertexIdMap(g.sharedIdMap());
   if (g.hasWeights() && madeit) {
     newG.hasWeights(true);
   }
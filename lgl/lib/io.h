@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include "csr_graph.h"
 #include "graph.h"
 
 namespace lgl {
@@ -13,6 +14,8 @@ typedef std::vector<std::vector<int>> WriteList;
 template <typename Graph>
 void writeLGL(const Graph& g, const char* file);
 
+void writeLGL(const CsrGraph<FloatType>& g, const char* file);
+
 template <typename Graph>
 void writeNCOL(const Graph& g, const char* file);
 
@@ -25,10 +28,36 @@ void readLGL(Graph& g, const char* file, typename Graph::weight_type cutoff);
 template <typename Graph>
 void readNCOL(Graph& g, const char* file);
 
+// The binary format of BinaryGraph. Like readLGL, leaves out the edges
+// heavier than the cutoff, and the vertices that are left without any.
+template <typename Graph>
+void readBinaryGraph(Graph& g, const char* file);
+
+template <typename Graph>
+void readBinaryGraph(Graph& g, const char* file,
+                     typename Graph::weight_type cutoff);
+
+void readBinaryGraph(CsrGraph<FloatType>& g, const char* file,
+                     FloatType cutoff);
+
+template <typename Graph>
+void writeBinaryGraph(const Graph& g, const char* file);
+
+// Reads a binary graph if the file is one, and an LGL file otherwise. Like
+// readLGL and readNCOL, it fills a CsrGraph as well as a Graph.
+template <typename Graph>
+void readGraph(Graph& g, const char* file);
+
+template <typename Graph>
+void readGraph(Graph& g, const char* file, typename Graph::weight_type cutoff);
+
 template <typename Graph, typename LevelMap>
 void writeLevelMap2File(const Graph& g, const LevelMap& levels,
                         const char* file);
 
+void writeLevelMap2File(const CsrGraph<FloatType>& g,
+                        const std::vector<unsigned>& levels, const char* file);
+
 template <typename Graph>
 void readLGL_weightMin(Graph& g, const char* file,
                        typename Graph::weight_type cutoff);
@@ -0,0 +1,204 @@
+#include "layout_edges.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace lgl {
+namespace lib {
+
+template <Dimension D>
+void LayoutEdges<D>::rebuild(const CsrGraphView<FloatType>& g,
+                             const ParticleContainer<D>& pc,
+                             const std::vector<unsigned>& lm,
+                             unsigned int currentLevel,
+                             unsigned int threadCount) {
+  const size_type vertexCount = g.vertexCount();
+  offsets_.assign(vertexCount + 1, 0);
+  inGraph_.assign(vertexCount, 0);
+  targets_.clear();
+  targetFactor_.clear();
+  counted_.clear();
+  for (size_type v = 0; v < vertexCount; ++v) {
+    g.forEachNeighbour(v, [&](size_type other) {
+      targets_.push_back(other);
+      targetFactor_.push_back(pc.isAnchor(other) ? 2 : 1);
+      counted_.push_back(lm[v] == currentLevel || lm[other] == currentLevel);
+    });
+    offsets_[v + 1] = targets_.size();
+    inGraph_[v] = offsets_[v + 1] > offsets_[v] || g.hasVertex(v);
+  }
+  ends_.assign(offsets_.begin() + 1, offsets_.end());
+  levelRows_ = false;
+  touched_.clear();
+  LayoutEdges<D>::splitRows(threadCount);
+}
+
+template <Dimension D>
+void LayoutEdges<D>::addLevel(const LevelIndex& index,
+                              const ParticleContainer<D>& pc,
+                              unsigned int level, unsigned int threadCount) {
+  if (level <= 1 || !levelRows_ || vertexCount() != index.vertexCount()) {
+    LayoutEdges<D>::reserveLevels(index, pc);
+  }
+  // Only the edges of the new level touch it, so only they count. Those of
+  // the last one are the ends of the rows that took them.
+  for (size_type v : touched_) {
+    for (size_type ii = ends_[v]; ii-- > offsets_[v] && counted_[ii] != 0;) {
+      counted_[ii] = 0;
+    }
+  }
+  touched_.clear();
+  index.forEachEdge(level, [this](size_type v, size_type u) {
+    LayoutEdges<D>::activate(v);
+    if (u != v) LayoutEdges<D>::activate(u);
+  });
+  LayoutEdges<D>::splitRows(threadCount);
+}
+
+template <Dimension D>
+void LayoutEdges<D>::reserveLevels(const LevelIndex& index,
+                                   const ParticleContainer<D>& pc) {
+  const size_type vertexCount = index.vertexCount();
+  // The edges of level 0 never come into the layout
+  offsets_.assign(vertexCount + 1, 0);
+  for (unsigned int l = 1; l < index.levelCount(); ++l) {
+    index.forEachEdge(l, [this](size_type v, size_type u) {
+      ++offsets_[v + 1];
+      if (u != v) ++offsets_[u + 1];
+    });
+  }
+  for (size_type v = 0; v < vertexCount; ++v) offsets_[v + 1] += offsets_[v];
+  targets_.resize(offsets_[vertexCount]);
+  targetFactor_.resize(offsets_[vertexCount]);
+  counted_.assign(offsets_[vertexCount], 0);
+  ends_.assign(offsets_.begin(), offsets_.end() - 1);
+  // The arcs of each row go level by level, so that those in use are the
+  // ones up to ends_
+  for (unsigned int l = 1; l < index.levelCount(); ++l) {
+    index.forEachEdge(l, [this, &pc](size_type v, size_type u) {
+      targets_[ends_[v]] = u;
+      targetFactor_[ends_[v]++] = pc.isAnchor(u) ? 2 : 1;
+      if (u != v) {
+        targets_[ends_[u]] = v;
+        targetFactor_[ends_[u]++] = pc.isAnchor(v) ? 2 : 1;
+      }
+    });
+  }
+  ends_.assign(offsets_.begin(), offsets_.end() - 1);
+  inGraph_.assign(vertexCount, 0);
+  levelRows_ = true;
+  touched_.clear();
+}
+
+template <Dimension D>
+void LayoutEdges<D>::renumber(const std::vector<size_type>& order,
+                              const std::vector<size_type>& newIndex,
+                              unsigned int threadCount) {
+  const size_type oldCount = vertexCount();
+  std::vector<size_type> offsets(order.size() + 1, 0);
+  std::vector<size_type> targets;
+  std::vector<FloatType> targetFactor, counted;
+  std::vector<size_type> ends(order.size(), 0);
+  std::vector<char> inGraph(order.size(), 0);
+  targets.reserve(targets_.size());
+  targetFactor.reserve(targets_.size());
+  counted.reserve(targets_.size());
+  for (size_type v = 0; v < order.size(); ++v) {
+    // The graph may not have had all the particles as vertices
+    const size_type old = order[v];
+    if (old < oldCount) {
+      inGraph[v] = inGraph_[old];
+      for (size_type ii = offsets_[old]; ii < offsets_[old + 1]; ++ii) {
+        targets.push_back(newIndex[targets_[ii]]);
+        targetFactor.push_back(targetFactor_[ii]);
+        counted.push_back(counted_[ii]);
+      }
+      ends[v] = offsets[v] + (ends_[old] - offsets_[old]);
+    } else {
+      ends[v] = offsets[v];
+    }
+    offsets[v + 1] = targets.size();
+  }
+  for (size_type& v : touched_) v = newIndex[v];
+  offsets_.swap(offsets);
+  targets_.swap(targets);
+  targetFactor_.swap(targetFactor);
+  counted_.swap(counted);
+  ends_.swap(ends);
+  inGraph_.swap(inGraph);
+  LayoutEdges<D>::splitRows(threadCount);
+}
+
+template <Dimension D>
+void LayoutEdges<D>::splitRows(unsigned int threadCount) {
+  const size_type vertexCount = LayoutEdges<D>::vertexCount();
+  bounds_.assign(threadCount + 1, vertexCount);
+  bounds_[0] = 0;
+  for (unsigned int t = 1; t < threadCount; ++t) {
+    const size_type goal = targets_.size() * t / threadCount;
+    const size_type v =
+        std::lower_bound(offsets_.begin(), offsets_.end(), goal) -
+        offsets_.begin();
+    bounds_[t] = std::min(std::max(v, bounds_[t - 1]), vertexCount);
+  }
+}
+
+template <Dimension D>
+void LayoutEdges<D>::springInteractions(const ParticleInteractionHandler<D>& ih,
+                                        ParticleContainer<D>& pc,
+                                        size_type first, size_type last,
+                                        double& dx, size_type& ctr) const {
+  const EllipseFactors& ef = ih.ellipseFactors();
+  const FloatType k = ih.springConstant();
+  const FloatType eq = ih.eqDistance();
+  const FloatType* x[D];
+  FloatType e[D];
+  for (unsigned int d = 0; d < D; ++d) {
+    x[d] = pc.x(d);
+    e[d] = ef.empty() ? 1 : ef[d];
+  }
+  const size_type* const targets = targets_.data();
+  const FloatType* const targetFactor = targetFactor_.data();
+  const FloatType* const counted = counted_.data();
+
+  // Wide, as a float stops counting at 2^24
+  double sum = 0;
+  size_type count = 0;
+  for (size_type v = first; v < last; ++v) {
+    FloatType xv[D], fv[D];
+    for (unsigned int d = 0; d < D; ++d) {
+      xv[d] = x[d][v];
+      fv[d] = 0;
+    }
+    // Branch free, so the compiler is free to vectorize the row
+    for (size_type ii = offsets_[v]; ii < ends_[v]; ++ii) {
+      const size_type j = targets[ii];
+      FloatType r2 = 0, m2 = 0, ed[D];
+      for (unsigned int d = 0; d < D; ++d) {
+        const FloatType diff = xv[d] - x[d][j];
+        r2 += diff * diff;
+        ed[d] = diff * e[d];
+        m2 += ed[d] * ed[d];
+      }
+      const FloatType r = std::sqrt(r2);
+      const FloatType m = std::sqrt(m2);
+      const FloatType scale =
+          r > eq ? -k * (m - eq) / m * targetFactor[ii] : FloatType(0);
+      for (unsigned int d = 0; d < D; ++d) fv[d] += ed[d] * scale;
+      sum += r * counted[ii];
+      count += static_cast<size_type>(counted[ii]);
+    }
+    if (!pc.isAnchor(v)) {
+      for (unsigned int d = 0; d < D; ++d) pc.f(v, d, pc.f(v, d) + fv[d]);
+    }
+  }
+  dx += sum;
+  ctr += count;
+}
+
+template class LayoutEdges<k2Dimensions>;
+template class LayoutEdges<k3Dimensions>;
+
+}  // namespace lib
+}  // namespace lgl
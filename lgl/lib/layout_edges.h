@@ -0,0 +1,109 @@
+#ifndef LGL_LIB_LAYOUT_EDGES_H_
+#define LGL_LIB_LAYOUT_EDGES_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "csr_graph.h"
+#include "particle_container.h"
+#include "particle_interaction_handler.h"
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+// A snapshot of the layout graph in compressed sparse row form, with what the
+// spring pass needs of each edge next to it, so the pass streams through
+// flat arrays. Every undirected edge is stored from both ends, so the row of
+// a vertex holds all its neighbours. It has to be rebuilt whenever the
+// layout graph or the current level changes, but for the levels of a tree
+// layout, which addLevel takes on in place.
+template <Dimension D>
+class LayoutEdges {
+ public:
+  typedef typename ParticleContainer<D>::size_type size_type;
+
+  void rebuild(const CsrGraphView<FloatType>& g,
+               const ParticleContainer<D>& pc, const std::vector<unsigned>& lm,
+               unsigned int currentLevel, unsigned int threadCount);
+
+  // Adds the edges of level, those whose later end is at it, to rows that
+  // hold the layout graph up to the level before, which gives the edges of
+  // the next view of a tree layout. Level 1 lays the rows out with room for
+  // all the levels, the arcs of each row by level, so each level after it
+  // only has to take in the arcs that follow the ones in use: it touches
+  // just the vertices of the level and their rows.
+  void addLevel(const LevelIndex& index, const ParticleContainer<D>& pc,
+                unsigned int level, unsigned int threadCount);
+
+  size_type vertexCount() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+  }
+
+  // Whether particle v is a vertex of the layout graph. After a renumber
+  // there is a row for every particle, but not all of them are.
+  bool hasVertex(size_type v) const {
+    return v < inGraph_.size() && inGraph_[v];
+  }
+
+  // The rows of the vertices that thread whichThread owns. The split is by
+  // edges rather than by vertices, so the threads get about the same work.
+  size_type firstVertex(unsigned int whichThread) const {
+    return bounds_[whichThread];
+  }
+  size_type lastVertex(unsigned int whichThread) const {
+    return bounds_[whichThread + 1];
+  }
+
+  // Pulls the spring forces of the rows [first, last) onto their vertices, as
+  // ParticleInteractionHandler::springRepulsiveInteractionOn would for every
+  // edge that is longer than the handler's eqDistance. Adds the lengths of the
+  // edges that touch the current level to dx and counts them in ctr.
+  void springInteractions(const ParticleInteractionHandler<D>& ih,
+                          ParticleContainer<D>& pc, size_type first,
+                          size_type last, double& dx, size_type& ctr) const;
+
+  // Follows a renumbering of the particles, particle order[i] becoming
+  // particle i and newIndex being the inverse of order. Cheaper than a
+  // rebuild, and the rows don't have to come from a graph in the new order.
+  void renumber(const std::vector<size_type>& order,
+                const std::vector<size_type>& newIndex,
+                unsigned int threadCount);
+
+ private:
+  // Splits the rows between the threads, by their room rather than the arcs
+  // in use, for a tree layout.
+  void splitRows(unsigned int threadCount);
+
+  // Lays out the rows of all the levels of index, none of them in use.
+  void reserveLevels(const LevelIndex& index, const ParticleContainer<D>& pc);
+
+  // Takes the next arc of the row of v in use, for the current level.
+  void activate(size_type v) {
+    const size_type ii = ends_[v]++;
+    counted_[ii] = 1;
+    inGraph_[v] = 1;
+    touched_.push_back(v);
+  }
+
+  // The row of v starts at offsets_[v], and the arcs in use end at ends_[v],
+  // which is before offsets_[v + 1] while the levels are being taken on.
+  std::vector<size_type> offsets_;
+  std::vector<size_type> ends_;
+  std::vector<size_type> targets_;
+  // 2 if the target is an anchor, else 1
+  std::vector<FloatType> targetFactor_;
+  // 1 if the edge counts towards the stats of the current level, else 0
+  std::vector<FloatType> counted_;
+  std::vector<char> inGraph_;
+  std::vector<size_type> bounds_;
+  // Whether the rows are laid out by level, and the rows that took arcs of
+  // the current level, some more than once
+  bool levelRows_ = false;
+  std::vector<size_type> touched_;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_LAYOUT_EDGES_H_
@@ -0,0 +1,40 @@
+#ifndef LGL_LIB_PARALLEL_CHUNKS_H_
+#define LGL_LIB_PARALLEL_CHUNKS_H_
+
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace lgl {
+namespace lib {
+
+// Where chunk c of chunks even pieces of [0, count) starts
+inline std::size_t chunkStart(std::size_t count, unsigned int chunks,
+                              unsigned int c) {
+  return count * c / chunks;
+}
+
+// Calls f(c, first, last) for each chunk c of chunks even pieces of
+// [0, count) on pool, and waits for them. One chunk runs on the calling
+// thread, and pool may be null then.
+template <typename F>
+void forChunks(thread_pool* pool, unsigned int chunks, std::size_t count,
+               F f) {
+  if (chunks <= 1) {
+    f(0u, std::size_t(0), count);
+    return;
+  }
+  std::vector<std::future<void>> futures;
+  for (unsigned int c = 0; c < chunks; ++c) {
+    futures.push_back(pool->run(f, c, chunkStart(count, chunks, c),
+                                chunkStart(count, chunks, c + 1)));
+  }
+  for (auto& fu : futures) fu.get();
+}
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_PARALLEL_CHUNKS_H_
@@ -1,35 +1,132 @@
 #include "particle_container.h"
 
+#include <algorithm>
+
 #include "types.h"
 
 namespace lgl {
 namespace lib {
 
-template <Dimension D>
-void ParticleContainer<D>::initParticles() {
-  for (size_type ii = 0; ii < size(); ++ii) {
-    particles_[ii].index(ii);
-  }
-}
-
 template <Dimension D>
 void ParticleContainer<D>::resize(size_type s) {
-  const size_type old_size = size();
   ids.resize(s);
-  particles_.resize(s);
-  for (size_type ii = old_size; ii < s; ++ii) {
-    particles_[ii].index(ii);
-    particles_[ii].container(-1);
+  for (unsigned int d = 0; d < D; ++d) {
+    x_[d].resize(s, 0);
+    f_[d].assign(s, 0);
   }
+  resetMotion(0);
+  mass_.resize(s, 0);
+  radius_.resize(s, 0);
+  container_.resize(s, -1);
+  anchors_.resize(s, false);
 }
 
 template <Dimension D>
 void ParticleContainer<D>::erase(size_type index) {
-  particles_.erase(particles_.begin() + index);
   ids.erase(ids.begin() + index);
-  for (size_type ii = index; ii < size(); ++ii) {
-    particles_[ii].index(ii);
-    particles_[ii].container(-1);
+  for (unsigned int d = 0; d < D; ++d) {
+    x_[d].erase(x_[d].begin() + index);
+    f_[d].erase(f_[d].begin() + index);
+    v_[d].erase(v_[d].begin() + index);
+  }
+  stepFactor_.erase(stepFactor_.begin() + index);
+  mixing_.erase(mixing_.begin() + index);
+  downhill_.erase(downhill_.begin() + index);
+  mass_.erase(mass_.begin() + index);
+  radius_.erase(radius_.begin() + index);
+  anchors_.erase(anchors_.begin() + index);
+  container_.erase(container_.begin() + index);
+  std::fill(container_.begin() + index, container_.end(), -1);
+}
+
+namespace {
+
+template <typename T>
+void permuteVector(std::vector<T>& v, const std::vector<std::size_t>& order) {
+  std::vector<T> permuted(v.size());
+  for (std::size_t ii = 0; ii < order.size(); ++ii) permuted[ii] = v[order[ii]];
+  v.swap(permuted);
+}
+
+}  // namespace
+
+template <Dimension D>
+void ParticleContainer<D>::permute(const std::vector<size_type>& order) {
+  permuteVector(ids, order);
+  for (unsigned int d = 0; d < D; ++d) {
+    permuteVector(x_[d], order);
+    permuteVector(f_[d], order);
+    permuteVector(v_[d], order);
+  }
+  permuteVector(stepFactor_, order);
+  permuteVector(mixing_, order);
+  permuteVector(downhill_, order);
+  permuteVector(mass_, order);
+  permuteVector(radius_, order);
+  permuteVector(container_, order);
+  permuteVector(anchors_, order);
+}
+
+template <Dimension D>
+void ParticleContainer<D>::resetMotion(FloatType mixing) {
+  const size_type s = ids.size();
+  for (unsigned int d = 0; d < D; ++d) v_[d].assign(s, 0);
+  stepFactor_.assign(s, 1);
+  mixing_.assign(s, mixing);
+  downhill_.assign(s, 0);
+}
+
+template <Dimension D>
+bool ParticleContainer<D>::isPositionInitialized(size_type i) const noexcept {
+  // TODO 'initialize' and compare against a big number instead of 0?
+  for (unsigned int d = 0; d < D; ++d) {
+    if (x_[d][i] != 0.f) return true;
+  }
+  return false;
+}
+
+template <Dimension D>
+bool ParticleContainer<D>::collisionCheck(size_type i, size_type j) const {
+  return separation2(i, j) <= sqr(radius_[i] + radius_[j]);
+}
+
+template <Dimension D>
+FloatType ParticleContainer<D>::separation2(size_type i, size_type j) const {
+  FloatType distance = 0;
+  for (unsigned int d = 0; d < D; ++d) distance += sqr(x_[d][i] - x_[d][j]);
+  return distance;
+}
+
+template <Dimension D>
+FloatType ParticleContainer<D>::separation(size_type i, size_type j) const {
+  return sqrt(separation2(i, j));
+}
+
+template <Dimension D>
+void ParticleContainer<D>::printParticle(size_type i, std::ostream& o) const {
+  o << "Index: " << i << "\tId: " << ids[i] << '\t' << "M: " << mass_[i]
+    << '\t' << "R: " << radius_[i] << "\tCont: " << container_[i] << '\n';
+  o << "\tX: ";
+  printXCoords(i, o);
+  o << '\n';
+  o << "\tF: ";
+  printFCoords(i, o);
+  o << '\n';
+}
+
+template <Dimension D>
+void ParticleContainer<D>::printXCoords(size_type i, std::ostream& o) const {
+  o << x_[0][i];
+  for (unsigned int d = 1; d < D; ++d) {
+    o << " " << x_[d][i];
+  }
+}
+
+template <Dimension D>
+void ParticleContainer<D>::printFCoords(size_type i, std::ostream& o) const {
+  o << f_[0][i];
+  for (unsigned int d = 1; d < D; ++d) {
+    o << " " << f_[d][i];
   }
 }
 
@@ -37,4 +134,4 @@ template class ParticleContainer<k2Dimensions>;
 template class ParticleContainer<k3Dimensions>;
 
 }  // namespace lib
-}  // namespace lgl
\ No newline at end of file
+}  // namespace lgl
@@ -5,64 +5,153 @@
 #include <string>
 #include <vector>
 
-#include "particle.h"
+#include "fixed_vec.h"
 #include "types.h"
 
 namespace lgl {
 namespace lib {
 
+// Holds every particle of the simulation as a structure of arrays. Coordinate
+// d of particle i is x_[d][i], and likewise for the forces, so the hot loops
+// only stream through the arrays they actually use. Particles are addressed by
+// their index, which is the same as the vertex index in the graph.
+//
+// Nothing here is synchronized. The simulation phases are scheduled so that
+// every particle has a single writer at a time (see GridSchedule_MTS::colors).
 template <Dimension D>
 class ParticleContainer {
  public:
-  typedef Particle<D> particle_type;
   static const Dimension n_dimensions_ = D;
-  using container_type = std::vector<Particle<D>>;
-  using size_type = typename container_type::size_type;
-  using iterator = typename container_type::iterator;
+  typedef FloatType precision;
+  typedef FixedVec<FloatType, D> vec_type;
+  typedef std::vector<FloatType>::size_type size_type;
 
  protected:
-  container_type particles_;
+  std::vector<FloatType> x_[D];
+  std::vector<FloatType> f_[D];
+  // The state of the integrators that have one (see Integrator): the
+  // velocity, and FIRE's step factor, mixing factor and downhill steps
+  std::vector<FloatType> v_[D];
+  std::vector<FloatType> stepFactor_;
+  std::vector<FloatType> mixing_;
+  std::vector<unsigned int> downhill_;
+  std::vector<FloatType> mass_;
+  std::vector<FloatType> radius_;
+  // The index of the voxel each particle resides in, or -1.
+  std::vector<long> container_;
+  std::vector<bool> anchors_;
   FloatType avg_temp = 0;
   FloatType avg_dx = 0;
 
  public:
   std::vector<std::string> ids;  // This will hold the names
 
-  void initParticles();
-
  public:
   ParticleContainer() = default;
 
-  explicit ParticleContainer(size_type s) {
-    ParticleContainer<D>::resize(s);
-    ParticleContainer<D>::initParticles();
-  }
+  explicit ParticleContainer(size_type s) { ParticleContainer<D>::resize(s); }
 
+  // Resizing is only meant for setup, as the forces are reset to 0.
   void resize(size_type s);
 
   void erase(size_type index);
 
-  iterator begin() noexcept { return particles_.begin(); }
-  iterator end() noexcept { return particles_.end(); }
+  // Renumbers the particles, moving particle order[i] to index i.
+  void permute(const std::vector<size_type>& order);
 
   FloatType temp() const { return avg_temp; }
   FloatType dx() const { return avg_dx; }
-  size_type size() const { return particles_.size(); }
+  size_type size() const { return mass_.size(); }
+
+  // Raw per-dimension arrays, for loops that want to stream through them.
+  FloatType* x(unsigned int d) { return x_[d].data(); }
+  const FloatType* x(unsigned int d) const { return x_[d].data(); }
+
+  FloatType& x(size_type i, unsigned int d) { return x_[d][i]; }
+  FloatType x(size_type i, unsigned int d) const { return x_[d][i]; }
+
+  vec_type X(size_type i) const {
+    vec_type v;
+    for (unsigned int d = 0; d < D; ++d) v[d] = x_[d][i];
+    return v;
+  }
+
+  void X(size_type i, const vec_type& v) {
+    for (unsigned int d = 0; d < D; ++d) x_[d][i] = v[d];
+  }
 
-  bool operator==(const ParticleContainer<D>& pc) const {
-    return particles_ == pc.particles_;
+  template <typename InputIterator>
+  void X(size_type i, InputIterator begin, InputIterator end) {
+    for (unsigned int d = 0; begin != end; ++begin, ++d) x_[d][i] = *begin;
   }
 
-  Particle<D>& particle(size_type entry) { return particles_[entry]; }
+  FloatType f(size_type i, unsigned int d) const { return f_[d][i]; }
+  void f(size_type i, unsigned int d, FloatType v) { f_[d][i] = v; }
+
+  vec_type F(size_type i) const {
+    vec_type v;
+    for (unsigned int d = 0; d < D; ++d) v[d] = f_[d][i];
+    return v;
+  }
 
-  Particle<D>& operator[](size_type entry) {
-    return ParticleContainer<D>::particle(entry);
+  void F(size_type i, const vec_type& v) {
+    for (unsigned int d = 0; d < D; ++d) f_[d][i] = v[d];
   }
 
+  void add2F(size_type i, const vec_type& v) {
+    for (unsigned int d = 0; d < D; ++d) f_[d][i] += v[d];
+  }
+
+  FloatType& v(size_type i, unsigned int d) { return v_[d][i]; }
+  FloatType v(size_type i, unsigned int d) const { return v_[d][i]; }
+
+  FloatType& stepFactor(size_type i) { return stepFactor_[i]; }
+  FloatType& mixing(size_type i) { return mixing_[i]; }
+  unsigned int& downhill(size_type i) { return downhill_[i]; }
+
+  // Brings every particle to a halt and sets the integrator state back to
+  // the start, with the given mixing factor.
+  void resetMotion(FloatType mixing);
+
+  // The same for particle i alone
+  void resetMotion(size_type i, FloatType mixing) {
+    for (unsigned int d = 0; d < D; ++d) v_[d][i] = 0;
+    stepFactor_[i] = 1;
+    mixing_[i] = mixing;
+    downhill_[i] = 0;
+  }
+
+  FloatType mass(size_type i) const { return mass_[i]; }
+  void mass(size_type i, FloatType m) { mass_[i] = m; }
+
+  FloatType radius(size_type i) const { return radius_[i]; }
+  void radius(size_type i, FloatType r) { radius_[i] = r; }
+
+  long container(size_type i) const { return container_[i]; }
+  void container(size_type i, long c) { container_[i] = c; }
+
+  bool isAnchor(size_type i) const { return anchors_[i]; }
+  void markAnchor(size_type i) { anchors_[i] = true; }
+
+  const std::string& id(size_type i) const { return ids[i]; }
+
+  bool isPositionInitialized(size_type i) const noexcept;
+
+  bool collisionCheck(size_type i, size_type j) const;
+
+  FloatType separation2(size_type i, size_type j) const;
+
+  FloatType separation(size_type i, size_type j) const;
+
+  // Print specific particle info.
+  void printParticle(size_type i, std::ostream& o = std::cout) const;
+  void printXCoords(size_type i, std::ostream& o = std::cout) const;
+  void printFCoords(size_type i, std::ostream& o = std::cout) const;
+
   void print(std::ostream& o = std::cout) const {
     for (size_type ii = 0; ii < size(); ++ii) {
       o << ids[ii] << '\n';
-      particles_[ii].print(o);
+      printParticle(ii, o);
     }
   }
 };
@@ -1,8 +1,9 @@
 #include "particle_container_chaperone.h"
 
+#include <cassert>
 #include <istream>
 
-#include "particle.h"
+#include "particle_container.h"
 #include "types.h"
 
 namespace lgl {
@@ -60,22 +61,22 @@ void ParticleContainerChaperone<D>::orderingError(const char* file) {
 }
 
 template <Dimension D>
-void ParticleContainerChaperone<D>::writeXout(const Particle<D>& p,
+void ParticleContainerChaperone<D>::writeXout(size_type i,
                                               const std::string& id) {
   streams_out[_X_FILE__] << id << " ";
-  p.printXCoords(streams_out[_X_FILE__]);
+  pc_.printXCoords(i, streams_out[_X_FILE__]);
   streams_out[_X_FILE__] << '\n';
 }
 
 template <Dimension D>
-bool ParticleContainerChaperone<D>::setXFromFile(Particle<D>& p,
+bool ParticleContainerChaperone<D>::setXFromFile(size_type i,
                                                  const std::string& id2check) {
   // assuming id2check isn't empty for simplicity of this optimized
   // implementation
   assert(!id2check.empty());
   const auto it = positions_from_file_.find(id2check);
   if (it != positions_from_file_.end()) {
-    p.X(it->second);
+    pc_.X(i, it->second);
     return true;
   }
   return false;
@@ -83,17 +84,17 @@ bool ParticleContainerChaperone<D>::setXFromFile(Particle<D>& p,
 
 template <Dimension D>
 bool ParticleContainerChaperone<D>::setXFromAnchors(
-    Particle<D>& p, const std::string& id2check) const {
+    size_type i, const std::string& id2check) {
   typename AnchorPositions_t::const_iterator const it =
       anchorPositions_.find(id2check);
   if (it == anchorPositions_.end()) return false;
-  p.X(it->second);
-  p.markAnchor();
+  pc_.X(i, it->second);
+  pc_.markAnchor(i);
   return true;
 }
 
 template <Dimension D>
-bool ParticleContainerChaperone<D>::setMFromFile(Particle<D>& p,
+bool ParticleContainerChaperone<D>::setMFromFile(size_type i,
                                                  std::string id2check) {
   std::string id = "";
   if (!streams_in[_M_FILE__].eof() && streams_in[_M_FILE__] >> id) {
@@ -101,7 +102,7 @@ bool ParticleContainerChaperone<D>::setMFromFile(Particle<D>& p,
       chaperone_type::orderingError(file_in[_M_FILE__]);
     }
     streams_in[_M_FILE__] >> initMass_;
-    p.mass(initMass_);
+    pc_.mass(i, initMass_);
     return 1;
   } else {
     return 0;
@@ -150,20 +151,20 @@ void ParticleContainerChaperone<D>::initAllParticles() {
   for (size_type ii = 0; ii < nodeCount; ++ii) {
     const std::string& id = pc_.ids[ii];
     if (file_in[_X_FILE__]) {
-      chaperone_type::setXFromFile(pc_[ii], id);
-    } else if (!chaperone_type::setXFromAnchors(pc_[ii], id)) {
+      chaperone_type::setXFromFile(ii, id);
+    } else if (!chaperone_type::setXFromAnchors(ii, id)) {
       if (randomPos_) {
-        pc_[ii].X(chaperone_type::randomVec(initPos_, posRange_));
+        pc_.X(ii, chaperone_type::randomVec(initPos_, posRange_));
       } else {
-        pc_[ii].X(initPos_);
+        pc_.X(ii, initPos_);
       }
     }
     if (file_in[_M_FILE__]) {
-      chaperone_type::setMFromFile(pc_[ii], id);
+      chaperone_type::setMFromFile(ii, id);
     } else {
-      pc_[ii].mass(initMass_);
+      pc_.mass(ii, initMass_);
     }
-    pc_[ii].radius(radius_);
+    pc_.radius(ii, radius_);
   }
   chaperone_type::closeInFiles();
 }
@@ -175,7 +176,7 @@ void ParticleContainerChaperone<D>::writeOutFiles() {
   for (size_type ii = 0; ii < nodeCount; ++ii) {
     std::string id = pc_.ids[ii];
     if (file_out_flag[_X_FILE__] != 0) {
-      chaperone_type::writeXout(pc_[ii], id);
+      chaperone_type::writeXout(ii, id);
     }
   }
   chaperone_type::closeOutFiles();
@@ -16,7 +16,6 @@
 #include <string>
 #include <unordered_map>
 
-#include "particle.h"
 #include "particle_container.h"
 #include "types.h"
 
@@ -35,7 +34,7 @@ class ParticleContainerChaperone {
 
  public:
   static const Dimension n_dimensions_ = D;
-  typedef typename Particle<D>::vec_type vec_type;
+  typedef typename ParticleContainer<D>::vec_type vec_type;
   typedef typename ParticleContainer<D>::size_type size_type;
 
   ParticleContainer<D>& pc_;
@@ -66,15 +65,15 @@ class ParticleContainerChaperone {
 
   void orderingError(const char* file);
 
-  void writeXout(const Particle<D>& p, const std::string& id);
+  void writeXout(size_type i, const std::string& id);
 
-  bool setXFromFile(Particle<D>& p, const std::string& id2check);
+  bool setXFromFile(size_type i, const std::string& id2check);
 
-  bool setXFromAnchors(Particle<D>& p, const std::string& id2check) const;
+  bool setXFromAnchors(size_type i, const std::string& id2check);
 
-  // bool setVFromFile(Particle<D>& p, string id2check = "");
+  // bool setVFromFile(size_type i, string id2check = "");
 
-  bool setMFromFile(Particle<D>& p, std::string id2check = "");
+  bool setMFromFile(size_type i, std::string id2check = "");
 
   vec_type& randomVec(vec_type& v, FloatType range);
 
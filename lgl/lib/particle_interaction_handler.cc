@@ -3,6 +3,11 @@
 namespace lgl {
 namespace lib {
 
+template <Dimension D>
+constexpr FloatType ParticleInteractionHandler<D>::kMaxStep;
+template <Dimension D>
+constexpr FloatType ParticleInteractionHandler<D>::kFireMaxStepFactor;
+
 template <Dimension D>
 void ParticleInteractionHandler<D>::initVars() {
   timeStep_ = 0;
@@ -31,7 +36,13 @@ void ParticleInteractionHandler<D>::copy(
   springConstant_ = pi.springConstant_;
   eqDistance_ = pi.eqDistance_;
   eqDistanceSquared_ = pi.eqDistanceSquared_;
+  forceConstraint_ = pi.forceConstraint_;
   noiseAmplitude_ = pi.noiseAmplitude_;
+  noise_ = pi.noise_;
+  noiseStep_ = pi.noiseStep_;
+  ellipseFactors_ = pi.ellipseFactors_;
+  integrator_ = pi.integrator_;
+  damping_ = pi.damping_;
   id_ = pi.id_;
 }
 
@@ -42,32 +53,29 @@ void ParticleInteractionHandler<D>::eqDistance(FloatType e) {
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::enforceFLimit(Particle<D>& p1) const {
-  p1.lock();
+void ParticleInteractionHandler<D>::enforceFLimit(container_type& pc,
+                                                  size_type i) const {
   for (unsigned int d = 0; d < D; ++d) {
-    if (p1.f[d] > forceConstraint_) {
-      p1.f[d] = forceConstraint_;
-    } else if (p1.f[d] < -1.0 * forceConstraint_) {
-      p1.f[d] = -1.0 * forceConstraint_;
+    if (pc.f(i, d) > forceConstraint_) {
+      pc.f(i, d, forceConstraint_);
+    } else if (pc.f(i, d) < -1.0 * forceConstraint_) {
+      pc.f(i, d, -1.0 * forceConstraint_);
     }
   }
-  p1.unlock();
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::addNoise(Particle<D>& p1) const {
-  FloatType factor = noiseAmplitude_;
-  typename Particle<D>::vec_type noise;
-  constexpr FloatType divisor = RAND_MAX + 1.0;
-  constexpr int rand_half = (RAND_MAX + 1u) / 2;
+void ParticleInteractionHandler<D>::addNoise(container_type& pc, size_type i,
+                                             size_type j) const {
+  const std::uint64_t stream = noise_.stream(noiseStep_, i, j);
+  vec_type noise;
   for (unsigned d = 0; d < D; ++d) {
-    if (std::rand() < rand_half) factor = -factor;
-    noise[d] = factor * (((FloatType)std::rand()) / divisor);
+    // The lowest bit for the sign, the top ones for the magnitude
+    const std::uint64_t bits = CounterRng::draw(stream, d);
+    const FloatType factor = bits & 1 ? -noiseAmplitude_ : noiseAmplitude_;
+    noise[d] = factor * CounterRng::unit(bits);
   }
-  // no need to lock because particle's force constituents are atomic
-  // p1.lock();
-  p1.add2F(noise);
-  // p1.unlock();
+  pc.add2F(i, noise);
 }
 
 template <Dimension D>
@@ -82,96 +90,169 @@ void ParticleInteractionHandler<D>::ellipseFactors(EllipseFactors ef) {
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::interaction(Particle<D>& p1,
-                                                Particle<D>& p2) const {
-  if (euclideanDistanceSquared(p1.X().begin(), p1.X().end(), p2.X().begin()) <
-      eqDistanceSquared_) {
-    springRepulsiveInteraction(p1, p2);
+void ParticleInteractionHandler<D>::interaction(container_type& pc, size_type i,
+                                                size_type j) const {
+  if (pc.separation2(i, j) < eqDistanceSquared_) {
+    springRepulsiveInteraction(pc, i, j);
   }
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::springRepulsiveInteraction(
-    Particle<D>& p1, Particle<D>& p2) const {
-  const bool p1anchor = p1.isAnchor(), p2anchor = p2.isAnchor();
-  if (p1.collisionCheck(p2)) {
-    if (!p1anchor) addNoise(p1);
-    if (!p2anchor || p1anchor) addNoise(p2);
-    return;
-  }
+bool ParticleInteractionHandler<D>::springForce(const container_type& pc,
+                                                size_type i, size_type j,
+                                                vec_type& f_) const {
+  if (pc.collisionCheck(i, j)) return false;
 
-  vec_type x1 = p1.X();
-  vec_type x2 = p2.X();
+  vec_type x1 = pc.X(i);
+  vec_type x2 = pc.X(j);
 
-  for (std::size_t i = 0; i < ellipseFactors_.size(); ++i) {
-    const EllipseFactors::value_type f = ellipseFactors_[i];
-    x1[i] *= f;
-    x2[i] *= f;
+  for (std::size_t ii = 0; ii < ellipseFactors_.size(); ++ii) {
+    const EllipseFactors::value_type f = ellipseFactors_[ii];
+    x1[ii] *= f;
+    x2[ii] *= f;
   }
 
   const FloatType magx1x2 = x1.distance(x2);
   const FloatType sepFromIdeal = (magx1x2 - eqDistance_);
   const FloatType scale = -springConstant_ * sepFromIdeal / magx1x2;
 
-  vec_type f_;
-  vec_type fm1_;
-
   for (unsigned int ii = 0; ii < D; ++ii) {
     FloatType dx = (x1[ii] - x2[ii]);
 
     // results in a bad image for "the internet"
     // if (dx > eqDistance_) dx = 1.0 / dx;
 
-    FloatType f = dx * scale;
-    f_[ii] = f;
-    fm1_[ii] = -f;
+    f_[ii] = dx * scale;
+  }
+  return true;
+}
+
+template <Dimension D>
+void ParticleInteractionHandler<D>::springRepulsiveInteraction(
+    container_type& pc, size_type i, size_type j) const {
+  const bool p1anchor = pc.isAnchor(i), p2anchor = pc.isAnchor(j);
+  vec_type f_;
+  if (!springForce(pc, i, j, f_)) {
+    if (!p1anchor) addNoise(pc, i, j);
+    if (!p2anchor || p1anchor) addNoise(pc, j, i);
+    return;
   }
 
+  vec_type fm1_;
+  for (unsigned int ii = 0; ii < D; ++ii) fm1_[ii] = -f_[ii];
+
   if (!p1anchor) {
     if (p2anchor) f_.scale(2);
-    // no need to lock because particle's force constituents are atomic
-    // p1.lock();
-    p1.add2F(f_);
-    // p1.unlock();
+    pc.add2F(i, f_);
   }
 
   if (!p2anchor) {
     if (p1anchor) fm1_.scale(2);
-    // no need to lock because particle's force constituents are atomic
-    // p2.lock();
-    p2.add2F(fm1_);
-    // p2.unlock();
+    pc.add2F(j, fm1_);
   }
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::integrate(Particle<D>& p1) const {
-  ParticleInteractionHandler<D>::integrateFirstOrder(p1);
+void ParticleInteractionHandler<D>::springRepulsiveInteractionOn(
+    container_type& pc, size_type i, size_type j) const {
+  const bool p1anchor = pc.isAnchor(i), p2anchor = pc.isAnchor(j);
+  vec_type f_;
+  if (!springForce(pc, i, j, f_)) {
+    if (!p1anchor || p2anchor) addNoise(pc, i, j);
+    return;
+  }
+  if (!p1anchor) {
+    if (p2anchor) f_.scale(2);
+    pc.add2F(i, f_);
+  }
+}
+
+template <Dimension D>
+void ParticleInteractionHandler<D>::integrate(container_type& pc,
+                                              size_type i) const {
+  ParticleInteractionHandler<D>::integrate(pc, i, timeStep_);
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::integrate(Particle<D>& p1,
+void ParticleInteractionHandler<D>::integrate(container_type& pc, size_type i,
                                               FloatType t) const {
-  ParticleInteractionHandler<D>::integrateFirstOrder(p1, t);
+  switch (integrator_) {
+    case Integrator::kFirstOrder:
+      return ParticleInteractionHandler<D>::integrateFirstOrder(pc, i, t);
+    case Integrator::kVerlet:
+      return ParticleInteractionHandler<D>::integrateVerlet(pc, i, t);
+    case Integrator::kFire:
+      return ParticleInteractionHandler<D>::integrateFire(pc, i, t);
+  }
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::integrateFirstOrder(Particle<D>& p1,
+void ParticleInteractionHandler<D>::integrateFirstOrder(container_type& pc,
+                                                        size_type i,
                                                         FloatType t) const {
   for (unsigned int ii = 0; ii < D; ++ii) {
-    FloatType finc = p1.f[ii] * t;
+    FloatType finc = pc.f(i, ii) * t;
     if (finc < 0) {
       finc = -std::min<FloatType>((FloatType).05, abs(finc));
     } else {
       finc = std::min<FloatType>((FloatType).05, finc);
     }
-    p1.x[ii] += finc;
+    pc.x(i, ii) += finc;
   }
 }
 
 template <Dimension D>
-void ParticleInteractionHandler<D>::integrateFirstOrder(Particle<D>& p1) const {
-  ParticleInteractionHandler<D>::integrateFirstOrder(p1, timeStep_);
+void ParticleInteractionHandler<D>::integrateFirstOrder(container_type& pc,
+                                                        size_type i) const {
+  ParticleInteractionHandler<D>::integrateFirstOrder(pc, i, timeStep_);
+}
+
+template <Dimension D>
+void ParticleInteractionHandler<D>::integrateVerlet(container_type& pc,
+                                                    size_type i,
+                                                    FloatType t) const {
+  for (unsigned int d = 0; d < D; ++d) {
+    FloatType& v = pc.v(i, d);
+    v = (1 - damping_) * v + pc.f(i, d) * t;
+    v = std::max(-kMaxStep, std::min(kMaxStep, v));
+    pc.x(i, d) += v;
+  }
+}
+
+template <Dimension D>
+void ParticleInteractionHandler<D>::integrateFire(container_type& pc,
+                                                  size_type i,
+                                                  FloatType t) const {
+  FloatType power = 0, vv = 0, ff = 0;
+  for (unsigned int d = 0; d < D; ++d) {
+    power += pc.f(i, d) * pc.v(i, d);
+    vv += sqr(pc.v(i, d));
+    ff += sqr(pc.f(i, d));
+  }
+  FloatType& step = pc.stepFactor(i);
+  FloatType& mixing = pc.mixing(i);
+  unsigned int& downhill = pc.downhill(i);
+  if (power > 0) {
+    // Turn the velocity towards the force, keeping its magnitude
+    const FloatType a = mixing * std::sqrt(vv / ff);
+    for (unsigned int d = 0; d < D; ++d) {
+      pc.v(i, d) = (1 - mixing) * pc.v(i, d) + a * pc.f(i, d);
+    }
+    if (++downhill > kFireMinDownhill) {
+      step = std::min(step * kFireStepGrowth, kFireMaxStepFactor);
+      mixing *= kFireMixingDecay;
+    }
+  } else {
+    for (unsigned int d = 0; d < D; ++d) pc.v(i, d) = 0;
+    step = std::max(step * kFireStepShrink, FloatType(1));
+    mixing = kFireMixing;
+    downhill = 0;
+  }
+  for (unsigned int d = 0; d < D; ++d) {
+    FloatType& v = pc.v(i, d);
+    v = std::max(-kMaxStep, std::min(kMaxStep, v + pc.f(i, d) * t * step));
+    pc.x(i, d) += v;
+  }
 }
 
 template <Dimension D>
@@ -2,12 +2,14 @@
 #define LGL_LIB_PARTICLE_INTERACTION_HANDLER_H_
 
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
 
 #include "boost/algorithm/cxx11/all_of.hpp"
-#include "particle.h"
+#include "counter_rng.h"
+#include "particle_container.h"
 #include "particle_stats.h"
 #include "types.h"
 
@@ -16,10 +18,24 @@ namespace lib {
 
 typedef std::vector<FloatType> EllipseFactors;
 
+// How integrate moves the particles.
+//  kFirstOrder: by force times time step, as if through a viscous medium.
+//  kVerlet: with momentum, a velocity that keeps (1 - damping) of itself
+//    from one step to the next and picks up force times time step. Damping 1
+//    is first order again.
+//  kFire: the fast inertial relaxation engine, per particle. The velocity
+//    gets turned towards the force, and the step grows while the particle
+//    keeps going downhill; once it goes uphill it stops, and the step
+//    shrinks again, though never below the time step.
+// Either way, no particle moves by more than kMaxStep in any dimension.
+enum class Integrator { kFirstOrder, kVerlet, kFire };
+
 template <Dimension D>
 class ParticleInteractionHandler {
  public:
-  typedef typename Particle<D>::vec_type vec_type;
+  typedef typename ParticleContainer<D>::vec_type vec_type;
+  typedef ParticleContainer<D> container_type;
+  typedef typename container_type::size_type size_type;
 
  protected:
   FloatType timeStep_;
@@ -28,11 +44,29 @@ class ParticleInteractionHandler {
   FloatType eqDistanceSquared_ = 0;  // just for optimization
   FloatType forceConstraint_;
   FloatType noiseAmplitude_;
+  CounterRng noise_;
+  std::uint64_t noiseStep_ = 0;
   EllipseFactors ellipseFactors_;
+  Integrator integrator_ = Integrator::kFirstOrder;
+  FloatType damping_ = .1;
   int id_;
 
+  static constexpr FloatType kMaxStep = .05;
+  // The parameters of FIRE, as in Bitzek et al. (2006), but with the step
+  // factor kept between 1 and kFireMaxStepFactor
+  static const unsigned int kFireMinDownhill = 5;
+  static constexpr FloatType kFireStepGrowth = 1.1;
+  static constexpr FloatType kFireStepShrink = .5;
+  static constexpr FloatType kFireMaxStepFactor = 10;
+  static constexpr FloatType kFireMixing = .1;
+  static constexpr FloatType kFireMixingDecay = .99;
+
   void initVars();
 
+  // The spring force on i from j, or false if they collide.
+  bool springForce(const container_type& pc, size_type i, size_type j,
+                   vec_type& f) const;
+
  public:
   ParticleInteractionHandler();
   ParticleInteractionHandler(const ParticleInteractionHandler<D>& p);
@@ -54,26 +88,60 @@ class ParticleInteractionHandler {
   void forceLimit(FloatType v) { forceConstraint_ = v; }
   FloatType forceLimit() const { return forceConstraint_; }
 
-  void enforceFLimit(Particle<D>& p1) const;
+  void enforceFLimit(container_type& pc, size_type i) const;
 
   void noiseAmplitude(FloatType n) { noiseAmplitude_ = n; }
   FloatType noiseAmplitude() const { return noiseAmplitude_; }
 
-  void addNoise(Particle<D>& p1) const;
+  // The noise is drawn from a counter-based generator, keyed by the seed,
+  // the step, and the two particles, so a layout comes out the same on
+  // every run with the same seed and thread count.
+  void noiseSeed(std::uint64_t s) { noise_.seed(s); }
+  std::uint64_t noiseSeed() const { return noise_.seed(); }
+
+  // Has to be set to the current iteration before the interactions.
+  void noiseStep(std::uint64_t s) { noiseStep_ = s; }
+
+  // Pushes i in a random direction, for its collision with j.
+  void addNoise(container_type& pc, size_type i, size_type j) const;
 
   void ellipseFactors(EllipseFactors ef);
+  const EllipseFactors& ellipseFactors() const { return ellipseFactors_; }
+
+  void interaction(container_type& pc, size_type i, size_type j) const;
+
+  void springRepulsiveInteraction(container_type& pc, size_type i,
+                                  size_type j) const;
+
+  // Only the part of springRepulsiveInteraction(pc, i, j) that acts on i, for
+  // callers that visit each pair from both ends and may only write to i.
+  void springRepulsiveInteractionOn(container_type& pc, size_type i,
+                                    size_type j) const;
+
+  Integrator integrator() const { return integrator_; }
+  void integrator(Integrator i) { integrator_ = i; }
+
+  // The share of the velocity that kVerlet loses every step.
+  FloatType damping() const { return damping_; }
+  void damping(FloatType d) { damping_ = d; }
+
+  // Brings particle i to a halt. Has to be done for the particles that move
+  // whenever the forces change all of a sudden, like when a level gets added.
+  void resetMotion(container_type& pc, size_type i) const {
+    pc.resetMotion(i, kFireMixing);
+  }
 
-  void interaction(Particle<D>& p1, Particle<D>& p2) const;
+  void integrate(container_type& pc, size_type i) const;
 
-  void springRepulsiveInteraction(Particle<D>& p1, Particle<D>& p2) const;
+  void integrate(container_type& pc, size_type i, FloatType t) const;
 
-  void integrate(Particle<D>& p1) const;
+  void integrateFirstOrder(container_type& pc, size_type i, FloatType t) const;
 
-  void integrate(Particle<D>& p1, FloatType t) const;
+  void integrateFirstOrder(container_type& pc, size_type i) const;
 
-  void integrateFirstOrder(Particle<D>& p1, FloatType t) const;
+  void integrateVerlet(container_type& pc, size_type i, FloatType t) const;
 
-  void integrateFirstOrder(Particle<D>& p1) const;
+  void integrateFire(container_type& pc, size_type i, FloatType t) const;
 
   void print(std::ostream& o = std::cout) const;
 
@@ -21,9 +21,10 @@
 #ifndef LGL_LIB_PARTICLE_STATS_H_
 #define LGL_LIB_PARTICLE_STATS_H_
 
+#include <cstddef>
 #include <iostream>
 
-#include "particle.h"
+#include "particle_container.h"
 
 namespace lgl {
 namespace lib {
@@ -54,7 +55,7 @@ class ParticleStats {
       sumTemp_ = ii;
       return *this;
     }
-    const Stats& operator/=(size_type ii) {
+    const Stats& operator/=(std::size_t ii) {
       sumDist_ /= ii;
       sumVel_ /= ii;
       sumTemp_ /= ii;
@@ -73,7 +74,7 @@ class ParticleStats {
   };
 
   Stats stats;
-  size_type particleCtr_;
+  std::size_t particleCtr_;
   size_type iteration2CollectStats;
 
  public:
@@ -82,7 +83,7 @@ class ParticleStats {
 
   void add2Stats_dx(precision d) { stats.sumDist_ += d; }
 
-  void count(size_type c) { particleCtr_ = c; }
+  void count(std::size_t c) { particleCtr_ = c; }
 
   void collectStatsAtIteration(size_type ii) { iteration2CollectStats = ii; }
 
@@ -0,0 +1,339 @@
+#include "repulsion_kernel.h"
+
+#include <cmath>
+#include <type_traits>
+
+#include "fixed_vec.h"
+#include "types.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LGL_REPULSION_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lgl {
+namespace lib {
+
+static_assert(std::is_same<FloatType, float>::value,
+              "The SIMD repulsion kernels assume single precision");
+
+SimdLevel detectSimdLevel() {
+#ifdef LGL_REPULSION_KERNEL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SimdLevel::kAvx512;
+  if (__builtin_cpu_supports("avx2")) return SimdLevel::kAvx2;
+#endif
+  return SimdLevel::kScalar;
+}
+
+// RepulsionBlock
+
+template <Dimension D>
+void RepulsionBlock<D>::clear() {
+  index.clear();
+  for (unsigned int d = 0; d < D; ++d) {
+    x[d].clear();
+    ex[d].clear();
+    f[d].clear();
+  }
+  radius.clear();
+  self.clear();
+  other.clear();
+}
+
+template <Dimension D>
+void RepulsionBlock<D>::append(const ParticleContainer<D>& pc,
+                               const index_type* first, const index_type* last,
+                               const EllipseFactors& ef) {
+  for (; first != last; ++first) {
+    const index_type i = *first;
+    index.push_back(i);
+    for (unsigned int d = 0; d < D; ++d) {
+      x[d].push_back(pc.x(i, d));
+      if (!ef.empty()) ex[d].push_back(pc.x(i, d) * ef[d]);
+      f[d].push_back(0);
+    }
+    radius.push_back(pc.radius(i));
+    const bool anchor = pc.isAnchor(i);
+    self.push_back(anchor ? 0 : 1);
+    other.push_back(anchor ? 2 : 1);
+  }
+}
+
+template <Dimension D>
+void RepulsionBlock<D>::pad() {
+  // Far enough that the squared distance can't pass any interaction test,
+  // yet small enough that it doesn't overflow.
+  const FloatType far_away = 1e18;
+  for (unsigned int d = 0; d < D; ++d) {
+    x[d].resize(index.size() + kPadding, far_away);
+    if (!ex[d].empty()) ex[d].resize(index.size() + kPadding, far_away);
+    f[d].resize(index.size() + kPadding, 0);
+  }
+  radius.resize(index.size() + kPadding, 0);
+  self.resize(index.size() + kPadding, 0);
+  other.resize(index.size() + kPadding, 0);
+}
+
+template <Dimension D>
+void RepulsionBlock<D>::flush(ParticleContainer<D>& pc) const {
+  for (std::size_t ii = 0; ii < index.size(); ++ii) {
+    typename ParticleContainer<D>::vec_type v;
+    bool any = false;
+    for (unsigned int d = 0; d < D; ++d) {
+      v[d] = f[d][ii];
+      any = any || v[d] != 0;
+    }
+    if (any) pc.add2F(index[ii], v);
+  }
+}
+
+template struct RepulsionBlock<k2Dimensions>;
+template struct RepulsionBlock<k3Dimensions>;
+
+namespace {
+
+struct KernelParams {
+  FloatType springConstant;
+  FloatType eqDistance;
+  FloatType eqDistanceSquared;
+};
+
+// Where the particles of a block are for the force computation: the ellipse
+// scaled positions if there are any, the real ones otherwise.
+template <Dimension D>
+const FloatType* forcePositions(const RepulsionBlock<D>& b, unsigned int d) {
+  return b.ex[d].empty() ? b.x[d].data() : b.ex[d].data();
+}
+
+// Reference implementation, one pair at a time. The arithmetic follows
+// ParticleInteractionHandler::interaction and springRepulsiveInteraction.
+template <Dimension D>
+void kernelScalar(const KernelParams& p, RepulsionBlock<D>& a,
+                  RepulsionBlock<D>& b, RepulsionCollisions& collisions) {
+  const bool sameBlock = &a == &b;
+  const std::size_t na = a.size(), nb = b.size();
+  for (std::size_t ii = 0; ii < na; ++ii) {
+    FloatType fi[D] = {};
+    for (std::size_t jj = sameBlock ? ii + 1 : 0; jj < nb; ++jj) {
+      FloatType d2 = 0;
+      for (unsigned int d = 0; d < D; ++d) d2 += sqr(a.x[d][ii] - b.x[d][jj]);
+      if (!(d2 < p.eqDistanceSquared)) continue;
+      if (d2 <= sqr(a.radius[ii] + b.radius[jj])) {
+        collisions.push_back(std::make_pair(ii, jj));
+        continue;
+      }
+      FloatType dx[D];
+      FloatType mag2 = 0;
+      for (unsigned int d = 0; d < D; ++d) {
+        dx[d] = forcePositions(a, d)[ii] - forcePositions(b, d)[jj];
+        mag2 += sqr(dx[d]);
+      }
+      const FloatType mag = std::sqrt(mag2);
+      const FloatType scale = -p.springConstant * (mag - p.eqDistance) / mag;
+      for (unsigned int d = 0; d < D; ++d) {
+        const FloatType f = dx[d] * scale;
+        fi[d] += f * b.other[jj] * a.self[ii];
+        b.f[d][jj] -= f * a.other[ii] * b.self[jj];
+      }
+    }
+    for (unsigned int d = 0; d < D; ++d) a.f[d][ii] += fi[d];
+  }
+}
+
+#ifdef LGL_REPULSION_KERNEL_X86
+
+__attribute__((target("avx2"))) inline float hsum256(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s);
+}
+
+template <Dimension D>
+__attribute__((target("avx2"))) void kernelAvx2(const KernelParams& p,
+                                                RepulsionBlock<D>& a,
+                                                RepulsionBlock<D>& b,
+                                                RepulsionCollisions&
+                                                    collisions) {
+  const bool sameBlock = &a == &b;
+  const bool ellipse = !a.ex[0].empty();
+  const std::size_t na = a.size(), nb = b.size();
+  const __m256 eq2 = _mm256_set1_ps(p.eqDistanceSquared);
+  const __m256 eq = _mm256_set1_ps(p.eqDistance);
+  const __m256 negk = _mm256_set1_ps(-p.springConstant);
+  for (std::size_t ii = 0; ii < na; ++ii) {
+    __m256 xi[D], exi[D], fi[D];
+    for (unsigned int d = 0; d < D; ++d) {
+      xi[d] = _mm256_set1_ps(a.x[d][ii]);
+      exi[d] = _mm256_set1_ps(forcePositions(a, d)[ii]);
+      fi[d] = _mm256_setzero_ps();
+    }
+    const __m256 ri = _mm256_set1_ps(a.radius[ii]);
+    const __m256 selfi = _mm256_set1_ps(a.self[ii]);
+    const __m256 otheri = _mm256_set1_ps(a.other[ii]);
+    for (std::size_t jj = sameBlock ? ii + 1 : 0; jj < nb; jj += 8) {
+      __m256 dx[D];
+      __m256 d2 = _mm256_setzero_ps();
+      for (unsigned int d = 0; d < D; ++d) {
+        dx[d] = _mm256_sub_ps(xi[d], _mm256_loadu_ps(b.x[d].data() + jj));
+        d2 = _mm256_add_ps(d2, _mm256_mul_ps(dx[d], dx[d]));
+      }
+      const __m256 near = _mm256_cmp_ps(d2, eq2, _CMP_LT_OQ);
+      if (!_mm256_movemask_ps(near)) continue;
+      const __m256 rs =
+          _mm256_add_ps(ri, _mm256_loadu_ps(b.radius.data() + jj));
+      const __m256 hit =
+          _mm256_and_ps(near, _mm256_cmp_ps(d2, _mm256_mul_ps(rs, rs),
+                                            _CMP_LE_OQ));
+      if (int bits = _mm256_movemask_ps(hit)) {
+        for (int lane = 0; lane < 8; ++lane) {
+          if (bits & (1 << lane))
+            collisions.push_back(std::make_pair(ii, jj + lane));
+        }
+      }
+      const __m256 act = _mm256_andnot_ps(hit, near);
+      if (!_mm256_movemask_ps(act)) continue;
+      __m256 mag2 = d2;
+      if (ellipse) {
+        mag2 = _mm256_setzero_ps();
+        for (unsigned int d = 0; d < D; ++d) {
+          dx[d] = _mm256_sub_ps(exi[d],
+                                _mm256_loadu_ps(forcePositions(b, d) + jj));
+          mag2 = _mm256_add_ps(mag2, _mm256_mul_ps(dx[d], dx[d]));
+        }
+      }
+      const __m256 mag = _mm256_sqrt_ps(mag2);
+      const __m256 scale =
+          _mm256_div_ps(_mm256_mul_ps(negk, _mm256_sub_ps(mag, eq)), mag);
+      const __m256 otherj = _mm256_loadu_ps(b.other.data() + jj);
+      const __m256 selfj = _mm256_loadu_ps(b.self.data() + jj);
+      for (unsigned int d = 0; d < D; ++d) {
+        const __m256 f = _mm256_and_ps(act, _mm256_mul_ps(dx[d], scale));
+        fi[d] = _mm256_add_ps(fi[d],
+                              _mm256_mul_ps(_mm256_mul_ps(f, otherj), selfi));
+        FloatType* fj = b.f[d].data() + jj;
+        _mm256_storeu_ps(
+            fj, _mm256_sub_ps(_mm256_loadu_ps(fj),
+                              _mm256_mul_ps(_mm256_mul_ps(f, otheri), selfj)));
+      }
+    }
+    for (unsigned int d = 0; d < D; ++d) a.f[d][ii] += hsum256(fi[d]);
+  }
+}
+
+// Some GCC versions warn about the _mm512_undefined_ps() inside their own
+// intrinsics once they are inlined here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+template <Dimension D>
+__attribute__((target("avx512f"))) void kernelAvx512(const KernelParams& p,
+                                                     RepulsionBlock<D>& a,
+                                                     RepulsionBlock<D>& b,
+                                                     RepulsionCollisions&
+                                                         collisions) {
+  const bool sameBlock = &a == &b;
+  const bool ellipse = !a.ex[0].empty();
+  const std::size_t na = a.size(), nb = b.size();
+  const __m512 eq2 = _mm512_set1_ps(p.eqDistanceSquared);
+  const __m512 eq = _mm512_set1_ps(p.eqDistance);
+  const __m512 negk = _mm512_set1_ps(-p.springConstant);
+  for (std::size_t ii = 0; ii < na; ++ii) {
+    __m512 xi[D], exi[D], fi[D];
+    for (unsigned int d = 0; d < D; ++d) {
+      xi[d] = _mm512_set1_ps(a.x[d][ii]);
+      exi[d] = _mm512_set1_ps(forcePositions(a, d)[ii]);
+      fi[d] = _mm512_setzero_ps();
+    }
+    const __m512 ri = _mm512_set1_ps(a.radius[ii]);
+    const __m512 selfi = _mm512_set1_ps(a.self[ii]);
+    const __m512 otheri = _mm512_set1_ps(a.other[ii]);
+    for (std::size_t jj = sameBlock ? ii + 1 : 0; jj < nb; jj += 16) {
+      __m512 dx[D];
+      __m512 d2 = _mm512_setzero_ps();
+      for (unsigned int d = 0; d < D; ++d) {
+        dx[d] = _mm512_sub_ps(xi[d], _mm512_loadu_ps(b.x[d].data() + jj));
+        d2 = _mm512_add_ps(d2, _mm512_mul_ps(dx[d], dx[d]));
+      }
+      const __mmask16 near = _mm512_cmp_ps_mask(d2, eq2, _CMP_LT_OQ);
+      if (!near) continue;
+      const __m512 rs =
+          _mm512_add_ps(ri, _mm512_loadu_ps(b.radius.data() + jj));
+      const __mmask16 hit =
+          _mm512_mask_cmp_ps_mask(near, d2, _mm512_mul_ps(rs, rs), _CMP_LE_OQ);
+      if (hit) {
+        for (int lane = 0; lane < 16; ++lane) {
+          if (hit & (1 << lane))
+            collisions.push_back(std::make_pair(ii, jj + lane));
+        }
+      }
+      const __mmask16 act = near & ~hit;
+      if (!act) continue;
+      __m512 mag2 = d2;
+      if (ellipse) {
+        mag2 = _mm512_setzero_ps();
+        for (unsigned int d = 0; d < D; ++d) {
+          dx[d] = _mm512_sub_ps(exi[d],
+                                _mm512_loadu_ps(forcePositions(b, d) + jj));
+          mag2 = _mm512_add_ps(mag2, _mm512_mul_ps(dx[d], dx[d]));
+        }
+      }
+      const __m512 mag = _mm512_sqrt_ps(mag2);
+      const __m512 scale =
+          _mm512_div_ps(_mm512_mul_ps(negk, _mm512_sub_ps(mag, eq)), mag);
+      const __m512 otherj = _mm512_loadu_ps(b.other.data() + jj);
+      const __m512 selfj = _mm512_loadu_ps(b.self.data() + jj);
+      for (unsigned int d = 0; d < D; ++d) {
+        const __m512 f = _mm512_maskz_mul_ps(act, dx[d], scale);
+        fi[d] = _mm512_add_ps(fi[d],
+                              _mm512_mul_ps(_mm512_mul_ps(f, otherj), selfi));
+        FloatType* fj = b.f[d].data() + jj;
+        _mm512_storeu_ps(
+            fj, _mm512_sub_ps(_mm512_loadu_ps(fj),
+                              _mm512_mul_ps(_mm512_mul_ps(f, otheri), selfj)));
+      }
+    }
+    for (unsigned int d = 0; d < D; ++d)
+      a.f[d][ii] += _mm512_reduce_add_ps(fi[d]);
+  }
+}
+
+#pragma GCC diagnostic pop
+
+#endif  // LGL_REPULSION_KERNEL_X86
+
+}  // namespace
+
+template <Dimension D>
+void repulsionKernel(const ParticleInteractionHandler<D>& ih,
+                     RepulsionBlock<D>& a, RepulsionBlock<D>& b,
+                     RepulsionCollisions& collisions, SimdLevel level) {
+  KernelParams p;
+  p.springConstant = ih.springConstant();
+  p.eqDistance = ih.eqDistance();
+  p.eqDistanceSquared = sqr(p.eqDistance);
+  switch (level) {
+#ifdef LGL_REPULSION_KERNEL_X86
+    case SimdLevel::kAvx512:
+      return kernelAvx512(p, a, b, collisions);
+    case SimdLevel::kAvx2:
+      return kernelAvx2(p, a, b, collisions);
+#endif
+    default:
+      return kernelScalar(p, a, b, collisions);
+  }
+}
+
+template void repulsionKernel<k2Dimensions>(
+    const ParticleInteractionHandler<k2Dimensions>& ih,
+    RepulsionBlock<k2Dimensions>& a, RepulsionBlock<k2Dimensions>& b,
+    RepulsionCollisions& collisions, SimdLevel level);
+
+template void repulsionKernel<k3Dimensions>(
+    const ParticleInteractionHandler<k3Dimensions>& ih,
+    RepulsionBlock<k3Dimensions>& a, RepulsionBlock<k3Dimensions>& b,
+    RepulsionCollisions& collisions, SimdLevel level);
+
+}  // namespace lib
+}  // namespace lgl
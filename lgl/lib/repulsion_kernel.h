@@ -0,0 +1,72 @@
+#ifndef LGL_LIB_REPULSION_KERNEL_H_
+#define LGL_LIB_REPULSION_KERNEL_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "particle_container.h"
+#include "particle_interaction_handler.h"
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+// Which instruction set the repulsion kernel uses.
+enum class SimdLevel { kScalar, kAvx2, kAvx512 };
+
+// The best level the running CPU supports.
+SimdLevel detectSimdLevel();
+
+// The occupants of one or more voxels, copied out of the particle container
+// so the kernel can stream through them. Every array but index is followed
+// by kPadding entries that are too far away to interact with anything, so
+// the SIMD paths can always load whole registers.
+template <Dimension D>
+struct RepulsionBlock {
+  typedef typename ParticleContainer<D>::size_type index_type;
+
+  static const std::size_t kPadding = 16;
+
+  std::vector<index_type> index;
+  std::vector<FloatType> x[D];
+  // Positions scaled by the ellipse factors, empty when there are none.
+  std::vector<FloatType> ex[D];
+  std::vector<FloatType> radius;
+  // Factor for the force a particle receives: 0 for anchors, else 1.
+  std::vector<FloatType> self;
+  // Factor for the force a particle exerts: 2 for anchors, else 1.
+  std::vector<FloatType> other;
+  std::vector<FloatType> f[D];
+
+  void clear();
+
+  void append(const ParticleContainer<D>& pc, const index_type* first,
+              const index_type* last, const EllipseFactors& ef);
+
+  // Has to be called after the last append and before the kernel runs.
+  void pad();
+
+  std::size_t size() const { return index.size(); }
+
+  // Adds the accumulated forces to the particles.
+  void flush(ParticleContainer<D>& pc) const;
+};
+
+// Pairs of block positions that collided. They get noise instead of a force,
+// which is left to the caller since it needs the random number generator.
+typedef std::vector<std::pair<std::size_t, std::size_t>> RepulsionCollisions;
+
+// Applies ParticleInteractionHandler::springRepulsiveInteraction to every
+// pair of a particle in a and one in b that is closer than the handler's
+// eqDistance, accumulating into the f arrays of the blocks. If a and b are
+// the same block each unordered pair is only visited once.
+template <Dimension D>
+void repulsionKernel(const ParticleInteractionHandler<D>& ih,
+                     RepulsionBlock<D>& a, RepulsionBlock<D>& b,
+                     RepulsionCollisions& collisions, SimdLevel level);
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_REPULSION_KERNEL_H_
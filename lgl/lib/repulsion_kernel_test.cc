@@ -0,0 +1,185 @@
+#include "lgl/lib/repulsion_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lgl {
+namespace lib {
+namespace {
+
+typedef std::set<std::pair<std::size_t, std::size_t>> PairSet;
+
+// What the kernel, or the pair by pair reference, did to the particles
+template <Dimension D>
+struct Outcome {
+  std::vector<typename ParticleContainer<D>::vec_type> forces;
+  // The colliding pairs, by particle, the smaller one first
+  PairSet collisions;
+};
+
+void AddPair(PairSet& pairs, std::size_t i, std::size_t j) {
+  pairs.insert(std::make_pair(std::min(i, j), std::max(i, j)));
+}
+
+// count particles in a box of the given side, with some anchors among them
+// and radii big enough for a few collisions
+template <Dimension D>
+ParticleContainer<D> RandomParticles(std::size_t count, FloatType side,
+                                     std::mt19937& rng) {
+  std::uniform_real_distribution<FloatType> position(0, side);
+  std::uniform_real_distribution<FloatType> radius(0, .15);
+  ParticleContainer<D> pc(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    typename ParticleContainer<D>::vec_type x;
+    for (unsigned int d = 0; d < D; ++d) x[d] = position(rng);
+    pc.X(i, x.begin(), x.end());
+    pc.radius(i, radius(rng));
+    if (rng() % 5 == 0) pc.markAnchor(i);
+  }
+  return pc;
+}
+
+template <Dimension D>
+ParticleInteractionHandler<D> Handler(bool withEllipse) {
+  ParticleInteractionHandler<D> ih;
+  ih.springConstant(2);
+  ih.eqDistance(1);
+  if (withEllipse) ih.ellipseFactors(EllipseFactors{1.5, .7, 1.2});
+  return ih;
+}
+
+// The particles [0, split) in one block and the rest in another, or all of
+// them in the same block if split is 0
+template <Dimension D>
+Outcome<D> RunKernel(const ParticleInteractionHandler<D>& ih,
+                     const ParticleContainer<D>& pc, std::size_t split,
+                     SimdLevel level) {
+  std::vector<typename ParticleContainer<D>::size_type> ids(pc.size());
+  for (std::size_t i = 0; i < ids.size(); ++i) ids[i] = i;
+  const std::size_t end = split == 0 ? ids.size() : split;
+  RepulsionBlock<D> a, b;
+  a.append(pc, ids.data(), ids.data() + end, ih.ellipseFactors());
+  a.pad();
+  if (split != 0) {
+    b.append(pc, ids.data() + split, ids.data() + ids.size(),
+             ih.ellipseFactors());
+    b.pad();
+  }
+  RepulsionBlock<D>& other = split == 0 ? a : b;
+  RepulsionCollisions collisions;
+  repulsionKernel(ih, a, other, collisions, level);
+
+  ParticleContainer<D> result(pc);
+  a.flush(result);
+  if (split != 0) b.flush(result);
+  Outcome<D> outcome;
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    outcome.forces.push_back(result.F(i));
+  }
+  for (const auto& c : collisions) {
+    AddPair(outcome.collisions, a.index[c.first], other.index[c.second]);
+  }
+  return outcome;
+}
+
+// The same pairs through ParticleInteractionHandler, one at a time
+template <Dimension D>
+Outcome<D> RunPairs(const ParticleInteractionHandler<D>& ih,
+                    const ParticleContainer<D>& pc, std::size_t split) {
+  ParticleContainer<D> result(pc);
+  Outcome<D> outcome;
+  const FloatType eq2 = ih.eqDistance() * ih.eqDistance();
+  const std::size_t end = split == 0 ? pc.size() : split;
+  for (std::size_t i = 0; i < end; ++i) {
+    for (std::size_t j = std::max(i + 1, split); j < pc.size(); ++j) {
+      if (!(pc.separation2(i, j) < eq2)) continue;
+      if (pc.collisionCheck(i, j)) {
+        AddPair(outcome.collisions, i, j);
+      } else {
+        ih.springRepulsiveInteraction(result, i, j);
+      }
+    }
+  }
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    outcome.forces.push_back(result.F(i));
+  }
+  return outcome;
+}
+
+template <Dimension D>
+void ExpectSameOutcome(const Outcome<D>& expected, const Outcome<D>& actual) {
+  ASSERT_EQ(expected.forces.size(), actual.forces.size());
+  for (std::size_t i = 0; i < expected.forces.size(); ++i) {
+    for (unsigned int d = 0; d < D; ++d) {
+      const FloatType e = expected.forces[i][d];
+      EXPECT_NEAR(e, actual.forces[i][d], 1e-4 * (1 + std::fabs(e)))
+          << "particle " << i << " dimension " << d;
+    }
+  }
+  EXPECT_EQ(expected.collisions, actual.collisions);
+}
+
+// Every level the CPU runs, against the scalar kernel and the reference
+template <Dimension D>
+void CheckLevels(bool withEllipse, std::size_t split, FloatType side) {
+  std::mt19937 rng(D * 100 + withEllipse * 10 + (split != 0));
+  const ParticleContainer<D> pc = RandomParticles<D>(120, side, rng);
+  const ParticleInteractionHandler<D> ih = Handler<D>(withEllipse);
+
+  const Outcome<D> pairs = RunPairs(ih, pc, split);
+  // Or the test would pass on nothing
+  ASSERT_FALSE(pairs.collisions.empty());
+  const Outcome<D> scalar = RunKernel(ih, pc, split, SimdLevel::kScalar);
+  ExpectSameOutcome(pairs, scalar);
+
+  const SimdLevel best = detectSimdLevel();
+  for (SimdLevel level : {SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    if (static_cast<int>(level) > static_cast<int>(best)) continue;
+    SCOPED_TRACE(static_cast<int>(level));
+    const Outcome<D> simd = RunKernel(ih, pc, split, level);
+    ExpectSameOutcome(scalar, simd);
+    ExpectSameOutcome(pairs, simd);
+  }
+}
+
+TEST(RepulsionKernelTest, SameBlock2D) {
+  CheckLevels<k2Dimensions>(false, 0, 6);
+}
+
+TEST(RepulsionKernelTest, TwoBlocks2D) {
+  CheckLevels<k2Dimensions>(false, 53, 6);
+}
+
+TEST(RepulsionKernelTest, SameBlockWithEllipse2D) {
+  CheckLevels<k2Dimensions>(true, 0, 6);
+}
+
+TEST(RepulsionKernelTest, TwoBlocksWithEllipse2D) {
+  CheckLevels<k2Dimensions>(true, 53, 6);
+}
+
+TEST(RepulsionKernelTest, SameBlock3D) {
+  CheckLevels<k3Dimensions>(false, 0, 4);
+}
+
+TEST(RepulsionKernelTest, TwoBlocks3D) {
+  CheckLevels<k3Dimensions>(false, 53, 4);
+}
+
+TEST(RepulsionKernelTest, SameBlockWithEllipse3D) {
+  CheckLevels<k3Dimensions>(true, 0, 4);
+}
+
+TEST(RepulsionKernelTest, TwoBlocksWithEllipse3D) {
+  CheckLevels<k3Dimensions>(true, 53, 4);
+}
+
+}  // namespace
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,241 @@
+#include "spanning_tree.h"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "parallel_chunks.h"
+#include "thread_pool.h"
+
+namespace lgl {
+namespace lib {
+
+namespace {
+
+// Below this a piece isn't worth splitting between the threads
+const std::size_t kSerialSize = 1 << 15;
+// The edges the pivot is the median of
+const std::size_t kPivotSamples = 255;
+
+// The sets of the vertices joined so far
+class DisjointSets {
+ public:
+  explicit DisjointSets(std::size_t n) : parent(n), size(n, 1) {
+    for (std::size_t v = 0; v < n; ++v) parent[v] = v;
+  }
+
+  unsigned int find(unsigned int v) {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  }
+
+  // As find, without shortening the path, so the threads can share it
+  unsigned int root(unsigned int v) const {
+    while (parent[v] != v) v = parent[v];
+    return v;
+  }
+
+  // Joins the sets of u and v, unless they are the same one already.
+  bool join(unsigned int u, unsigned int v) {
+    u = find(u);
+    v = find(v);
+    if (u == v) return false;
+    if (size[u] < size[v]) std::swap(u, v);
+    parent[v] = u;
+    size[u] += size[v];
+    return true;
+  }
+
+ private:
+  std::vector<unsigned int> parent;
+  std::vector<std::size_t> size;
+};
+
+class FilterKruskal {
+ public:
+  FilterKruskal(std::size_t vertexCount, unsigned int threadCount)
+      : sets(vertexCount),
+        vertexCount(vertexCount),
+        threadCount(threadCount),
+        pool(threadCount > 1 ? new thread_pool(threadCount) : 0) {}
+
+  // Adds the edges of [first, last) that join two trees of the forest
+  void run(WeightedEdge* first, WeightedEdge* last);
+
+  std::vector<WeightedEdge> forest;
+
+ private:
+  bool done() const { return forest.size() + 1 >= vertexCount; }
+
+  unsigned int chunksFor(std::size_t count) const {
+    return pool && count >= kSerialSize ? threadCount : 1;
+  }
+
+  // Calls f(c, first, last) for each chunk c of [0, count), in parallel
+  template <typename F>
+  void forChunks(std::size_t count, F f) {
+    lib::forChunks(pool.get(), chunksFor(count), count, f);
+  }
+
+  void sort(WeightedEdge* first, WeightedEdge* last);
+  // Puts the edges no heavier than a pivot first, and returns where the
+  // rest start
+  WeightedEdge* split(WeightedEdge* first, WeightedEdge* last);
+  // Drops the edges within a tree of the forest, and returns the new end
+  WeightedEdge* filter(WeightedEdge* first, WeightedEdge* last);
+  // Takes sorted edges
+  void kruskal(const WeightedEdge* first, const WeightedEdge* last);
+
+  DisjointSets sets;
+  const std::size_t vertexCount;
+  const unsigned int threadCount;
+  std::unique_ptr<thread_pool> pool;
+  std::vector<WeightedEdge> buffer;
+};
+
+void FilterKruskal::run(WeightedEdge* first, WeightedEdge* last) {
+  if (done() || first == last) return;
+  const std::size_t count = last - first;
+  if (count > std::max(kSerialSize, vertexCount)) {
+    WeightedEdge* mid = split(first, last);
+    if (mid != last) {
+      run(first, mid);
+      run(mid, filter(mid, last));
+      return;
+    }
+  }
+  sort(first, last);
+  kruskal(first, last);
+}
+
+void FilterKruskal::sort(WeightedEdge* first, WeightedEdge* last) {
+  const std::size_t count = last - first;
+  forChunks(count, [first](unsigned int, std::size_t a, std::size_t b) {
+    std::sort(first + a, first + b);
+  });
+  const unsigned int chunks = chunksFor(count);
+  if (chunks == 1) return;
+
+  // Merges the sorted runs in pairs, back and forth with the buffer
+  buffer.resize(std::max(buffer.size(), count));
+  std::vector<std::size_t> bounds;
+  for (unsigned int c = 0; c <= chunks; ++c) {
+    bounds.push_back(chunkStart(count, chunks, c));
+  }
+  WeightedEdge* from = first;
+  WeightedEdge* to = buffer.data();
+  while (bounds.size() > 2) {
+    const std::size_t runs = bounds.size() - 1;
+    std::vector<std::size_t> next;
+    std::vector<std::future<void>> futures;
+    for (std::size_t r = 0; r < runs; r += 2) {
+      const std::size_t a = bounds[r], m = bounds[std::min(r + 1, runs)],
+                        b = bounds[std::min(r + 2, runs)];
+      next.push_back(a);
+      futures.push_back(pool->run([=]() {
+        std::merge(from + a, from + m, from + m, from + b, to + a);
+      }));
+    }
+    next.push_back(count);
+    for (auto& fu : futures) fu.get();
+    bounds.swap(next);
+    std::swap(from, to);
+  }
+  if (from != first) {
+    forChunks(count, [from, first](unsigned int, std::size_t a,
+                                   std::size_t b) {
+      std::copy(from + a, from + b, first + a);
+    });
+  }
+}
+
+WeightedEdge* FilterKruskal::split(WeightedEdge* first, WeightedEdge* last) {
+  const std::size_t count = last - first;
+  std::vector<WeightedEdge> samples;
+  for (std::size_t ii = 0; ii < kPivotSamples; ++ii) {
+    samples.push_back(first[count * ii / kPivotSamples]);
+  }
+  std::nth_element(samples.begin(), samples.begin() + kPivotSamples / 2,
+                   samples.end());
+  const WeightedEdge pivot = samples[kPivotSamples / 2];
+
+  // Each chunk goes to the buffer, its light edges after those of the
+  // chunks before it, and its heavy ones after all the light ones
+  const unsigned int chunks = chunksFor(count);
+  std::vector<std::size_t> light(chunks + 1, 0), heavy(chunks + 1, 0);
+  forChunks(count, [&](unsigned int c, std::size_t a, std::size_t b) {
+    std::size_t n = 0;
+    for (std::size_t ii = a; ii < b; ++ii) n += !(pivot < first[ii]);
+    light[c + 1] = n;
+    heavy[c + 1] = b - a - n;
+  });
+  for (unsigned int c = 0; c < chunks; ++c) {
+    light[c + 1] += light[c];
+    heavy[c + 1] += heavy[c];
+  }
+  const std::size_t lightCount = light[chunks];
+  buffer.resize(std::max(buffer.size(), count));
+  WeightedEdge* out = buffer.data();
+  forChunks(count, [&](unsigned int c, std::size_t a, std::size_t b) {
+    WeightedEdge* l = out + light[c];
+    WeightedEdge* h = out + lightCount + heavy[c];
+    for (std::size_t ii = a; ii < b; ++ii) {
+      *(pivot < first[ii] ? h++ : l++) = first[ii];
+    }
+  });
+  forChunks(count, [out, first](unsigned int, std::size_t a, std::size_t b) {
+    std::copy(out + a, out + b, first + a);
+  });
+  return first + lightCount;
+}
+
+WeightedEdge* FilterKruskal::filter(WeightedEdge* first, WeightedEdge* last) {
+  const std::size_t count = last - first;
+  const unsigned int chunks = chunksFor(count);
+  std::vector<std::size_t> kept(chunks);
+  forChunks(count, [&](unsigned int c, std::size_t a, std::size_t b) {
+    WeightedEdge* out = first + a;
+    for (std::size_t ii = a; ii < b; ++ii) {
+      if (sets.root(first[ii].u) != sets.root(first[ii].v)) {
+        *out++ = first[ii];
+      }
+    }
+    kept[c] = out - (first + a);
+  });
+  // Closes the gaps between the chunks
+  WeightedEdge* out = first;
+  for (unsigned int c = 0; c < chunks; ++c) {
+    WeightedEdge* from = first + chunkStart(count, chunks, c);
+    if (out != from) std::copy(from, from + kept[c], out);
+    out += kept[c];
+  }
+  return out;
+}
+
+void FilterKruskal::kruskal(const WeightedEdge* first,
+                            const WeightedEdge* last) {
+  for (; first != last && !done(); ++first) {
+    if (sets.join(first->u, first->v)) forest.push_back(*first);
+  }
+}
+
+}  // namespace
+
+std::vector<WeightedEdge> spanningForest(std::size_t vertexCount,
+                                         std::vector<WeightedEdge>& edges,
+                                         unsigned int threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  FilterKruskal fk(vertexCount, threadCount);
+  fk.run(edges.data(), edges.data() + edges.size());
+  return std::move(fk.forest);
+}
+
+}  // namespace lib
+}  // namespace lgl
@@ -0,0 +1,41 @@
+#ifndef LGL_LIB_SPANNING_TREE_H_
+#define LGL_LIB_SPANNING_TREE_H_
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace lgl {
+namespace lib {
+
+// An edge of the flat arrays spanningForest works on
+struct WeightedEdge {
+  float w;
+  unsigned int u;
+  unsigned int v;
+
+  // By weight, then by the ends, so no two edges tie
+  bool operator<(const WeightedEdge& o) const {
+    return std::tie(w, u, v) < std::tie(o.w, o.u, o.v);
+  }
+};
+
+// The minimum spanning forest of the graph on vertexCount vertices with the
+// given edges, in the order they join it. The edges are taken in the order
+// of WeightedEdge, which leaves no ties, so the forest is the same whatever
+// the order of the edges or the thread count.
+//
+// A filter-Kruskal on threadCount threads, all the cores for 0: the edges
+// are split at a pivot, the forest of the light ones is made first, and the
+// heavy ones that it already joins are filtered out before they are dealt
+// with in turn. Splitting, filtering and sorting the pieces that are small
+// enough to go straight to Kruskal are done in parallel. edges is
+// reordered.
+std::vector<WeightedEdge> spanningForest(std::size_t vertexCount,
+                                         std::vector<WeightedEdge>& edges,
+                                         unsigned int threadCount = 0);
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_SPANNING_TREE_H_
@@ -0,0 +1,103 @@
+#include "lgl/lib/spanning_tree.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lgl {
+namespace lib {
+namespace {
+
+// Plain Kruskal: sorts all the edges and joins them with a union-find
+std::vector<WeightedEdge> SerialKruskal(std::size_t vertexCount,
+                                        std::vector<WeightedEdge> edges) {
+  std::sort(edges.begin(), edges.end());
+  std::vector<unsigned int> parent(vertexCount);
+  for (std::size_t v = 0; v < vertexCount; ++v) parent[v] = v;
+  auto find = [&parent](unsigned int v) {
+    while (parent[v] != v) v = parent[v] = parent[parent[v]];
+    return v;
+  };
+  std::vector<WeightedEdge> forest;
+  for (const WeightedEdge& e : edges) {
+    const unsigned int u = find(e.u), v = find(e.v);
+    if (u == v) continue;
+    parent[u] = v;
+    forest.push_back(e);
+  }
+  return forest;
+}
+
+// Edges between random vertices of [first, first + count), loops and
+// parallel edges included, with few distinct weights so that many tie
+std::vector<WeightedEdge> RandomEdges(unsigned int first, unsigned int count,
+                                      std::size_t edgeCount, int weights,
+                                      std::mt19937& rng) {
+  std::uniform_int_distribution<unsigned int> vertex(first, first + count - 1);
+  std::uniform_int_distribution<int> weight(0, weights - 1);
+  std::vector<WeightedEdge> edges;
+  for (std::size_t ii = 0; ii < edgeCount; ++ii) {
+    edges.push_back(WeightedEdge{static_cast<float>(weight(rng)), vertex(rng),
+                                 vertex(rng)});
+  }
+  return edges;
+}
+
+void ExpectSameForest(const std::vector<WeightedEdge>& expected,
+                      const std::vector<WeightedEdge>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t ii = 0; ii < expected.size(); ++ii) {
+    EXPECT_EQ(expected[ii].w, actual[ii].w) << "edge " << ii;
+    EXPECT_EQ(expected[ii].u, actual[ii].u) << "edge " << ii;
+    EXPECT_EQ(expected[ii].v, actual[ii].v) << "edge " << ii;
+  }
+}
+
+TEST(SpanningForestTest, NoEdges) {
+  std::vector<WeightedEdge> edges;
+  EXPECT_TRUE(spanningForest(0, edges, 1).empty());
+  EXPECT_TRUE(spanningForest(5, edges, 4).empty());
+}
+
+TEST(SpanningForestTest, SmallGraph) {
+  // 0--1--2 with a heavier 0--2, and a loop on 1
+  std::vector<WeightedEdge> edges = {
+      {2, 0, 2}, {1, 1, 2}, {1, 0, 1}, {0, 1, 1}};
+  const std::vector<WeightedEdge> forest = spanningForest(3, edges, 1);
+  ExpectSameForest({{1, 0, 1}, {1, 1, 2}}, forest);
+}
+
+// Big enough that split, filter and the parallel merges of sort all run
+TEST(SpanningForestTest, MatchesKruskalOnEveryThreadCount) {
+  std::mt19937 rng(7);
+  const std::vector<WeightedEdge> edges = RandomEdges(0, 5000, 300000, 10, rng);
+  const std::vector<WeightedEdge> expected = SerialKruskal(5000, edges);
+  EXPECT_EQ(4999u, expected.size());
+  for (unsigned int threads : {1u, 2u, 4u, 7u}) {
+    SCOPED_TRACE(threads);
+    std::vector<WeightedEdge> copy = edges;
+    ExpectSameForest(expected, spanningForest(5000, copy, threads));
+  }
+}
+
+TEST(SpanningForestTest, MatchesKruskalOnAForest) {
+  // Two dense components and some vertices that have no edges at all
+  std::mt19937 rng(11);
+  std::vector<WeightedEdge> edges = RandomEdges(0, 3000, 100000, 3, rng);
+  const std::vector<WeightedEdge> more =
+      RandomEdges(4000, 2000, 100000, 3, rng);
+  edges.insert(edges.end(), more.begin(), more.end());
+  const std::vector<WeightedEdge> expected = SerialKruskal(7000, edges);
+  EXPECT_EQ(2999u + 1999u, expected.size());
+  for (unsigned int threads : {1u, 3u, 8u}) {
+    SCOPED_TRACE(threads);
+    std::vector<WeightedEdge> copy = edges;
+    ExpectSameForest(expected, spanningForest(7000, copy, threads));
+  }
+}
+
+}  // namespace
+}  // namespace lib
+}  // namespace lgl
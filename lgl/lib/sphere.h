@@ -64,19 +64,26 @@ inline bool doIntersect(const Sphere& s1, const Sphere& s2) {
   return d < min;
 }
 
+// The draws of rand() that a random point on a sphere in dimension takes
+inline int drawsPerPoint(int dimension) { return dimension == 3 ? 2 : 1; }
+
+// As uniform_on_sphere_vec, from the given drawsPerPoint(dimension) draws
+// of rand(), so they can be made ahead and the points worked out in any
+// order, on any thread.
 template <typename Vectype>
-inline void uniform_on_sphere_vec(Vectype& v, int dimension) {
+inline void uniform_on_sphere_vec(Vectype& v, int dimension,
+                                  const int* draws) {
   // Assume radius = 1
   typedef typename Vectype::value_type value_type;
   const value_type PI = 3.141592654;
   v.resize(dimension);
   if (dimension == 2) {
-    value_type theta = rand() / (RAND_MAX + 1.0) * 2.0 * PI;
+    value_type theta = draws[0] / (RAND_MAX + 1.0) * 2.0 * PI;
     v.at(0) = cos(theta);  // X
     v.at(1) = sin(theta);  // Y
   } else if (dimension == 3) {
-    value_type theta = 2.0 * PI * rand() / (RAND_MAX + 1.0);
-    value_type phi = acos(1.0 - 2.0 * rand() / (RAND_MAX + 1.0));
+    value_type theta = 2.0 * PI * draws[0] / (RAND_MAX + 1.0);
+    value_type phi = acos(1.0 - 2.0 * draws[1] / (RAND_MAX + 1.0));
     v.at(0) = cos(theta) * sin(phi);  // X
     v.at(1) = sin(theta) * sin(phi);  // Y
     v.at(2) = cos(phi);               // Z
@@ -86,6 +93,13 @@ inline void uniform_on_sphere_vec(Vectype& v, int dimension) {
   }
 }
 
+template <typename Vectype>
+inline void uniform_on_sphere_vec(Vectype& v, int dimension) {
+  int draws[2];
+  for (int ii = 0; ii < drawsPerPoint(dimension); ++ii) draws[ii] = rand();
+  uniform_on_sphere_vec(v, dimension, draws);
+}
+
 inline void randomPointOnSurface(const Sphere& s,
                                  typename Sphere::vec_type& r) {
 #if 1
@@ -106,6 +120,14 @@ inline void randomPointOnSurface(const Sphere& s,
   translate(r.begin(), r.end(), s.location().begin());
 }
 
+// As randomPointOnSurface, from the given draws (see uniform_on_sphere_vec)
+inline void randomPointOnSurface(const Sphere& s, const int* draws,
+                                 typename Sphere::vec_type& r) {
+  uniform_on_sphere_vec(r, s.dimension(), draws);
+  scale(r.begin(), r.end(), s.radius());
+  translate(r.begin(), r.end(), s.location().begin());
+}
+
 }  // namespace lib
 }  // namespace lgl
 
@@ -0,0 +1,54 @@
+//--------------------------------------------------
+// A sense-reversing barrier for a fixed set of threads, requiring C++11
+//--------------------------------------------------
+
+#ifndef LGL_LIB_SPIN_BARRIER_H_
+#define LGL_LIB_SPIN_BARRIER_H_
+
+#include <atomic>
+#include <thread>
+
+namespace lgl {
+namespace lib {
+
+class spin_barrier {
+ public:
+  explicit spin_barrier(unsigned num_threads)
+      : num_threads_(num_threads), waiting_(0), sense_(false) {}
+
+  // spin_barrier is neither copyable nor movable
+  spin_barrier(const spin_barrier &) = delete;
+  spin_barrier &operator=(const spin_barrier &) = delete;
+
+  // Blocks until all num_threads threads have called wait(). Everything a
+  // thread wrote before its call is visible to all of them afterwards.
+  void wait() {
+    // sense_ can't flip before this thread arrives, so this is the value the
+    // last thread of this round will set it to
+    const bool sense = !sense_.load(std::memory_order_relaxed);
+    if (waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 == num_threads_) {
+      waiting_.store(0, std::memory_order_relaxed);
+      sense_.store(sense, std::memory_order_release);
+      return;
+    }
+    // Spin for a bit, as the phases are short, but don't starve the others
+    // when there are more threads than cores.
+    for (unsigned spins = 0; sense_.load(std::memory_order_acquire) != sense;
+         ++spins) {
+      if (spins >= max_spins_) std::this_thread::yield();
+    }
+  }
+
+  unsigned num_threads() const { return num_threads_; }
+
+ private:
+  static constexpr unsigned max_spins_ = 1024;
+  const unsigned num_threads_;
+  std::atomic<unsigned> waiting_;
+  std::atomic<bool> sense_;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_SPIN_BARRIER_H_
@@ -0,0 +1,204 @@
+#include "tree_search.h"
+
+#include <algorithm>
+#include <thread>
+#include <tuple>
+
+#include "parallel_chunks.h"
+
+namespace lgl {
+namespace lib {
+
+namespace {
+
+// Below this a level isn't worth splitting between the threads
+const std::size_t kSerialSize = 1 << 14;
+// When to change direction, as Beamer, Asanovic and Patterson have it: to
+// bottom-up once the frontier has more than 1/14 of the arcs still to look
+// at, and back once it holds less than 1/24 of the vertices. In a tree
+// bottom-up saves no work, as every arc out of the frontier but the one to
+// the parent finds a new vertex, so it is only for splitting a frontier of
+// a few big vertices evenly between the threads.
+const std::size_t kTopDownFactor = 14;
+const std::size_t kBottomUpFactor = 24;
+
+const unsigned kUnreached = -1;
+
+}  // namespace
+
+TreeSearch::TreeSearch(const CsrGraph<FloatType>& tree,
+                       unsigned int threadCount)
+    : tree(tree),
+      threadCount(threadCount == 0
+                      ? std::max(1u, std::thread::hardware_concurrency())
+                      : threadCount),
+      pool(this->threadCount > 1 ? new thread_pool(this->threadCount) : 0),
+      next(this->threadCount),
+      nextArcs(this->threadCount) {}
+
+unsigned int TreeSearch::chunksFor(size_type count) const {
+  return pool && count >= kSerialSize ? threadCount : 1;
+}
+
+template <typename F>
+void TreeSearch::forChunks(size_type count, F f) {
+  lib::forChunks(pool.get(), chunksFor(count), count, f);
+}
+
+void TreeSearch::run(vertex_descriptor source) {
+  const size_type n = tree.vertexCount();
+  levels.assign(n, kUnreached);
+  parents.assign(n, 0);
+  sizes.assign(n, 0);
+  order.clear();
+  levelStarts.assign(1, 0);
+  if (n == 0) return;
+
+  levels[source] = 0;
+  parents[source] = -1;
+  order.push_back(source);
+  levelStarts.push_back(1);
+  // The arcs out of the frontier, and out of the vertices not reached yet
+  size_type frontierArcs = tree.degree(source);
+  size_type unexploredArcs =
+      tree.neighboursEnd(n - 1) - tree.neighboursBegin(0) - frontierArcs;
+  bool up = false;
+  for (unsigned int level = 0;; ++level) {
+    const size_type first = levelStarts[level], last = levelStarts[level + 1];
+    if (pool && !up && frontierArcs > unexploredArcs / kTopDownFactor) {
+      up = true;
+    } else if (up && last - first < n / kBottomUpFactor) {
+      up = false;
+    }
+    for (unsigned int c = 0; c < threadCount; ++c) {
+      next[c].clear();
+      nextArcs[c] = 0;
+    }
+    if (up) {
+      bottomUp(level);
+    } else {
+      topDown(level, first, last);
+    }
+    frontierArcs = 0;
+    for (unsigned int c = 0; c < threadCount; ++c) {
+      order.insert(order.end(), next[c].begin(), next[c].end());
+      frontierArcs += nextArcs[c];
+    }
+    if (order.size() == last) break;
+    unexploredArcs -= frontierArcs;
+    levelStarts.push_back(order.size());
+    if (up) {
+      // Bottom-up reads the levels as it goes, so they are set after
+      forChunks(order.size() - last,
+                [this, last, level](unsigned int, size_type a, size_type b) {
+                  for (size_type ii = last + a; ii < last + b; ++ii) {
+                    levels[order[ii]] = level + 1;
+                  }
+                });
+    }
+  }
+
+  // The subtree sizes, from the deepest level up
+  for (size_type l = levelStarts.size() - 1; l-- > 0;) {
+    const size_type first = levelStarts[l];
+    forChunks(levelStarts[l + 1] - first,
+              [this, first](unsigned int, size_type a, size_type b) {
+                for (size_type ii = first + a; ii < first + b; ++ii) {
+                  const vertex_descriptor v = order[ii];
+                  // The parent's size isn't known yet, so it counts for 0
+                  unsigned int size = 1;
+                  for (const vertex_descriptor* u = tree.neighboursBegin(v);
+                       u != tree.neighboursEnd(v); ++u) {
+                    size += sizes[*u];
+                  }
+                  sizes[v] = size;
+                }
+              });
+  }
+
+  forChunks(n, [this](unsigned int, size_type a, size_type b) {
+    for (size_type v = a; v < b; ++v) {
+      if (levels[v] == kUnreached) levels[v] = 0;
+    }
+  });
+}
+
+void TreeSearch::topDown(unsigned int level, size_type first,
+                         size_type last) {
+  forChunks(last - first, [this, level, first](unsigned int c, size_type a,
+                                               size_type b) {
+    std::vector<vertex_descriptor>& out = next[c];
+    size_type arcs = 0;
+    for (size_type ii = first + a; ii < first + b; ++ii) {
+      const vertex_descriptor v = order[ii];
+      for (const vertex_descriptor* u = tree.neighboursBegin(v);
+           u != tree.neighboursEnd(v); ++u) {
+        if (levels[*u] != kUnreached) continue;
+        levels[*u] = level + 1;
+        parents[*u] = v;
+        out.push_back(*u);
+        arcs += tree.degree(*u);
+      }
+    }
+    nextArcs[c] = arcs;
+  });
+}
+
+void TreeSearch::bottomUp(unsigned int level) {
+  forChunks(tree.vertexCount(), [this, level](unsigned int c, size_type a,
+                                              size_type b) {
+    std::vector<vertex_descriptor>& out = next[c];
+    size_type arcs = 0;
+    for (size_type v = a; v < b; ++v) {
+      if (levels[v] != kUnreached) continue;
+      for (const vertex_descriptor* u = tree.neighboursBegin(v);
+           u != tree.neighboursEnd(v); ++u) {
+        if (levels[*u] != level) continue;
+        parents[v] = *u;
+        out.push_back(v);
+        arcs += tree.degree(v);
+        break;
+      }
+    }
+    nextArcs[c] = arcs;
+  });
+}
+
+TreeSearch::vertex_descriptor TreeSearch::centre() {
+  if (order.empty()) return 0;
+  // The vertices of the source's tree, not of the whole forest
+  const long long n = order.size();
+  std::vector<long long> sums(tree.vertexCount(), 0);
+  long long total = 0;
+  for (size_type l = 0; l + 1 < levelStarts.size(); ++l) {
+    total += l * (levelStarts[l + 1] - levelStarts[l]);
+  }
+  sums[order[0]] = total;
+  for (size_type l = 1; l + 1 < levelStarts.size(); ++l) {
+    const size_type first = levelStarts[l];
+    forChunks(levelStarts[l + 1] - first,
+              [this, first, n, &sums](unsigned int, size_type a, size_type b) {
+                for (size_type ii = first + a; ii < first + b; ++ii) {
+                  const vertex_descriptor v = order[ii];
+                  sums[v] = sums[parents[v]] + n - 2LL * sizes[v];
+                }
+              });
+  }
+
+  // Only two vertices, one the other's parent, can tie
+  auto better = [this, &sums](vertex_descriptor u, vertex_descriptor v) {
+    return std::make_tuple(sums[u], levels[u], u) <
+           std::make_tuple(sums[v], levels[v], v);
+  };
+  std::vector<vertex_descriptor> best(threadCount, order[0]);
+  forChunks(order.size(), [this, &best, &better](unsigned int c, size_type a,
+                                                 size_type b) {
+    for (size_type ii = a; ii < b; ++ii) {
+      if (better(order[ii], best[c])) best[c] = order[ii];
+    }
+  });
+  return *std::min_element(best.begin(), best.end(), better);
+}
+
+}  // namespace lib
+}  // namespace lgl
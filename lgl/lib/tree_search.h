@@ -0,0 +1,78 @@
+#ifndef LGL_LIB_TREE_SEARCH_H_
+#define LGL_LIB_TREE_SEARCH_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "csr_graph.h"
+#include "thread_pool.h"
+#include "types.h"
+
+namespace lgl {
+namespace lib {
+
+// A breadth first search of a forest from one of its vertices, which gives
+// the level and parent of each vertex of its tree and the size of the
+// subtree under it, all from the one pass.
+//
+// It goes a level at a time, each split between the threads. While the
+// frontier is small it works top-down, each frontier vertex taking its
+// unreached neighbours as children. Once the frontier has a good part of
+// the edges left to look at, it goes bottom-up: every unreached vertex looks
+// for its parent in the frontier. In a forest no two frontier vertices
+// share an unreached neighbour, so the threads never write to the same
+// vertex either way.
+class TreeSearch {
+ public:
+  typedef CsrGraph<FloatType>::vertex_descriptor vertex_descriptor;
+  typedef CsrGraph<FloatType>::size_type size_type;
+
+  // tree has to outlive the search. threadCount 0 is all the cores.
+  explicit TreeSearch(const CsrGraph<FloatType>& tree,
+                      unsigned int threadCount = 0);
+
+  void run(vertex_descriptor source);
+
+  // The vertex of the tree of the last source with the least sum of hop
+  // counts to the others, by Ying Wang's (yw1984@stanford.edu) linear time
+  // algorithm: each vertex's sum is its parent's, plus one for every vertex
+  // not under it and less one for every vertex that is. Of two such
+  // vertices, the one nearer the source.
+  vertex_descriptor centre();
+
+  // The hop count of each vertex from the source, 0 for those the search
+  // didn't reach
+  std::vector<unsigned> levels;
+  // The parent of each vertex, -1 for the source and 0 for the unreached
+  std::vector<unsigned> parents;
+  // The vertex count of the subtree under each vertex, itself included, 0
+  // for the unreached
+  std::vector<unsigned> sizes;
+  // The vertices reached, level by level
+  std::vector<vertex_descriptor> order;
+  // Where each level starts in order, and where the last one ends
+  std::vector<size_type> levelStarts;
+
+ private:
+  unsigned int chunksFor(size_type count) const;
+  template <typename F>
+  void forChunks(size_type count, F f);
+
+  // Finds the next level from the one in order at [first, last) into next
+  void topDown(unsigned int level, size_type first, size_type last);
+  void bottomUp(unsigned int level);
+
+  const CsrGraph<FloatType>& tree;
+  const unsigned int threadCount;
+  std::unique_ptr<thread_pool> pool;
+  // The vertices each chunk found for the next level
+  std::vector<std::vector<vertex_descriptor>> next;
+  // The arcs out of them
+  std::vector<size_type> nextArcs;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_TREE_SEARCH_H_
@@ -0,0 +1,236 @@
+#include "lgl/lib/tree_search.h"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lgl {
+namespace lib {
+namespace {
+
+typedef TreeSearch::vertex_descriptor vertex_descriptor;
+typedef CsrGraph<FloatType>::Edge Edge;
+
+// What TreeSearch should find, by a plain queue
+struct SerialSearch {
+  SerialSearch(const CsrGraph<FloatType>& tree, vertex_descriptor source) {
+    const std::size_t n = tree.vertexCount();
+    const unsigned int unreached = -1;
+    levels.assign(n, unreached);
+    parents.assign(n, 0);
+    sizes.assign(n, 0);
+    levels[source] = 0;
+    parents[source] = -1;
+    order.push_back(source);
+    for (std::size_t ii = 0; ii < order.size(); ++ii) {
+      const vertex_descriptor v = order[ii];
+      for (const vertex_descriptor* u = tree.neighboursBegin(v);
+           u != tree.neighboursEnd(v); ++u) {
+        if (levels[*u] != unreached) continue;
+        levels[*u] = levels[v] + 1;
+        parents[*u] = v;
+        order.push_back(*u);
+      }
+    }
+    for (std::size_t ii = order.size(); ii-- > 0;) {
+      const vertex_descriptor v = order[ii];
+      sizes[v] += 1;
+      if (v != source) sizes[parents[v]] += sizes[v];
+    }
+    for (unsigned int& l : levels) {
+      if (l == unreached) l = 0;
+    }
+  }
+
+  // The sum of the hop counts from v to the vertices of its tree
+  static long long DistanceSum(const CsrGraph<FloatType>& tree,
+                               vertex_descriptor v) {
+    const SerialSearch s(tree, v);
+    long long sum = 0;
+    for (vertex_descriptor u : s.order) sum += s.levels[u];
+    return sum;
+  }
+
+  // The vertex of the source's tree with the least DistanceSum, then the
+  // least level, then the least id, trying them all
+  vertex_descriptor Centre(const CsrGraph<FloatType>& tree) const {
+    vertex_descriptor best = order[0];
+    long long bestSum = DistanceSum(tree, best);
+    for (vertex_descriptor v : order) {
+      const long long sum = DistanceSum(tree, v);
+      if (std::make_tuple(sum, levels[v], v) <
+          std::make_tuple(bestSum, levels[best], best)) {
+        best = v;
+        bestSum = sum;
+      }
+    }
+    return best;
+  }
+
+  std::vector<unsigned> levels;
+  std::vector<unsigned> parents;
+  std::vector<unsigned> sizes;
+  std::vector<vertex_descriptor> order;
+};
+
+// Random ids for the vertices of a tree on [0, n) that has the edges of
+// parent(v) to v, for each v but the roots, for which it is v
+CsrGraph<FloatType> Shuffled(std::size_t n, const std::vector<unsigned>& parent,
+                             std::mt19937& rng) {
+  std::vector<vertex_descriptor> id(n);
+  for (std::size_t v = 0; v < n; ++v) id[v] = v;
+  std::shuffle(id.begin(), id.end(), rng);
+  std::vector<Edge> edges;
+  for (std::size_t v = 0; v < n; ++v) {
+    if (parent[v] != v) edges.push_back(Edge(id[parent[v]], id[v]));
+  }
+  return CsrGraph<FloatType>(n, edges, std::vector<FloatType>());
+}
+
+// Each vertex hangs off a random one before it
+CsrGraph<FloatType> RandomTree(std::size_t n, std::mt19937& rng) {
+  std::vector<unsigned> parent(n, 0);
+  for (std::size_t v = 1; v < n; ++v) {
+    parent[v] = std::uniform_int_distribution<unsigned>(0, v - 1)(rng);
+  }
+  return Shuffled(n, parent, rng);
+}
+
+// A path of the given length from vertex 0, then stars at its end
+CsrGraph<FloatType> Broom(std::size_t handle, std::size_t n,
+                          std::mt19937& rng) {
+  std::vector<unsigned> parent(n);
+  parent[0] = 0;
+  for (std::size_t v = 1; v < n; ++v) {
+    parent[v] = v <= handle ? v - 1 : handle - (v % 3 == 0);
+  }
+  return Shuffled(n, parent, rng);
+}
+
+// Two random trees, a path and some lone vertices
+CsrGraph<FloatType> Forest(std::size_t n, std::mt19937& rng) {
+  std::vector<unsigned> parent(n);
+  for (std::size_t v = 0; v < n; ++v) {
+    if (v == 0 || v == n / 2 || v >= n - n / 10) {
+      parent[v] = v;
+    } else if (v < n / 2) {
+      parent[v] = std::uniform_int_distribution<unsigned>(0, v - 1)(rng);
+    } else if (v < n - n / 5) {
+      parent[v] = std::uniform_int_distribution<unsigned>(n / 2, v - 1)(rng);
+    } else {
+      parent[v] = v == n - n / 5 ? v : v - 1;
+    }
+  }
+  return Shuffled(n, parent, rng);
+}
+
+// How to check the centre: against every vertex of the tree, or just its
+// neighbours. On a tree the sum of the hop counts has no local minimum
+// that isn't the global one, so the neighbours are enough, when their sums
+// are cheap.
+enum CentreCheck { kEveryVertex, kNeighbours, kNoCentre };
+
+void ExpectSameSearch(const CsrGraph<FloatType>& tree, vertex_descriptor source,
+                      unsigned int threads, CentreCheck check) {
+  SCOPED_TRACE(threads);
+  const SerialSearch expected(tree, source);
+  TreeSearch search(tree, threads);
+  search.run(source);
+  EXPECT_EQ(expected.levels, search.levels);
+  EXPECT_EQ(expected.parents, search.parents);
+  EXPECT_EQ(expected.sizes, search.sizes);
+
+  // The same vertices level by level, if not in the same order
+  ASSERT_EQ(expected.order.size(), search.order.size());
+  ASSERT_EQ(expected.levels[expected.order.back()] + 2,
+            search.levelStarts.size());
+  for (std::size_t l = 0; l + 1 < search.levelStarts.size(); ++l) {
+    std::vector<vertex_descriptor> level(
+        search.order.begin() + search.levelStarts[l],
+        search.order.begin() + search.levelStarts[l + 1]);
+    for (vertex_descriptor v : level) EXPECT_EQ(l, search.levels[v]);
+  }
+
+  if (check == kEveryVertex) {
+    EXPECT_EQ(expected.Centre(tree), search.centre());
+  } else if (check == kNeighbours) {
+    const vertex_descriptor centre = search.centre();
+    const long long sum = SerialSearch::DistanceSum(tree, centre);
+    for (const vertex_descriptor* u = tree.neighboursBegin(centre);
+         u != tree.neighboursEnd(centre); ++u) {
+      EXPECT_LT(std::make_tuple(sum, expected.levels[centre], centre),
+                std::make_tuple(SerialSearch::DistanceSum(tree, *u),
+                                expected.levels[*u], *u));
+    }
+  }
+}
+
+TEST(TreeSearchTest, SingleVertex) {
+  const CsrGraph<FloatType> tree(1, std::vector<Edge>(),
+                                 std::vector<FloatType>());
+  TreeSearch search(tree, 2);
+  search.run(0);
+  EXPECT_EQ(std::vector<unsigned>(1, 0), search.levels);
+  EXPECT_EQ(std::vector<unsigned>(1, 1), search.sizes);
+  EXPECT_EQ(0u, search.centre());
+}
+
+// Small enough to try every vertex for the centre
+TEST(TreeSearchTest, SmallTrees) {
+  std::mt19937 rng(3);
+  for (int round = 0; round < 10; ++round) {
+    const CsrGraph<FloatType> tree = RandomTree(300, rng);
+    const vertex_descriptor source = rng() % 300;
+    for (unsigned int threads : {1u, 2u, 4u, 7u}) {
+      ExpectSameSearch(tree, source, threads, kEveryVertex);
+    }
+  }
+}
+
+TEST(TreeSearchTest, SmallBrooms) {
+  std::mt19937 rng(5);
+  const CsrGraph<FloatType> tree = Broom(40, 400, rng);
+  for (vertex_descriptor source = 0; source < 400; source += 37) {
+    for (unsigned int threads : {1u, 2u, 4u}) {
+      ExpectSameSearch(tree, source, threads, kEveryVertex);
+    }
+  }
+}
+
+TEST(TreeSearchTest, SmallForest) {
+  std::mt19937 rng(9);
+  const CsrGraph<FloatType> tree = Forest(500, rng);
+  for (vertex_descriptor source = 0; source < 500; source += 23) {
+    for (unsigned int threads : {1u, 2u, 4u}) {
+      ExpectSameSearch(tree, source, threads, kEveryVertex);
+    }
+  }
+}
+
+// Big enough for the levels to be split between the threads, and for the
+// searches to go bottom-up where a frontier has most of the arcs left, as
+// the head of the broom does. Its centre is the head, with too many
+// neighbours to check.
+TEST(TreeSearchTest, LargeTrees) {
+  std::mt19937 rng(13);
+  const CsrGraph<FloatType> random = RandomTree(100000, rng);
+  const CsrGraph<FloatType> broom = Broom(5, 100000, rng);
+  const CsrGraph<FloatType> forest = Forest(100000, rng);
+  for (unsigned int threads : {1u, 2u, 4u, 7u}) {
+    ExpectSameSearch(random, rng() % 100000, threads, kNeighbours);
+    ExpectSameSearch(broom, rng() % 100000, threads, kNoCentre);
+    // Not from a lone vertex, which is its own centre
+    vertex_descriptor source;
+    do {
+      source = rng() % 100000;
+    } while (forest.degree(source) == 0);
+    ExpectSameSearch(forest, source, threads, kNeighbours);
+  }
+}
+
+}  // namespace
+}  // namespace lib
+}  // namespace lgl
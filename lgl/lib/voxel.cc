@@ -9,15 +9,15 @@ namespace lib {
 template <Dimension D>
 void Voxel<D>::copy(const Voxel<D>& v) {
   Cube<D>::operator=(v);
-  mutex = v.mutex;
   index_ = v.index_;
   interactionCtr_ = v.interactionCtr_;
-  occupants = v.occupants;
+  begin_ = v.begin_;
+  end_ = v.end_;
 }
 
 template <Dimension D>
 void Voxel<D>::print(std::ostream& o) const {
-  o << "Vox: " << index_ << "\tOcc: " << occupants.size()
+  o << "Vox: " << index_ << "\tOcc: " << occupancy()
     << "\tCtr: " << interactionCtr_ << '\t';
   Cube<D>::print(o);
 }
@@ -1,62 +1,57 @@
 #ifndef LGL_LIB_VOXEL_H_
 #define LGL_LIB_VOXEL_H_
 
+#include <cstddef>
 #include <iostream>
-#include <unordered_set>
 
 #include "cube.h"
-#include "particle.h"
-#include "pthread_wrapper.h"
+#include "particle_container.h"
 #include "types.h"
 
 namespace lgl {
 namespace lib {
 
+// A voxel doesn't own its occupants. They are a contiguous, sorted range of
+// particle indices in the cell list of the grid, which the grid rebuilds once
+// per iteration (see Grid::countOccupants et al.).
 template <Dimension D>
 class Voxel : public Cube<D> {
- private:
-  using occupant_set_type = typename std::unordered_set<Particle<D>*>;
-
  public:
-  using occupant_type = Particle<D>;
-  using size_type = typename occupant_set_type::size_type;
-  using occupant_iterator = typename occupant_set_type::iterator;
-  using const_occupant_iterator = typename occupant_set_type::const_iterator;
+  // Occupants are particle indices into the ParticleContainer.
+  using occupant_type = typename ParticleContainer<D>::size_type;
+  using size_type = std::size_t;
+  using occupant_iterator = const occupant_type*;
+  using const_occupant_iterator = const occupant_type*;
 
  protected:
   unsigned int index_;
   long interactionCtr_;
-  Amutex mutex;
-  occupant_set_type occupants;
+  const occupant_type* begin_;
+  const occupant_type* end_;
 
  public:
-  Voxel() : Cube<D>(), index_(0), interactionCtr_(0), mutex() {}
+  Voxel() : Cube<D>(), index_(0), interactionCtr_(0), begin_(0), end_(0) {}
 
   Voxel(const Voxel<D>& v) { Voxel<D>::operator=(v); }
 
   unsigned int index() { return index_; }
 
-  int lock() { return mutex.lock(); }
-  int unlock() { return mutex.unlock(); }
-  int trylock() { return mutex.trylock(); }
-
-  occupant_iterator begin() { return occupants.begin(); }
-  occupant_iterator end() { return occupants.end(); }
-  const_occupant_iterator begin() const { return occupants.begin(); }
-  const_occupant_iterator end() const { return occupants.end(); }
+  const_occupant_iterator begin() const { return begin_; }
+  const_occupant_iterator end() const { return end_; }
 
-  typename occupant_set_type::size_type occupancy() const {
-    return occupants.size();
-  }
+  size_type occupancy() const { return end_ - begin_; }
 
   long interactionCtr() const { return interactionCtr_; }
 
-  bool empty() const { return occupants.empty(); }
+  bool empty() const { return begin_ == end_; }
 
   void index(unsigned int i) { index_ = i; }
 
-  void insert(Particle<D>& o) { occupants.insert(&o); }
-  void remove(Particle<D>& o) { occupants.erase(&o); }
+  // Only the grid should set this, when it rebuilds its cell list.
+  void occupants(const occupant_type* b, const occupant_type* e) {
+    begin_ = b;
+    end_ = e;
+  }
 
   void incInteractionCtr(long i = 1) { interactionCtr_ += i; }
   void interactionCtr(long i) { interactionCtr_ = i; }
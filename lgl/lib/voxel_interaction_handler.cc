@@ -10,7 +10,9 @@ void VoxelInteractionHandler<D>::initVars() {
   current = 0;
   nbhr = 0;
   ih = 0;
+  pc = 0;
   id_ = 0;
+  simdLevel_ = detectSimdLevel();
 }
 
 template <Dimension D>
@@ -29,46 +31,91 @@ void VoxelInteractionHandler<D>::copy(const VoxelInteractionHandler<D>& v) {
   current = v.current;
   nbhr = v.nbhr;
   ih = v.ih;
+  pc = v.pc;
   id_ = v.id_;
+  simdLevel_ = v.simdLevel_;
 }
 
 template <Dimension D>
-void VoxelInteractionHandler<D>::twoVoxelInteractions() const {
+void VoxelInteractionHandler<D>::gather(RepulsionBlock<D>& block,
+                                        const Voxel<D>& v) const {
+  block.append(*pc, v.begin(), v.end(), ih->ellipseFactors());
+}
+
+template <Dimension D>
+void VoxelInteractionHandler<D>::run(RepulsionBlock<D>& a,
+                                     RepulsionBlock<D>& b) {
+  collisions_.clear();
+  repulsionKernel(*ih, a, b, collisions_, simdLevel_);
+  // Colliding particles get pushed apart by noise, just like in
+  // ParticleInteractionHandler::springRepulsiveInteraction.
+  for (std::size_t ii = 0; ii < collisions_.size(); ++ii) {
+    const std::size_t i = a.index[collisions_[ii].first];
+    const std::size_t j = b.index[collisions_[ii].second];
+    const bool p1anchor = pc->isAnchor(i), p2anchor = pc->isAnchor(j);
+    if (!p1anchor) ih->addNoise(*pc, i, j);
+    if (!p2anchor || p1anchor) ih->addNoise(*pc, j, i);
+  }
+}
+
+template <Dimension D>
+void VoxelInteractionHandler<D>::twoVoxelInteractions() {
   VoxelInteractionHandler<D>::twoVoxelInteractions(*current, *nbhr);
 }
 
 template <Dimension D>
 void VoxelInteractionHandler<D>::twoVoxelInteractions(Voxel<D>& v1,
-                                                      Voxel<D>& v2) const {
+                                                      Voxel<D>& v2) {
   // This doesn't do an occupancy check since that should have been done
   // already.
   if (v1.index() == v2.index()) {
     return VoxelInteractionHandler<D>::sameVoxelInteractions(v1);
-  } else {
-    for (occupant_iterator ii = v1.begin(); ii != v1.end(); ++ii) {
-      for (occupant_iterator jj = v2.begin(); jj != v2.end(); ++jj) {
-        ih->interaction(*(*ii), *(*jj));
-      }
-    }
   }
+  home_.clear();
+  gather(home_, v1);
+  home_.pad();
+  nbhd_.clear();
+  gather(nbhd_, v2);
+  nbhd_.pad();
+  run(home_, nbhd_);
+  home_.flush(*pc);
+  nbhd_.flush(*pc);
 }
 
 template <Dimension D>
-void VoxelInteractionHandler<D>::sameVoxelInteractions() const {
+void VoxelInteractionHandler<D>::sameVoxelInteractions() {
   VoxelInteractionHandler<D>::sameVoxelInteractions(*current);
 }
 
 template <Dimension D>
-void VoxelInteractionHandler<D>::sameVoxelInteractions(Voxel<D>& v1) const {
+void VoxelInteractionHandler<D>::sameVoxelInteractions(Voxel<D>& v1) {
   if (v1.occupancy() < 2) {
     return;
   }
-  for (occupant_iterator ii = v1.begin(); ii != v1.end(); ++ii) {
-    occupant_iterator current = ii;
-    for (occupant_iterator jj = ++current; jj != v1.end(); ++jj) {
-      ih->interaction(*(*ii), *(*jj));
-    }
+  home_.clear();
+  gather(home_, v1);
+  home_.pad();
+  run(home_, home_);
+  home_.flush(*pc);
+}
+
+template <Dimension D>
+void VoxelInteractionHandler<D>::nbhdInteractions(Voxel<D>& v1,
+                                                  Voxel<D>* const* nbhrs,
+                                                  int n) {
+  if (v1.empty()) return;
+  home_.clear();
+  gather(home_, v1);
+  home_.pad();
+  nbhd_.clear();
+  for (int ii = 0; ii < n; ++ii) {
+    if (nbhrs[ii]->index() != v1.index()) gather(nbhd_, *nbhrs[ii]);
   }
+  nbhd_.pad();
+  if (home_.size() > 1) run(home_, home_);
+  if (nbhd_.size() > 0) run(home_, nbhd_);
+  home_.flush(*pc);
+  nbhd_.flush(*pc);
 }
 
 template <Dimension D>
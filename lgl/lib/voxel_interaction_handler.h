@@ -4,6 +4,8 @@
 #include <iostream>
 
 #include "particle_interaction_handler.h"
+#include "pthread_wrapper.h"
+#include "repulsion_kernel.h"
 #include "types.h"
 #include "voxel.h"
 
@@ -19,11 +21,22 @@ class VoxelInteractionHandler {
   Voxel<D>* current;
   Voxel<D>* nbhr;
   ParticleInteractionHandler<D>* ih;
+  ParticleContainer<D>* pc;
   int id_;
   Amutex mutex;
+  SimdLevel simdLevel_;
+  // Scratch space for the repulsion kernel
+  RepulsionBlock<D> home_;
+  RepulsionBlock<D> nbhd_;
+  RepulsionCollisions collisions_;
 
   void initVars();
 
+  void gather(RepulsionBlock<D>& block, const Voxel<D>& v) const;
+
+  // Runs the kernel over a and b and deals with the collisions it found.
+  void run(RepulsionBlock<D>& a, RepulsionBlock<D>& b);
+
  public:
   VoxelInteractionHandler();
 
@@ -37,6 +50,9 @@ class VoxelInteractionHandler {
   void interactionHandler(ParticleInteractionHandler<D>& i) { ih = &i; }
   ParticleInteractionHandler<D>& interactionHandler() const { return *ih; }
 
+  void particleContainer(ParticleContainer<D>& p) { pc = &p; }
+  ParticleContainer<D>& particleContainer() const { return *pc; }
+
   void currentVoxel(Voxel<D>& v) { current = &v; }
   Voxel<D>& currentVoxel() { return *current; }
 
@@ -46,13 +62,21 @@ class VoxelInteractionHandler {
   void id(int i) { id_ = i; }
   int id() const { return id_; }
 
-  void twoVoxelInteractions() const;
+  void simdLevel(SimdLevel l) { simdLevel_ = l; }
+  SimdLevel simdLevel() const { return simdLevel_; }
+
+  void twoVoxelInteractions();
+
+  void twoVoxelInteractions(Voxel<D>& v1, Voxel<D>& v2);
 
-  void twoVoxelInteractions(Voxel<D>& v1, Voxel<D>& v2) const;
+  void sameVoxelInteractions();
 
-  void sameVoxelInteractions() const;
+  void sameVoxelInteractions(Voxel<D>& v1);
 
-  void sameVoxelInteractions(Voxel<D>& v1) const;
+  // All the interactions of v1 with itself and with the n voxels in nbhrs,
+  // which may include v1 again. Cheaper than going voxel pair by voxel pair
+  // because the kernel gets longer runs of partners.
+  void nbhdInteractions(Voxel<D>& v1, Voxel<D>* const* nbhrs, int n);
 
   void print(std::ostream& o = std::cout) const;
 
@@ -0,0 +1,87 @@
+#include "work_queue.h"
+
+#include <algorithm>
+
+namespace lgl {
+namespace lib {
+
+void WorkQueue::build(const std::vector<size_type>& weights,
+                      unsigned int threadCount) {
+  items_.clear();
+  size_type total = 0;
+  for (size_type ii = 0; ii < weights.size(); ++ii) {
+    if (weights[ii] == 0) continue;
+    items_.push_back(ii);
+    total += weights[ii];
+  }
+
+  // Consecutive items, up to about the target weight each. A single item
+  // that is heavier makes a chunk of its own.
+  const size_type target =
+      std::max<size_type>(1, total / (threadCount * kChunksPerThread));
+  std::vector<Chunk> chunks;
+  Chunk c = {0, 0, 0};
+  for (size_type ii = 0; ii < items_.size(); ++ii) {
+    c.weight += weights[items_[ii]];
+    c.end = ii + 1;
+    if (c.weight >= target) {
+      chunks.push_back(c);
+      c.begin = c.end;
+      c.weight = 0;
+    }
+  }
+  if (c.end > c.begin) chunks.push_back(c);
+  std::stable_sort(chunks.begin(), chunks.end(),
+                   [](const Chunk& a, const Chunk& b) {
+                     return a.weight > b.weight;
+                   });
+
+  // Dealt out like cards, so every thread starts with its share of the
+  // heavy ones
+  if (dequeCount_ != threadCount) {
+    deques_.reset(new Deque[threadCount]);
+    dequeCount_ = threadCount;
+  }
+  chunks_.clear();
+  chunks_.reserve(chunks.size());
+  for (unsigned int t = 0; t < threadCount; ++t) {
+    const size_type head = chunks_.size();
+    for (size_type ii = t; ii < chunks.size(); ii += threadCount) {
+      chunks_.push_back(chunks[ii]);
+    }
+    deques_[t].range.store(pack(head, chunks_.size()),
+                           std::memory_order_relaxed);
+  }
+}
+
+bool WorkQueue::take(unsigned int t, bool fromHead, const Chunk*& c) {
+  std::atomic<std::uint64_t>& range = deques_[t].range;
+  std::uint64_t r = range.load(std::memory_order_relaxed);
+  while (true) {
+    const std::uint64_t head = r >> 32, tail = r & 0xffffffffu;
+    if (head >= tail) return false;
+    const std::uint64_t taken = fromHead ? head : tail - 1;
+    const std::uint64_t rest = fromHead ? pack(head + 1, tail)
+                                        : pack(head, tail - 1);
+    if (range.compare_exchange_weak(r, rest, std::memory_order_relaxed)) {
+      c = &chunks_[taken];
+      return true;
+    }
+  }
+}
+
+bool WorkQueue::next(unsigned int whichThread, const size_type*& first,
+                     const size_type*& last) {
+  const Chunk* c = 0;
+  bool found = take(whichThread, true, c);
+  for (unsigned int ii = 1; !found && ii < dequeCount_; ++ii) {
+    found = take((whichThread + ii) % dequeCount_, false, c);
+  }
+  if (!found) return false;
+  first = items_.data() + c->begin;
+  last = items_.data() + c->end;
+  return true;
+}
+
+}  // namespace lib
+}  // namespace lgl
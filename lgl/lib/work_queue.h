@@ -0,0 +1,68 @@
+#ifndef LGL_LIB_WORK_QUEUE_H_
+#define LGL_LIB_WORK_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lgl {
+namespace lib {
+
+// Hands out the items of a parallel phase to the threads in chunks, with
+// work stealing. The items are cut into chunks of about equal estimated work,
+// keeping their order within a chunk, and the chunks are dealt out to the
+// threads heaviest first. Each thread works through its own chunks from the
+// heavy end, and once it runs out takes the lightest chunks left of the
+// others, so one thread stuck with a crowded region doesn't hold up the rest.
+class WorkQueue {
+ public:
+  typedef std::size_t size_type;
+
+  // Sets up the chunks for threadCount threads, weights[i] being the
+  // estimated work of item i. Items of weight 0 are left out. Not thread
+  // safe, and no thread may be taking chunks meanwhile.
+  void build(const std::vector<size_type>& weights, unsigned int threadCount);
+
+  // Takes the next chunk for thread whichThread, which are the items
+  // [first, last). Returns false once there are none left, its own or
+  // anybody else's.
+  bool next(unsigned int whichThread, const size_type*& first,
+            const size_type*& last);
+
+ private:
+  static const size_type kChunksPerThread = 8;
+
+  struct Chunk {
+    size_type begin;
+    size_type end;
+    size_type weight;
+  };
+
+  // The chunks [head, tail) of a thread, packed into one word so the owner
+  // and the thieves can take from either end with a single CAS. Padded to
+  // keep the threads off each other's cache lines.
+  struct Deque {
+    std::atomic<std::uint64_t> range;
+    char pad[64 - sizeof(std::atomic<std::uint64_t>)];
+  };
+
+  static std::uint64_t pack(std::uint64_t head, std::uint64_t tail) {
+    return head << 32 | tail;
+  }
+
+  // Takes the chunk at the head (owner) or the tail (thief) of deque t.
+  bool take(unsigned int t, bool fromHead, const Chunk*& c);
+
+  std::vector<size_type> items_;
+  // The chunks, those of each thread together
+  std::vector<Chunk> chunks_;
+  std::unique_ptr<Deque[]> deques_;
+  unsigned int dequeCount_ = 0;
+};
+
+}  // namespace lib
+}  // namespace lgl
+
+#endif  // LGL_LIB_WORK_QUEUE_H_
@@ -1,6 +1,7 @@
 #ifndef LGL_LIB_V2_CONFIG_H_
 #define LGL_LIB_V2_CONFIG_H_
 
+#include <cstdint>
 #include <string>
 
 namespace lgl {
@@ -30,6 +31,9 @@ struct LGLConfig {
   float placement_distance;
   float placement_radius;
   bool place_leaves_close;
+  // For everything random. The same seed and thread count give the same
+  // layout.
+  std::uint64_t seed;
 };
 
 }  // namespace lib_v2
@@ -1,13 +1,17 @@
 #include "lgl/lib_v2/io.h"
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 #include "glog/logging.h"
 #include "external/com_google_absl/absl/status/statusor.h"
-#include "third_party/fast_cpp_csv_parser/csv.h"
+#include "lgl/lib/binary_graph.h"
+#include "lgl/lib/graph_parser.h"
 
 using absl::StatusOr;
+using lgl::lib::BinaryGraph;
+using lgl::lib::ParsedGraph;
 using absl::string_view;
 using std::string;
 using std::unique_ptr;
@@ -16,7 +20,10 @@ namespace lgl {
 namespace lib_v2 {
 
 StatusOr<unique_ptr<LargeGraph>> ReadGraph(string_view file_name) {
-  if (file_name.length() > 3 &&
+  if (file_name.length() > 4 &&
+      file_name.substr(file_name.length() - 4).compare("lglb") == 0) {
+    return ReadGraphBinary(file_name);
+  } else if (file_name.length() > 3 &&
       file_name.substr(file_name.length() - 3).compare("lgl") == 0) {
     return ReadGraphLGL(file_name);
   } else if (file_name.length() > 4 &&
@@ -28,61 +35,64 @@ StatusOr<unique_ptr<LargeGraph>> ReadGraph(string_view file_name) {
   }
 }
 
-StatusOr<unique_ptr<LargeGraph>> ReadGraphLGL(string_view file_name) {
-  try {
-    io::LineReader reader(file_name.data());
-    unique_ptr<LargeGraph> graph = absl::make_unique<LargeGraph>();
+namespace {
 
-    string_view line;
-    string_view source;
-    while (char* line_ptr = reader.next_line()) {
-      line = string_view(line_ptr);
-      if (line.empty()) {
-        return absl::InvalidArgumentError(
-            "empty line found before end of file");
-      }
-
-      if (line.length() > 2 && line.substr(0, 2).compare("# ") == 0) {
-        source = string(line.substr(2).data());
-        if (source.empty()) {
-          return absl::InvalidArgumentError(
-              absl::StrCat("invalid source node: ", line));
-        }
-      } else {
-        graph->AddEdge(source, line);
-      }
+// Puts the edges of a parsed file into a new graph, in the order of the
+// file.
+unique_ptr<LargeGraph> FromParsed(const ParsedGraph& parsed) {
+  unique_ptr<LargeGraph> graph = absl::make_unique<LargeGraph>();
+  for (const ParsedGraph::Edge& edge : parsed.edges) {
+    graph->AddEdge(parsed.ids[edge.first], parsed.ids[edge.second]);
+    LOG_EVERY_N(INFO, 1e6)
+        << "Building graph: " << google::COUNTER << " edges added";
+  }
+  return graph;
+}
 
-      LOG_EVERY_N(INFO, 1e6)
-          << "Reading LGL: " << google::COUNTER << " lines read";
+}  // namespace
 
-      if (source.empty()) {
-        return absl::InvalidArgumentError(
-            "target node found before a source node");
-      }
-    }
-    return graph;
-  } catch (io::error::base& e) {
-    return absl::UnknownError(e.what());
+StatusOr<unique_ptr<LargeGraph>> ReadGraphLGL(string_view file_name) {
+  ParsedGraph parsed;
+  try {
+    lgl::lib::parseLGL(string(file_name).c_str(), parsed);
+  } catch (std::runtime_error& e) {
+    return absl::InvalidArgumentError(e.what());
   }
+  return FromParsed(parsed);
 }
 
 StatusOr<unique_ptr<LargeGraph>> ReadGraphNCOL(string_view file_name) {
+  ParsedGraph parsed;
+  try {
+    lgl::lib::parseNCOL(string(file_name).c_str(), parsed);
+  } catch (std::runtime_error& e) {
+    return absl::InvalidArgumentError(e.what());
+  }
+  return FromParsed(parsed);
+}
+
+StatusOr<unique_ptr<LargeGraph>> ReadGraphBinary(string_view file_name) {
+  BinaryGraph binary;
   try {
-    io::CSVReader<2, io::trim_chars<' '>, io::no_quote_escape<' '>,
-                  io::throw_on_overflow, io::no_comment>
-        reader(file_name.data());
-    unique_ptr<LargeGraph> graph = absl::make_unique<LargeGraph>();
-    string source;
-    string target;
-    while (reader.read_row(source, target)) {
-      graph->AddEdge(source, target);
-      LOG_EVERY_N(INFO, 1e6)
-          << "Reading NCOL: " << google::COUNTER << " lines read";
+    binary.open(string(file_name).c_str());
+  } catch (std::runtime_error& e) {
+    return absl::InvalidArgumentError(e.what());
+  }
+  unique_ptr<LargeGraph> graph = absl::make_unique<LargeGraph>();
+  for (BinaryGraph::size_type v = 0; v < binary.vertexCount(); ++v) {
+    const string_view source(binary.id(v), binary.idLength(v));
+    for (const BinaryGraph::vertex_type* u = binary.neighboursBegin(v);
+         u != binary.neighboursEnd(v); ++u) {
+      // Each edge once. Loops too, which AddEdge drops, so that a vertex
+      // with nothing but a loop is still added, as by the text readers.
+      if (*u >= v) {
+        graph->AddEdge(source, string_view(binary.id(*u), binary.idLength(*u)));
+      }
     }
-    return graph;
-  } catch (io::error::base& e) {
-    return absl::UnknownError(e.what());
+    LOG_EVERY_N(INFO, 1e6)
+        << "Reading binary: " << google::COUNTER << " nodes read";
   }
+  return graph;
 }
 
 }  // namespace lib_v2
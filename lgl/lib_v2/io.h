@@ -11,7 +11,9 @@
 namespace lgl {
 namespace lib_v2 {
 
-// Reads a graph, inferring its format from the file extension.
+// Reads a graph, inferring its format from the file extension. The text
+// formats are parsed on all cores (see lgl/lib/graph_parser.h); weights are
+// not read.
 absl::StatusOr<std::unique_ptr<LargeGraph>> ReadGraph(
     absl::string_view file_name);
 
@@ -34,6 +36,12 @@ absl::StatusOr<std::unique_ptr<LargeGraph>> ReadGraphLGL(
 absl::StatusOr<std::unique_ptr<LargeGraph>> ReadGraphNCOL(
     absl::string_view file_name);
 
+// Reads a graph in the binary format written by lglfileconvert, with the
+// extension lglb. The file is mapped into memory rather than parsed; see
+// lgl/lib/binary_graph.h for the layout. The weights are not read.
+absl::StatusOr<std::unique_ptr<LargeGraph>> ReadGraphBinary(
+    absl::string_view file_name);
+
 // TODO(alex-kennedy): Write
 absl::Status WriteLGL(const LargeGraph& graph);
 
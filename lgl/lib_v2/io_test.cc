@@ -2,12 +2,16 @@
 
 #include <glog/logging.h>
 
+#include <fstream>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "external/com_google_absl/absl/status/statusor.h"
 #include "external/com_google_absl/absl/strings/string_view.h"
 #include "external/com_google_googletest/googlemock/include/gmock/gmock.h"
 #include "external/com_google_googletest/googletest/include/gtest/gtest.h"
+#include "lgl/lib/binary_graph.h"
 
 namespace lgl {
 namespace lib_v2 {
@@ -29,5 +33,73 @@ TEST(IOTest, ReadGraphNCOL) {
   }
 }
 
+TEST(IOTest, ReadGraphLGLSplitsAtHeaders) {
+  const std::string file_name = testing::TempDir() + "/read_graph.lgl";
+  {
+    std::ofstream out(file_name);
+    out << "# a\nb\nc 0.5\n\n# b\nc\n# d\na\n";
+  }
+  absl::StatusOr<std::unique_ptr<LargeGraph>> graph_or =
+      ReadGraphLGL(file_name);
+  if (!graph_or.ok()) {
+    FAIL() << graph_or.status();
+  }
+  EXPECT_EQ(graph_or.value()->NodeCount(), 4);
+  EXPECT_EQ(graph_or.value()->IdFromName("d").value(), 3);
+}
+
+TEST(IOTest, ReadGraphLGLNeedsSource) {
+  const std::string file_name = testing::TempDir() + "/no_source.lgl";
+  {
+    std::ofstream out(file_name);
+    out << "b\n# a\nb\n";
+  }
+  EXPECT_FALSE(ReadGraphLGL(file_name).ok());
+}
+
+TEST(IOTest, ReadGraphBinary) {
+  // a - b - c, and a self loop on c
+  const std::string file_name = testing::TempDir() + "/read_graph.lglb";
+  lgl::lib::BinaryGraph::write(file_name.c_str(), {0, 1, 3, 5}, {1, 0, 2, 1, 2},
+                               {}, {"a", "b", "c"});
+  absl::StatusOr<std::unique_ptr<LargeGraph>> graph_or =
+      ReadGraph(file_name);
+  if (!graph_or.ok()) {
+    FAIL() << graph_or.status();
+  }
+  EXPECT_EQ(graph_or.value()->NodeCount(), 3);
+  EXPECT_TRUE(graph_or.value()->IdFromName("c").ok());
+}
+
+TEST(IOTest, ReadGraphBinaryKeepsVerticesWithOnlyALoop) {
+  // a - b, and c with nothing but a loop, as text and as binary
+  const std::string text_name = testing::TempDir() + "/loop_only.lgl";
+  {
+    std::ofstream out(text_name);
+    out << "# a\nb\n# c\nc\n";
+  }
+  const std::string binary_name = testing::TempDir() + "/loop_only.lglb";
+  lgl::lib::BinaryGraph::write(binary_name.c_str(), {0, 1, 2, 3}, {1, 0, 2},
+                               {}, {"a", "b", "c"});
+  absl::StatusOr<std::unique_ptr<LargeGraph>> text_or = ReadGraph(text_name);
+  absl::StatusOr<std::unique_ptr<LargeGraph>> binary_or =
+      ReadGraph(binary_name);
+  if (!text_or.ok()) {
+    FAIL() << text_or.status();
+  }
+  if (!binary_or.ok()) {
+    FAIL() << binary_or.status();
+  }
+  EXPECT_EQ(text_or.value()->NodeCount(), 3);
+  EXPECT_EQ(binary_or.value()->NodeCount(), 3);
+  EXPECT_TRUE(binary_or.value()->IdFromName("c").ok());
+}
+
+TEST(IOTest, ReadGraphBinaryRejectsText) {
+  absl::StatusOr<std::unique_ptr<LargeGraph>> graph_or =
+      ReadGraphBinary("/workspaces/LGL/lgl/t/edges.ncol");
+  EXPECT_FALSE(graph_or.ok());
+}
+
 }  // namespace lib_v2
 }  // namespace lgl